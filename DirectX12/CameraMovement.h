@@ -92,7 +92,7 @@ private:
 			float totalPitch = 65.0f * mouseY / height + rightStickYAxis * -Thumb_Speed;
 			GW::MATH::GMATRIXF pitch;
 			GW::MATH::GMatrix::RotationYawPitchRollF(0, G_DEGREE_TO_RADIAN_F(totalPitch), 0, pitch);
-			GW::MATH::GMatrix::MultiplyMatrixF(pitch, mCameraMatrix, mCameraMatrix);
+			SIMD_MATH::MultiplyMatrix(pitch, mCameraMatrix, mCameraMatrix);
 		
 			float totalYaw = 65.0f * mAspectRatio * mouseX / width + rightStickXAxis * Thumb_Speed;
 			GW::MATH::GMATRIXF yaw;
@@ -100,7 +100,7 @@ private:
 			GW::MATH::GMatrix::RotationYawPitchRollF(G_DEGREE_TO_RADIAN_F(totalYaw), 0, 0, yaw);
 
 			GW::MATH::GVECTORF camPos = mCameraMatrix.row4;
-			GW::MATH::GMatrix::MultiplyMatrixF(mCameraMatrix, yaw, mCameraMatrix);
+			SIMD_MATH::MultiplyMatrix(mCameraMatrix, yaw, mCameraMatrix);
 			mCameraMatrix.row4 = camPos;
 		}
 	}
@@ -19,15 +19,11 @@ cbuffer SCENE_DATA : register(b0, space0)
     matrix viewProjection;
 };
 
-cbuffer MESH_DATA : register(b1, space0)
-{
-    unsigned int materialIndex;
-    unsigned int transformIndexStart;
-};
-
 StructuredBuffer<OBJ_ATTRIBUTES> materials : register(t0, space0);
 
-float4 main(float4 posH : SV_POSITION, float3 posW : WORLD, float3 normW : NORMAL) : SV_TARGET
+// Material and tint come from the instance record the vertex shader read
+float4 main(float4 posH : SV_POSITION, float3 posW : WORLD, float3 normW : NORMAL,
+    nointerpolation unsigned int materialIndex : MATERIAL, nointerpolation float4 tint : TINT) : SV_TARGET
 {
     float4 surfaceNormal = normalize(vector(normW, 0));
     float4 dirToLight = -(normalize(sunDirection));
@@ -44,7 +40,7 @@ float4 main(float4 posH : SV_POSITION, float3 posW : WORLD, float3 normW : NORMA
     float intensity = max(pow(base, materials[materialIndex].Ns + 0.000001f), 0);
     float3 specular = sunColor.rgb * materials[materialIndex].Ks * intensity;
 
-    float4 outColor = float4(lambertian * materials[materialIndex].Kd.rgb + specular + materials[materialIndex].Ke, 1);
+    float4 outColor = float4((lambertian * materials[materialIndex].Kd.rgb + specular + materials[materialIndex].Ke) * tint.rgb, 1);
     
 	return float4(outColor);     
 }
\ No newline at end of file
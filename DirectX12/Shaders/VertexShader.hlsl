@@ -22,35 +22,81 @@ cbuffer SCENE_DATA : register(b0, space0)
 
 cbuffer MESH_DATA : register(b1, space0)
 {
+    unsigned int instanceStart;
+};
+
+// Same layout as INSTANCE_RECORD in instanceRecords.h, one per drawn instance of a mesh
+struct INSTANCE_RECORD
+{
+    unsigned int transformIndex;
+    unsigned int modelIndex;
     unsigned int materialIndex;
-    unsigned int transformIndexStart;
+    unsigned int flags;
+    unsigned int lod;
+    unsigned int tint;
 };
 
 StructuredBuffer<matrix> transforms : register(t0, space0);
+StructuredBuffer<INSTANCE_RECORD> instances : register(t2, space0);
+
+// VertexShaderCompressed.hlsl defines COMPRESSED_VERTICES, positions are quantized against per model bounds
+#ifdef COMPRESSED_VERTICES
+struct VERTEX_QUANTIZATION
+{
+    float4 boundsMin;
+    float4 boundsExtent;
+};
+
+StructuredBuffer<VERTEX_QUANTIZATION> quantization : register(t1, space0);
+
+// Unfolds an octahedral normal, same math as Vertex_Compressor::DecodeOctahedral
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded, 1 - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0) ? -fold : fold;
+    return normalize(normal);
+}
+#endif
 
 struct OutputToRasterizer
 {
     float4 posH : SV_POSITION;
     float3 posW : WORLD;
     float3 normW : NORMAL;
+    nointerpolation unsigned int materialIndex : MATERIAL;
+    nointerpolation float4 tint : TINT;
 };
 
+#ifdef COMPRESSED_VERTICES
+OutputToRasterizer main(float4 packedPos : POSITION, float2 packedNorm : NORMAL, float2 inputUV : UVW, unsigned int instanceID : SV_InstanceID)
+{
+    INSTANCE_RECORD instance = instances[instanceStart + instanceID];
+    float3 inputPos = quantization[instance.modelIndex].boundsMin.xyz + packedPos.xyz * quantization[instance.modelIndex].boundsExtent.xyz;
+    float3 inputNorm = DecodeOctahedral(packedNorm);
+#else
 OutputToRasterizer main(float3 inputPos : POSITION, float3 inputUVW : UVW, float3 inputNorm : NORMAL, unsigned int instanceID : SV_InstanceID)
 {
+    INSTANCE_RECORD instance = instances[instanceStart + instanceID];
+#endif
+    matrix world = transforms[instance.transformIndex];
     float4 outPosH = float4(inputPos, 1);
     float4 outPosW = float4(inputPos, 1);    
     float4 outNormW = float4(inputNorm, 0);
     
-    outPosH = mul(transforms[transformIndexStart + instanceID], outPosH);
+    outPosH = mul(world, outPosH);
     outPosH = mul(viewProjection, outPosH);
     
-    outPosW = mul(transforms[transformIndexStart + instanceID], outPosW);
-    outNormW = mul(transforms[transformIndexStart + instanceID], outNormW);
+    outPosW = mul(world, outPosW);
+    outNormW = mul(world, outNormW);
     
     OutputToRasterizer output = (OutputToRasterizer) 0;
     output.posH = outPosH;
     output.posW = outPosW;
     output.normW = outNormW;
+    output.materialIndex = instance.materialIndex;
+    // RGBA8, red in the low byte
+    output.tint = float4((instance.tint >> uint4(0, 8, 16, 24)) & 0xFF) / 255.0f;
     
 	return output;
 }
\ No newline at end of file
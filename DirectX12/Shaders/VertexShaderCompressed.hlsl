@@ -0,0 +1,3 @@
+// VertexShader.hlsl reading COMPRESSED_VERTEX instead of H2B::VERTEX
+#define COMPRESSED_VERTICES
+#include "VertexShader.hlsl"
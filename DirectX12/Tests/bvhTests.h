@@ -0,0 +1,180 @@
+#pragma once
+#include <random>
+
+//The box test Level_BVH traverses with: -1 outside, 0 intersecting, 1 fully inside
+inline int ClassifyBoundsBruteForce(const Level_BVH::BVH_BOUNDS& bounds, const GW::MATH::GVECTORF planes[6])
+{
+	int result = 1;
+	for (int p = 0; p < 6; p++)
+	{
+		const GW::MATH::GVECTORF& plane = planes[p];
+		float outerDistance = plane.w + plane.x * (plane.x >= 0 ? bounds.max[0] : bounds.min[0]) +
+			plane.y * (plane.y >= 0 ? bounds.max[1] : bounds.min[1]) + plane.z * (plane.z >= 0 ? bounds.max[2] : bounds.min[2]);
+		if (outerDistance < 0)
+			return -1;
+		float innerDistance = plane.w + plane.x * (plane.x >= 0 ? bounds.min[0] : bounds.max[0]) +
+			plane.y * (plane.y >= 0 ? bounds.min[1] : bounds.max[1]) + plane.z * (plane.z >= 0 ? bounds.min[2] : bounds.max[2]);
+		if (innerDistance < 0)
+			result = 0;
+	}
+	return result;
+}
+
+//Closest slab test entry over every transform, FLT_MAX when nothing is hit within maxDistance
+inline float RayCastBruteForce(const Level_BVH& bvh, unsigned transformCount, const float origin[3], const float direction[3], float maxDistance)
+{
+	float inverse[3];
+	for (int axis = 0; axis < 3; axis++)
+		inverse[axis] = direction[axis] != 0 ? 1.0f / direction[axis] : FLT_MAX;
+	float closest = FLT_MAX;
+	for (unsigned transform = 0; transform < transformCount; transform++)
+	{
+		const Level_BVH::BVH_BOUNDS& bounds = bvh.GetWorldBounds(transform);
+		float enter = 0, exit = maxDistance;
+		for (int axis = 0; axis < 3 && enter <= exit; axis++)
+		{
+			float t0 = (bounds.min[axis] - origin[axis]) * inverse[axis];
+			float t1 = (bounds.max[axis] - origin[axis]) * inverse[axis];
+			enter = std::max(enter, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+		}
+		if (enter <= exit && enter < closest)
+			closest = enter;
+	}
+	return closest;
+}
+
+//Build, refit & query times of Level_BVH on a synthetic 100k object level, every query is checked against brute force
+inline void BenchmarkLevelBVH(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	if (LoadSyntheticLevel(context, level, "BVH", 100000, 2.5f) == false)
+		return;
+	Scene_Hierarchy hierarchy;
+	hierarchy.Build(level);
+	std::vector<GW::MATH::GMATRIXF> world;
+	hierarchy.CopyWorldTransforms(world);
+	const unsigned transformCount = static_cast<unsigned>(world.size());
+	//the level is about 790 units square
+	const float levelSize = std::ceil(std::sqrt(static_cast<float>(transformCount))) * 2.5f;
+
+	Level_BVH bvh;
+	auto buildStart = std::chrono::steady_clock::now();
+	bvh.Build(level, world);
+	double buildTime = MillisecondsSince(buildStart);
+
+	//10 objects rotating every frame, like the windmill
+	const unsigned frames = 100, rotating = 10;
+	double refitTime = 0;
+	for (unsigned frame = 0; frame < frames; frame++)
+	{
+		for (unsigned r = 0; r < rotating; r++)
+		{
+			unsigned transform = r * (transformCount / rotating);
+			GW::MATH::GMATRIXF rotated;
+			GW::MATH::GMatrix::RotateYLocalF(hierarchy.GetLocal(transform), 0.1f, rotated);
+			hierarchy.SetLocal(transform, rotated);
+		}
+		hierarchy.UpdateWorldTransforms();
+		hierarchy.CopyChangedWorldTransforms(world);
+		auto refitStart = std::chrono::steady_clock::now();
+		bvh.Refit(world, hierarchy.GetChangedTransforms());
+		refitTime += MillisecondsSince(refitStart);
+	}
+	Level_BVH rebuilt;
+	rebuilt.Build(level, world);
+	unsigned staleBounds = 0;
+	for (unsigned transform = 0; transform < transformCount; transform++)
+		staleBounds += std::memcmp(&bvh.GetWorldBounds(transform), &rebuilt.GetWorldBounds(transform), sizeof(Level_BVH::BVH_BOUNDS)) != 0 ? 1 : 0;
+	Check(context, staleBounds == 0, std::to_string(staleBounds) + " transforms have different bounds after refitting than after a rebuild");
+	std::printf("%u transforms: build %.1f ms (%zu nodes), refit of %u moving transforms %.4f ms per frame\n",
+		transformCount, buildTime, bvh.GetNodes().size(), rotating, refitTime / frames);
+
+	//cameras 2 units above the level looking along it, 100 units far plane like the renderer
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(0, levelSize), angle(0, 6.2832f);
+	const unsigned cameras = 100;
+	double bvhFrustumTime = 0, bruteFrustumTime = 0;
+	unsigned frustumMismatches = 0;
+	size_t frustumHits = 0;
+	std::vector<unsigned> bvhVisible, bruteVisible;
+	for (unsigned camera = 0; camera < cameras; camera++)
+	{
+		float x = position(random), z = position(random), heading = angle(random);
+		GW::MATH::GVECTORF planes[6];
+		SIMD_MATH::ExtractFrustumPlanes(MakeViewProjection({ x, 2, z, 1 }, { x + std::cos(heading), 2, z + std::sin(heading), 1 }), planes);
+		bvhVisible.clear();
+		bruteVisible.clear();
+		auto bvhStart = std::chrono::steady_clock::now();
+		bvh.QueryFrustum(planes, bvhVisible);
+		bvhFrustumTime += MillisecondsSince(bvhStart);
+		auto bruteStart = std::chrono::steady_clock::now();
+		for (unsigned transform = 0; transform < transformCount; transform++)
+		{
+			int result = ClassifyBoundsBruteForce(bvh.GetWorldBounds(transform), planes);
+			if (result >= 0)
+				bruteVisible.push_back(result > 0 ? (transform | Level_BVH::insideBit) : transform);
+		}
+		bruteFrustumTime += MillisecondsSince(bruteStart);
+		std::sort(bvhVisible.begin(), bvhVisible.end());
+		std::sort(bruteVisible.begin(), bruteVisible.end());
+		frustumMismatches += bvhVisible != bruteVisible ? 1 : 0;
+		frustumHits += bvhVisible.size();
+	}
+	Check(context, frustumMismatches == 0, std::to_string(frustumMismatches) + " frustum queries differ from brute force");
+	std::printf("frustum: %zu transforms per camera, BVH %.3f ms, brute force %.3f ms per query (%.1fx)\n",
+		frustumHits / cameras, bvhFrustumTime / cameras, bruteFrustumTime / cameras, bruteFrustumTime / bvhFrustumTime);
+
+	//rays 1 unit above the ground, the brute force check only runs on the first few
+	const unsigned rays = 10000, checkedRays = 200;
+	std::uniform_real_distribution<float> slope(-0.2f, 0.2f);
+	double rayTime = 0;
+	unsigned rayMismatches = 0, rayHits = 0;
+	for (unsigned ray = 0; ray < rays; ray++)
+	{
+		float heading = angle(random);
+		float origin[3] = { position(random), 1, position(random) }, direction[3] = { std::cos(heading), slope(random), std::sin(heading) };
+		unsigned hitTransform = 0;
+		float hitDistance = FLT_MAX;
+		auto rayStart = std::chrono::steady_clock::now();
+		bool hit = bvh.RayCast(origin, direction, 50, hitTransform, hitDistance);
+		rayTime += MillisecondsSince(rayStart);
+		rayHits += hit ? 1 : 0;
+		if (ray < checkedRays)
+			rayMismatches += (hit ? hitDistance : FLT_MAX) != RayCastBruteForce(bvh, transformCount, origin, direction, 50) ? 1 : 0;
+	}
+	Check(context, rayMismatches == 0, std::to_string(rayMismatches) + " ray casts differ from brute force");
+	std::printf("rays: %u of %u hit, %.0f rays/s\n", rayHits, rays, rays / (rayTime / 1000));
+
+	const unsigned spheres = 10000, checkedSpheres = 200;
+	double sphereTime = 0;
+	unsigned sphereMismatches = 0;
+	std::vector<unsigned> bvhOverlaps, bruteOverlaps;
+	for (unsigned sphere = 0; sphere < spheres; sphere++)
+	{
+		float center[3] = { position(random), 0, position(random) };
+		bvhOverlaps.clear();
+		auto sphereStart = std::chrono::steady_clock::now();
+		bvh.QuerySphere(center, 5, bvhOverlaps);
+		sphereTime += MillisecondsSince(sphereStart);
+		if (sphere >= checkedSpheres)
+			continue;
+		bruteOverlaps.clear();
+		for (unsigned transform = 0; transform < transformCount; transform++)
+		{
+			const Level_BVH::BVH_BOUNDS& bounds = bvh.GetWorldBounds(transform);
+			float distance = 0;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float d = std::max(std::max(bounds.min[axis] - center[axis], center[axis] - bounds.max[axis]), 0.0f);
+				distance += d * d;
+			}
+			if (distance <= 25)
+				bruteOverlaps.push_back(transform);
+		}
+		std::sort(bvhOverlaps.begin(), bvhOverlaps.end());
+		sphereMismatches += bvhOverlaps != bruteOverlaps ? 1 : 0;
+	}
+	Check(context, sphereMismatches == 0, std::to_string(sphereMismatches) + " sphere queries differ from brute force");
+	std::printf("spheres: %.0f queries/s\n", spheres / (sphereTime / 1000));
+}
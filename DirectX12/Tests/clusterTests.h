@@ -0,0 +1,171 @@
+#pragma once
+#include <map>
+#include <random>
+
+//Triangles of a frame's split draws that some instance could see but no output draw covers
+//Seen means not wholly outside one frustum plane and facing the eye, mirrored instances count every side as facing
+inline unsigned CountMissingTriangles(const Level_Data& level, const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws,
+	const std::vector<Draw_Packet_Builder::DRAW_PACKET>& culled, const std::vector<unsigned>& instanceTransforms,
+	const std::vector<GW::MATH::GMATRIXF>& world, const GW::MATH::GMATRIXF& viewProjection, const GW::MATH::GVECTORF& eye)
+{
+	GW::MATH::GVECTORF planes[6];
+	SIMD_MATH::ExtractFrustumPlanes(viewProjection, planes);
+	//a draw and its split ranges share mesh and instances, the ranges are what the frame draws of it
+	std::map<std::pair<unsigned, unsigned>, std::vector<std::pair<unsigned, unsigned>>> drawn;
+	for (const Draw_Packet_Builder::DRAW_PACKET& draw : culled)
+		drawn[{ draw.meshIndex, draw.instanceStart }].push_back({ draw.startIndex, draw.startIndex + draw.indexCount });
+
+	unsigned missing = 0;
+	for (const Draw_Packet_Builder::DRAW_PACKET& draw : draws)
+	{
+		if (draw.lod != 0)
+			continue;
+		const Level_Data::LEVEL_MODEL& model = level.levelModels[draw.modelIndex];
+		const H2B::BATCH& mesh = level.levelMeshes[draw.meshIndex].drawInfo;
+		const std::vector<std::pair<unsigned, unsigned>>& ranges = drawn[{ draw.meshIndex, draw.instanceStart }];
+		for (unsigned i = 0; i < mesh.indexCount; i += 3)
+		{
+			unsigned position = draw.startIndex + i;
+			bool covered = false;
+			for (const std::pair<unsigned, unsigned>& range : ranges)
+				covered = covered || (position >= range.first && position + 3 <= range.second);
+			if (covered)
+				continue;
+			bool seen = false;
+			for (unsigned instance = 0; instance < draw.instanceCount && seen == false; instance++)
+			{
+				const GW::MATH::GMATRIXF& transform = world[instanceTransforms[draw.instanceStart + instance]];
+				float corners[3][4];
+				for (unsigned c = 0; c < 3; c++)
+					SIMD_MATH::TransformPoint(transform, &level.levelVertexView[model.vertexStart +
+						level.levelIndexView[model.indexStart + mesh.indexOffset + i + c]].pos.x, corners[c]);
+				bool outside = false;
+				for (unsigned p = 0; p < 6 && outside == false; p++)
+				{
+					outside = true;
+					for (unsigned c = 0; c < 3; c++)
+						outside = outside && planes[p].x * corners[c][0] + planes[p].y * corners[c][1] + planes[p].z * corners[c][2] + planes[p].w < 0;
+				}
+				if (outside)
+					continue;
+				float e1[3], e2[3], n[3];
+				for (unsigned k = 0; k < 3; k++)
+				{
+					e1[k] = corners[1][k] - corners[0][k];
+					e2[k] = corners[2][k] - corners[0][k];
+				}
+				n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+				n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+				n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+				float determinant = transform.row1.x * (transform.row2.y * transform.row3.z - transform.row2.z * transform.row3.y) -
+					transform.row1.y * (transform.row2.x * transform.row3.z - transform.row2.z * transform.row3.x) +
+					transform.row1.z * (transform.row2.x * transform.row3.y - transform.row2.y * transform.row3.x);
+				seen = determinant <= 0 || n[0] * (eye.x - corners[0][0]) + n[1] * (eye.y - corners[0][1]) + n[2] * (eye.z - corners[0][2]) > 0;
+			}
+			missing += seen ? 1 : 0;
+		}
+	}
+	return missing;
+}
+
+//Meshlet build cost at import, then Cluster_Culler over fixed and random cameras on Level1 & Level2
+//Culling may never drop a triangle any instance could see
+inline void BenchmarkClusterCulling(TEST_CONTEXT& context)
+{
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		std::string gameLevel = PrepareLevel(context, levelName);
+		std::string models = GetModelsFolder(context, levelName);
+		//imports on one worker so the difference is the meshlet build alone
+		Level_Data withoutMeshlets;
+		withoutMeshlets.importWorkers = 1;
+		withoutMeshlets.buildMeshlets = false;
+		auto plainStart = std::chrono::steady_clock::now();
+		bool imported = withoutMeshlets.CookLevel(gameLevel.c_str(), models.c_str(), context.log);
+		double plainTime = MillisecondsSince(plainStart);
+		Level_Data level;
+		level.importWorkers = 1;
+		std::filesystem::remove(Level_Data::GetCookedLevelPath(gameLevel.c_str()));
+		auto meshletStart = std::chrono::steady_clock::now();
+		imported = imported && level.LoadLevel(gameLevel.c_str(), models.c_str(), context.log);
+		double meshletTime = MillisecondsSince(meshletStart);
+		if (Check(context, imported, std::string(levelName) + " import") == false)
+			continue;
+
+		//every mesh's meshlets cover its indices in order, within the size limits
+		unsigned badRanges = 0, largest = 0;
+		for (size_t mesh = 0; mesh < level.levelMeshes.size(); mesh++)
+		{
+			const Level_Data::LEVEL_MESHLET_RANGE& range = level.levelMeshletRanges[mesh];
+			unsigned next = level.levelMeshes[mesh].drawInfo.indexOffset;
+			for (unsigned m = range.meshletStart; m < range.meshletStart + range.meshletCount; m++)
+			{
+				const Level_Data::LEVEL_MESHLET& meshlet = level.levelMeshlets[m];
+				badRanges += meshlet.indexOffset != next || meshlet.indexCount > Level_Data::meshletMaxTriangles * 3 ? 1 : 0;
+				largest = std::max(largest, meshlet.indexCount / 3);
+				next = meshlet.indexOffset + meshlet.indexCount;
+			}
+			badRanges += next != level.levelMeshes[mesh].drawInfo.indexOffset + level.levelMeshes[mesh].drawInfo.indexCount ? 1 : 0;
+		}
+		Check(context, badRanges == 0, std::string(levelName) + " has " + std::to_string(badRanges) + " bad meshlet ranges");
+		std::printf("%s: %zu meshlets for %zu meshes (largest %u triangles), import %.1f ms with meshlets, %.1f ms without\n", levelName,
+			level.levelMeshlets.size(), level.levelMeshes.size(), largest, meshletTime, plainTime);
+
+		//cameras inside the box of every placed transform, 5 fixed then random
+		Scene_Hierarchy hierarchy;
+		hierarchy.Build(level);
+		std::vector<GW::MATH::GMATRIXF> world;
+		hierarchy.CopyWorldTransforms(world);
+		float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const GW::MATH::GMATRIXF& transform : world)
+			for (int k = 0; k < 3; k++)
+			{
+				low[k] = std::min(low[k], transform.data[12 + k]);
+				high[k] = std::max(high[k], transform.data[12 + k]);
+			}
+		std::vector<std::pair<GW::MATH::GVECTORF, GW::MATH::GVECTORF>> cameras = {
+			{ { 0.25f, 6.5f, -0.25f, 1 }, { 0, 0, 0, 1 } }, { { 0, 60, -90, 1 }, { 0, 0, 0, 1 } }, { { 0, 2, -20, 1 }, { 0, 2, 0, 1 } },
+			{ { 20, 10, 20, 1 }, { 0, 0, 0, 1 } }, { { -15, 3, 5, 1 }, { 10, 1, -5, 1 } } };
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> unit(0, 1);
+		while (cameras.size() < 25)
+		{
+			GW::MATH::GVECTORF eye = { low[0] + (high[0] - low[0]) * unit(random), 1 + 30 * unit(random), low[2] + (high[2] - low[2]) * unit(random), 1 };
+			GW::MATH::GVECTORF at = { low[0] + (high[0] - low[0]) * unit(random), 0, low[2] + (high[2] - low[2]) * unit(random), 1 };
+			cameras.push_back({ eye, at });
+		}
+
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetOcclusionCulling(false);
+		Cluster_Culler culler;
+		culler.SetMaxDraws(Indirect_Argument_Builder::MaxDraws(level));
+		double cullTime = 0;
+		unsigned long long trianglesIn = 0, trianglesOut = 0, clustersTested = 0, clustersCulled = 0;
+		unsigned missing = 0, differentFrames = 0;
+		for (const std::pair<GW::MATH::GVECTORF, GW::MATH::GVECTORF>& camera : cameras)
+		{
+			GW::MATH::GMATRIXF viewProjection = MakeViewProjection(camera.first, camera.second);
+			frameRenderer.SetCamera(viewProjection, camera.first);
+			frameRenderer.LinkChildrenToParent();
+			frameRenderer.Render(device.BeginFrame());
+			device.EndFrame();
+			const Draw_Packet_Builder& packets = frameRenderer.GetDrawPackets();
+			auto cullStart = std::chrono::steady_clock::now();
+			culler.Cull(level, packets.GetDraws(), packets.GetInstanceTransforms(), frameRenderer.GetTransforms(), viewProjection, camera.first);
+			cullTime += MillisecondsSince(cullStart);
+			differentFrames += culler.GetDraws().size() != frameRenderer.GetClusterCuller().GetDraws().size() ? 1 : 0;
+			missing += CountMissingTriangles(level, packets.GetDraws(), culler.GetDraws(), packets.GetInstanceTransforms(),
+				frameRenderer.GetTransforms(), viewProjection, camera.first);
+			const Cluster_Culler::CLUSTER_STATS& stats = culler.GetStats();
+			trianglesIn += stats.trianglesIn;
+			trianglesOut += stats.trianglesOut;
+			clustersTested += stats.clustersTested;
+			clustersCulled += stats.frustumCulled + stats.backfaceCulled;
+		}
+		Check(context, differentFrames == 0, std::string(levelName) + ": the frame's culler and the timed one disagree");
+		Check(context, missing == 0, std::string(levelName) + ": " + std::to_string(missing) + " visible triangles culled");
+		std::printf("%s: %zu cameras, %llu of %llu meshlets culled, %.1f%% of the triangles drawn, %.3f ms culling per frame\n", levelName,
+			cameras.size(), clustersCulled, clustersTested, trianglesIn ? 100.0 * trianglesOut / trianglesIn : 100.0, cullTime / cameras.size());
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+//Renders Level1 headless from a fixed camera that sees the whole level, with occlusion, meshlet and LOD culling off so
+//the frame has to draw every mesh of every placed transform exactly once, and checks the recorded stream against Level_Data:
+//the bound buffers and scene constants, one draw per mesh whose instance records name its transforms, model and material,
+//one draw constant per draw, a geometry bind per index pool, and uploads of exactly the scene constants and instance records
+inline void TestDrawList(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	std::string gameLevel = PrepareLevel(context, "Level1");
+	if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, "Level1").c_str(), context.log), "Level1 load") == false)
+		return;
+	GW::MATH::GVECTORF eye = { 0, 120, -120, 1 };
+	GW::MATH::GMATRIXF viewProjection = MakeViewProjection(eye, { 0, 0, 0, 1 }, 1000);
+	Recording_Command_List frames[2];
+	for (unsigned run = 0; run < 2; run++)
+	{
+		//a fresh device each time, the same level and camera have to record the same frame
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetOcclusionCulling(false);
+		frameRenderer.SetClusterCulling(false);
+		frameRenderer.SetLodSelection(false);
+		frameRenderer.SetCamera(viewProjection, eye);
+		frameRenderer.LinkChildrenToParent();
+		Recording_Render_Device::RECORDING_STATS before = device.GetStats();
+		frameRenderer.Render(device.BeginFrame());
+		device.EndFrame();
+		const Recording_Command_List& frame = frames[run] = device.GetRecordedFrame();
+		if (run > 0)
+			break;
+		if (Check(context, frameRenderer.GetFrustumCuller().GetVisibleCount() == level.levelTransforms.size(),
+			"the camera does not see all of Level1") == false)
+			return;
+
+		//scene constants, transforms, materials, vertex quantization and instance records are bound before any draw
+		const std::vector<RECORDED_COMMAND>& commands = frame.GetCommands();
+		const RECORDED_COMMAND_TYPE bindTypes[] = { RECORDED_COMMAND_TYPE::SET_CONSTANT_BUFFER, RECORDED_COMMAND_TYPE::SET_RESOURCE,
+			RECORDED_COMMAND_TYPE::SET_RESOURCE, RECORDED_COMMAND_TYPE::SET_RESOURCE, RECORDED_COMMAND_TYPE::SET_RESOURCE };
+		const unsigned bindSlots[] = { SCENE_CONSTANTS, TRANSFORM_RESOURCE, MATERIAL_RESOURCE, QUANTIZATION_RESOURCE, INSTANCE_RESOURCE };
+		bool bound = commands.size() > 5;
+		for (unsigned c = 0; c < 5 && bound; c++)
+			bound = commands[c].type == bindTypes[c] && commands[c].args[0] == bindSlots[c] && device.IsLive(commands[c].args[1]);
+		if (Check(context, bound, "the frame does not start with its five binds") == false)
+			return;
+		Check(context, commands[0].args[2] % RENDER_CONSTANT_ALIGNMENT == 0, "scene constants are not 256 byte aligned");
+		//SCENE_DATA is the sun's direction, color and ambient, the camera position and then the view projection
+		const char* scene = device.GetBufferData(commands[0].args[1]).data() + commands[0].args[2];
+		Check(context, std::memcmp(scene + 3 * sizeof(GW::MATH::GVECTORF), &eye, sizeof(eye)) == 0 &&
+			std::memcmp(scene + 4 * sizeof(GW::MATH::GVECTORF), &viewProjection, sizeof(viewProjection)) == 0,
+			"the scene constants do not hold the camera");
+		const std::vector<GW::MATH::GMATRIXF>& world = frameRenderer.GetTransforms();
+		const std::vector<char>& transforms = device.GetBufferData(commands[1].args[1]);
+		Check(context, commands[1].args[2] == 0 && transforms.size() == world.size() * sizeof(GW::MATH::GMATRIXF) &&
+			std::memcmp(transforms.data(), world.data(), transforms.size()) == 0, "the bound transforms are not the world transforms");
+		const std::vector<char>& materials = device.GetBufferData(commands[2].args[1]);
+		bool sameMaterials = materials.size() == level.levelMaterials.size() * sizeof(H2B::ATTRIBUTES);
+		for (unsigned m = 0; m < level.levelMaterials.size() && sameMaterials; m++)
+			sameMaterials = std::memcmp(materials.data() + m * sizeof(H2B::ATTRIBUTES), &level.levelMaterials[m].attrib, sizeof(H2B::ATTRIBUTES)) == 0;
+		Check(context, sameMaterials, "the bound materials are not the level's");
+		const INSTANCE_RECORD* records = reinterpret_cast<const INSTANCE_RECORD*>(device.GetBufferData(commands[4].args[1]).data() + commands[4].args[2]);
+
+		//slot of every (transform, mesh of its model) pair, counts how often a draw covered it
+		std::vector<unsigned> pairStart(level.levelTransforms.size() + 1, 0), transformModel(level.levelTransforms.size(), ~0u);
+		for (const Level_Data::MODEL_INSTANCES& instances : level.levelInstances)
+			for (unsigned t = instances.transformStart; t < instances.transformStart + instances.transformCount; t++)
+				transformModel[t] = instances.modelIndex;
+		for (unsigned t = 0; t < transformModel.size(); t++)
+			pairStart[t + 1] = pairStart[t] + (transformModel[t] != ~0u ? level.levelModels[transformModel[t]].meshCount : 0);
+		std::vector<unsigned> drawn(pairStart.back(), 0);
+		auto lodZeroDraw = [&level](const Level_Data::LEVEL_MODEL& model, unsigned mesh) -> const H2B::BATCH& {
+			return level.levelLodDraws[level.levelLods[model.lodStart].drawStart + mesh - model.meshStart];
+		};
+
+		RENDER_BUFFER indices = 0;
+		unsigned instanceStart = ~0u, draws = 0, badDraws = 0, constantWrites = 0, geometryBinds = 0, instances = 0;
+		for (unsigned c = 5; c < commands.size(); c++)
+		{
+			const RECORDED_COMMAND& command = commands[c];
+			if (command.type == RECORDED_COMMAND_TYPE::SET_GEOMETRY)
+			{
+				indices = command.args[1];
+				geometryBinds++;
+				badDraws += device.IsLive(command.args[0]) && device.GetBufferDesc(command.args[0]).type == RENDER_BUFFER_TYPE::VERTICES ? 0 : 1;
+				continue;
+			}
+			if (command.type == RECORDED_COMMAND_TYPE::SET_CONSTANT)
+			{
+				badDraws += command.args[0] == DRAW_CONSTANTS && command.args[1] == 0 && command.args[2] != instanceStart ? 0 : 1;
+				instanceStart = command.args[2];
+				constantWrites++;
+				continue;
+			}
+			if (command.type != RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED || indices == 0 || instanceStart == ~0u || command.args[1] == 0)
+			{
+				badDraws++;
+				continue;
+			}
+			draws++;
+			instances += command.args[1];
+			//the first record names the model, the draw's indices name the mesh
+			unsigned modelIndex = records[instanceStart].modelIndex;
+			const Level_Data::LEVEL_MODEL& model = level.levelModels[modelIndex];
+			const Index_Pool_Builder::MODEL_INDICES& modelIndices = level.levelModelIndices[modelIndex];
+			unsigned mesh = model.meshStart;
+			while (mesh < model.meshStart + model.meshCount && (lodZeroDraw(model, mesh).indexCount != command.args[0] ||
+				modelIndices.indexStart + lodZeroDraw(model, mesh).indexOffset != command.args[2]))
+				mesh++;
+			bool same = mesh < model.meshStart + model.meshCount && static_cast<int>(command.args[3]) == static_cast<int>(model.vertexStart) &&
+				command.args[4] == 0 && device.GetBufferDesc(indices).type == RENDER_BUFFER_TYPE::INDICES &&
+				device.GetBufferDesc(indices).strideInBytes == Index_Pool_Builder::GetStride(modelIndices.pool);
+			for (unsigned i = instanceStart; i < instanceStart + command.args[1] && same; i++)
+			{
+				const INSTANCE_RECORD& record = records[i];
+				same = record.transformIndex < transformModel.size() && transformModel[record.transformIndex] == modelIndex &&
+					record.modelIndex == modelIndex && record.lod == 0 && record.tint == 0xFFFFFFFF &&
+					record.materialIndex == model.materialStart + level.levelMeshes[mesh].materialIndex;
+				if (same)
+					drawn[pairStart[record.transformIndex] + mesh - model.meshStart]++;
+			}
+			badDraws += same ? 0 : 1;
+		}
+		Check(context, badDraws == 0, std::to_string(badDraws) + " recorded commands do not match Level1");
+
+		//every mesh of every placed model is one draw, and every one of its transforms is drawn by it once
+		unsigned expectedDraws = 0, wrongPairs = 0, pools = 0;
+		std::vector<char> modelPlaced(level.levelModels.size(), 0), poolUsed(INDEX_POOL_COUNT, 0);
+		for (unsigned t = 0; t < transformModel.size(); t++)
+			if (transformModel[t] != ~0u)
+			{
+				const Level_Data::LEVEL_MODEL& model = level.levelModels[transformModel[t]];
+				for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+					wrongPairs += drawn[pairStart[t] + mesh - model.meshStart] == (lodZeroDraw(model, mesh).indexCount > 0 ? 1u : 0u) ? 0 : 1;
+				modelPlaced[transformModel[t]] = 1;
+			}
+		for (unsigned m = 0; m < level.levelModels.size(); m++)
+			if (modelPlaced[m])
+			{
+				const Level_Data::LEVEL_MODEL& model = level.levelModels[m];
+				for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+					expectedDraws += lodZeroDraw(model, mesh).indexCount > 0 ? 1 : 0;
+				pools += poolUsed[level.levelModelIndices[m].pool]++ == 0 ? 1 : 0;
+			}
+		Check(context, wrongPairs == 0, std::to_string(wrongPairs) + " transform meshes were not drawn exactly once");
+		Check(context, draws == expectedDraws, std::to_string(draws) + " draws for " + std::to_string(expectedDraws) + " placed meshes");
+		Check(context, constantWrites == draws, std::to_string(constantWrites) + " draw constant writes for " + std::to_string(draws) + " draws");
+		Check(context, geometryBinds == pools, std::to_string(geometryBinds) + " geometry binds for " + std::to_string(pools) + " index pools");
+
+		//nothing moved so no transform is rewritten, the ring only gets the scene constants and one record per instance
+		const Recording_Render_Device::RECORDING_STATS& after = device.GetStats();
+		unsigned long long uploaded = after.bytesUploaded - before.bytesUploaded, expectedUpload = 4 * sizeof(GW::MATH::GVECTORF) +
+			sizeof(GW::MATH::GMATRIXF) + instances * sizeof(INSTANCE_RECORD);
+		Check(context, after.bytesWritten == before.bytesWritten && frame.CountCommands(RECORDED_COMMAND_TYPE::WRITE_BUFFER) == 0,
+			"a static frame rewrote buffers");
+		Check(context, uploaded == expectedUpload, std::to_string(uploaded) + " bytes uploaded for " + std::to_string(expectedUpload) +
+			" bytes of scene constants and instance records");
+		std::printf("Level1: %zu commands, %u draws of %u instances, %u draw constants, %u geometry binds, %llu bytes uploaded\n",
+			commands.size(), draws, instances, constantWrites, geometryBinds, uploaded);
+	}
+	Check(context, SameRecording(frames[0], frames[1]), "the same camera recorded another frame on a fresh device");
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <random>
+
+//Places every Level1 model around a camera at z = -10 looking down +z where the answer is known: fully inside, behind the
+//camera, beside and above the frustum, past the far plane, and centered on the near, far and a side plane
+//Then the BVH Cull the renderer uses has to give exactly the runs of the brute force Cull on Level1 & Level2
+inline void TestFrustumCulling(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	std::string gameLevel = PrepareLevel(context, "Level1");
+	if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, "Level1").c_str(), context.log), "Level1 load") == false)
+		return;
+	Frustum_Culler culler;
+	culler.Build(level);
+	culler.Cull(level, level.levelTransforms, MakeViewProjection({ 0, 0, -10, 1 }, { 0, 0, 0, 1 }));
+	//at depth d past the camera the frustum reaches d * tan(32.5) up and 16 / 9 times that sideways
+	auto halfHeight = [](float depth) { return depth * std::tan(G_DEGREE_TO_RADIAN_F(32.5f)); };
+	auto halfWidth = [&halfHeight](float depth) { return halfHeight(depth) * 16.0f / 9.0f; };
+	unsigned wrongBoxes = 0, boxes = 0;
+	for (unsigned m = 0; m < level.levelModels.size(); m++)
+	{
+		const GW::MATH::GOBBF& obb = level.levelColliders[level.levelModels[m].colliderIndex];
+		float radius = std::sqrt(obb.extent.x * obb.extent.x + obb.extent.y * obb.extent.y + obb.extent.z * obb.extent.z);
+		if (radius == 0)
+			continue;
+		const float gap = 2 * radius + 1;
+		const std::pair<GW::MATH::GVECTORF, bool> placements[] = {
+			{ { 0, 0, 0, 1 }, true },
+			{ { 0, 0, -10 - gap, 1 }, false },
+			{ { halfWidth(10) + gap * 2, 0, 0, 1 }, false },
+			{ { -halfWidth(10) - gap * 2, 0, 0, 1 }, false },
+			{ { 0, halfHeight(10) + gap * 2, 0, 1 }, false },
+			{ { 0, 0, 90 + gap, 1 }, false },
+			{ { 0, 0, -9.9f, 1 }, true },
+			{ { 0, 0, 90, 1 }, true },
+			{ { -halfWidth(10), 0, 0, 1 }, true },
+			{ { 0, -halfHeight(50), 40, 1 }, true } };
+		for (const std::pair<GW::MATH::GVECTORF, bool>& placement : placements)
+		{
+			//moves the box's center to the placement
+			GW::MATH::GMATRIXF world = GW::MATH::GIdentityMatrixF;
+			world.row4 = { placement.first.x - obb.center.x, placement.first.y - obb.center.y, placement.first.z - obb.center.z, 1 };
+			wrongBoxes += culler.IsVisible(m, world) != placement.second ? 1 : 0;
+			boxes++;
+		}
+	}
+	Check(context, wrongBoxes == 0, std::to_string(wrongBoxes) + " of " + std::to_string(boxes) + " placed boxes culled wrong");
+
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		Level_Data culled;
+		gameLevel = PrepareLevel(context, levelName);
+		if (Check(context, culled.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, levelName).c_str(), context.log),
+			std::string(levelName) + " load") == false)
+			continue;
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, culled, context.log);
+		Frustum_Culler bruteForce;
+		bruteForce.Build(culled);
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> ground(-40, 40), height(0.5f, 30), target(-10, 10);
+		unsigned cameras = 200, mismatches = 0, visible = 0, tested = 0;
+		for (unsigned camera = 0; camera < cameras; camera++)
+		{
+			GW::MATH::GVECTORF eye = { ground(random), height(random), ground(random), 1 };
+			GW::MATH::GVECTORF at = { target(random), 0, target(random), 1 };
+			GW::MATH::GMATRIXF viewProjection = MakeViewProjection(eye, at, camera % 2 ? 100.0f : 30.0f);
+			frameRenderer.SetCamera(viewProjection, eye);
+			frameRenderer.LinkChildrenToParent();
+			frameRenderer.Render(device.BeginFrame());
+			device.EndFrame();
+			const Frustum_Culler& bvhCuller = frameRenderer.GetFrustumCuller();
+			bruteForce.Cull(culled, frameRenderer.GetTransforms(), viewProjection);
+			const std::vector<Frustum_Culler::VISIBLE_RUN>& bvhRuns = bvhCuller.GetVisibleRuns();
+			const std::vector<Frustum_Culler::VISIBLE_RUN>& bruteRuns = bruteForce.GetVisibleRuns();
+			mismatches += bvhRuns.size() == bruteRuns.size() &&
+				std::memcmp(bvhRuns.data(), bruteRuns.data(), bvhRuns.size() * sizeof(Frustum_Culler::VISIBLE_RUN)) == 0 ? 0 : 1;
+			visible += bruteForce.GetVisibleCount();
+			tested += bvhCuller.GetTestedCount();
+		}
+		Check(context, mismatches == 0, std::string(levelName) + ": " + std::to_string(mismatches) + " of " + std::to_string(cameras) +
+			" cameras got other runs from the BVH than from brute force");
+		std::printf("%s: %u cameras, %.1f of %zu transforms visible, the BVH tested %.1f per frame\n", levelName, cameras,
+			static_cast<double>(visible) / cameras, culled.levelTransforms.size(), static_cast<double>(tested) / cameras);
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+//Loads a synthetic level of chains depth objects deep, every object's parent has to be the MESH entry it was indented under
+//Returns the milliseconds reading and linking GameLevel.txt takes on its own, best of 3, negative when the import failed
+inline double ImportHierarchy(TEST_CONTEXT& context, Level_Data& level, unsigned objectCount, unsigned depth)
+{
+	std::string levelName = "Hierarchy" + std::to_string(objectCount);
+	std::string gameLevel = WriteSyntheticLevel(levelName.c_str(), objectCount, { "Cow", "Pig", "Sheep", "Horse" }, 4, depth);
+	std::string models = GetModelsFolder(context, "Level1");
+	if (Check(context, level.CookLevel(gameLevel.c_str(), models.c_str(), context.log), levelName + " import") == false)
+		return -1;
+	double parseTime = 0;
+	for (unsigned run = 0; run < 3; run++)
+	{
+		auto parseStart = std::chrono::steady_clock::now();
+		unsigned objects = level.ReadGameLevelObjects(gameLevel.c_str(), context.log);
+		double time = MillisecondsSince(parseStart);
+		parseTime = run == 0 || time < parseTime ? time : parseTime;
+		Check(context, objects == objectCount, levelName + " parse read " + std::to_string(objects) + " objects");
+	}
+
+	//object numbers are the name suffixes WriteSyntheticLevel gave them
+	std::vector<int> objectTransforms(objectCount, -1);
+	for (const Level_Data::BLENDER_OBJECT& object : level.blenderObjects)
+		objectTransforms[std::strtoul(std::strrchr(object.blendername, '.') + 1, nullptr, 10)] = static_cast<int>(object.transformIndex);
+	unsigned wrongParents = 0, wrongOffsets = 0;
+	for (const Level_Data::BLENDER_OBJECT& object : level.blenderObjects)
+	{
+		unsigned number = std::strtoul(std::strrchr(object.blendername, '.') + 1, nullptr, 10);
+		int expected = number % depth != 0 ? objectTransforms[number - 1] : -1;
+		wrongParents += object.parentTransformIndex != expected ? 1 : 0;
+		//children are stored relative to their parent, half a spacing along x
+		const GW::MATH::GVECTORF& offset = level.levelTransforms[object.transformIndex].row4;
+		if (expected != -1 && (std::fabs(offset.x - 2) > 1e-3f || std::fabs(offset.y) > 1e-3f || std::fabs(offset.z) > 1e-3f))
+			wrongOffsets++;
+	}
+	Check(context, level.blenderObjects.size() == objectCount,
+		levelName + " has " + std::to_string(level.blenderObjects.size()) + " objects");
+	Check(context, wrongParents == 0, levelName + " has " + std::to_string(wrongParents) + " objects with the wrong parent");
+	Check(context, wrongOffsets == 0, levelName + " has " + std::to_string(wrongOffsets) + " children not relative to their parent");
+	return parseTime;
+}
+
+//The parent matching the hierarchy indices replaced: the first transform sharing the parent's translation
+//Returns how many objects it would have linked to the wrong transform
+inline unsigned MatchParentsByTranslation(const Level_Data& level)
+{
+	unsigned wrongParents = 0;
+	for (const Level_Data::BLENDER_OBJECT& object : level.blenderObjects)
+	{
+		if (object.parentTransformIndex == -1)
+			continue;
+		const GW::MATH::GVECTORF& parent = level.levelTransforms[object.parentTransformIndex].row4;
+		int found = -1;
+		for (size_t t = 0; t < level.levelTransforms.size() && found == -1; t++)
+			if (level.levelTransforms[t].row4.x == parent.x && level.levelTransforms[t].row4.y == parent.y &&
+				level.levelTransforms[t].row4.z == parent.z)
+				found = static_cast<int>(t);
+		wrongParents += found != object.parentTransformIndex ? 1 : 0;
+	}
+	return wrongParents;
+}
+
+//Imports 25k and 50k object hierarchies and prints how much longer parsing and linking twice the objects takes
+//Then a hand written level whose two roots share a position, the child belongs to the second
+inline void TestHierarchyScaling(TEST_CONTEXT& context)
+{
+	const unsigned depth = 4;
+	Level_Data half, full;
+	double halfTime = ImportHierarchy(context, half, 25000, depth);
+	double fullTime = ImportHierarchy(context, full, 50000, depth);
+	if (halfTime < 0 || fullTime < 0)
+		return;
+	std::printf("%u deep hierarchy parse & link: 25000 objects %.1f ms, 50000 objects %.1f ms, %.2fx for twice the objects\n",
+		depth, halfTime, fullTime, fullTime / halfTime);
+
+	auto matchStart = std::chrono::steady_clock::now();
+	unsigned wrongParents = MatchParentsByTranslation(full);
+	std::printf("matching parents by translation instead: %.1f ms more for 50000 objects, %u wrong parents\n",
+		MillisecondsSince(matchStart), wrongParents);
+
+	std::filesystem::path folder = std::filesystem::path("TestLevels") / "HierarchyShared";
+	std::filesystem::create_directories(folder);
+	std::filesystem::remove(folder / "GameLevel.lvl");
+	std::string gameLevel = (folder / "GameLevel.txt").string();
+	std::ofstream(gameLevel, std::ios::binary) <<
+		"MESH\nBarn.000\n<Matrix 4x4 (1, 0, 0, 0)\n            (0, 1, 0, 0)\n            (0, 0, 1, 0)\n            (3, 0, 3, 1)>\n"
+		"MESH\nCow.001\n<Matrix 4x4 (1, 0, 0, 0)\n            (0, 1, 0, 0)\n            (0, 0, 1, 0)\n            (3, 0, 3, 1)>\n"
+		"  MESH\n  Pig.002\n  <Matrix 4x4 (1, 0, 0, 0)\n              (0, 1, 0, 0)\n              (0, 0, 1, 0)\n              (5, 0, 3, 1)>\n";
+	Level_Data shared;
+	if (Check(context, shared.CookLevel(gameLevel.c_str(), GetModelsFolder(context, "Level1").c_str(), context.log), "HierarchyShared import") == false)
+		return;
+	int transforms[3] = { -1, -1, -1 }, pigParent = -2;
+	for (const Level_Data::BLENDER_OBJECT& object : shared.blenderObjects)
+	{
+		unsigned number = std::strtoul(std::strrchr(object.blendername, '.') + 1, nullptr, 10);
+		transforms[number] = static_cast<int>(object.transformIndex);
+		pigParent = number == 2 ? object.parentTransformIndex : pigParent;
+	}
+	Check(context, shared.blenderObjects.size() == 3 && pigParent == transforms[1] && transforms[0] != transforms[1],
+		"the child of the second of two roots at one position has parent " + std::to_string(pigParent));
+	std::printf("two roots at one position: matching by translation links %u of 1 children wrong\n", MatchParentsByTranslation(shared));
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+//Cooks a level with one import worker and again with several, the two cooked files have to match byte for byte
+//A cook lays every section out in a fixed order, so any difference in any section shows up in the file
+inline void TestParallelImport(TEST_CONTEXT& context)
+{
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		std::string gameLevel = PrepareLevel(context, levelName);
+		std::string models = GetModelsFolder(context, levelName);
+		std::string cooked = Level_Data::GetCookedLevelPath(gameLevel.c_str());
+
+		Level_Data serial;
+		serial.importWorkers = 1;
+		auto serialStart = std::chrono::steady_clock::now();
+		if (Check(context, serial.CookLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " serial import") == false)
+			continue;
+		double serialTime = MillisecondsSince(serialStart);
+		std::vector<char> serialBytes = ReadFileBytes(cooked);
+
+		Level_Data parallel;
+		parallel.importWorkers = 8;
+		auto parallelStart = std::chrono::steady_clock::now();
+		if (Check(context, parallel.CookLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " parallel import") == false)
+			continue;
+		double parallelTime = MillisecondsSince(parallelStart);
+		std::vector<char> parallelBytes = ReadFileBytes(cooked);
+
+		size_t firstDifference = 0;
+		while (firstDifference < serialBytes.size() && firstDifference < parallelBytes.size() &&
+			serialBytes[firstDifference] == parallelBytes[firstDifference])
+			firstDifference++;
+		Check(context, serialBytes.empty() == false && serialBytes.size() == parallelBytes.size() && firstDifference == serialBytes.size(),
+			std::string(levelName) + " cooked with 8 workers differs from 1 worker at byte " + std::to_string(firstDifference));
+		std::printf("%s: %zu cooked bytes, 1 worker %.1f ms, 8 workers %.1f ms\n", levelName, serialBytes.size(), serialTime, parallelTime);
+	}
+}
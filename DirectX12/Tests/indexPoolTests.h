@@ -0,0 +1,120 @@
+#pragma once
+
+//Writes TestLevels/Pools, Level1's cow and barn next to a 260 x 260 vertex grid whose indices only fit the 32 bit pool
+inline std::string WritePoolsLevel(const TEST_CONTEXT& context)
+{
+	std::filesystem::path models = std::filesystem::path("TestLevels") / "Pools" / "Models";
+	std::filesystem::create_directories(models);
+	for (const char* model : { "Cow.h2b", "Barn.h2b" })
+		std::filesystem::copy_file(std::filesystem::path(GetModelsFolder(context, "Level1")) / model, models / model,
+			std::filesystem::copy_options::overwrite_existing);
+	WriteGridModel((models / "Grid.h2b").string(), 260);
+	return WriteSyntheticLevel("Pools", 6, { "Grid", "Cow", "Barn" }, 8);
+}
+
+//Every model's indices read back from its pool, and the pool is the narrowest one they fit
+inline unsigned CountBadPoolModels(const Level_Data& level)
+{
+	unsigned badModels = level.levelModelIndices.size() == level.levelModels.size() ? 0 : 1;
+	for (unsigned m = 0; m < level.levelModels.size() && badModels == 0; m++)
+	{
+		const Level_Data::LEVEL_MODEL& model = level.levelModels[m];
+		const Index_Pool_Builder::MODEL_INDICES& placement = level.levelModelIndices[m];
+		unsigned largest = 0;
+		bool same = true;
+		for (unsigned i = 0; i < model.indexCount; i++)
+		{
+			unsigned index = level.levelIndexView[model.indexStart + i];
+			largest = std::max(largest, index);
+			if (placement.pool == SHORT_INDEX_POOL)
+				same = same && placement.indexStart + i < level.levelShortIndexView.size() &&
+					level.levelShortIndexView[placement.indexStart + i] == index;
+			else
+				same = same && placement.indexStart + i < level.levelLongIndexView.size() &&
+					level.levelLongIndexView[placement.indexStart + i] == index;
+		}
+		badModels += same && (placement.pool == SHORT_INDEX_POOL) == (largest <= 0xFFFF) ? 0 : 1;
+	}
+	return badModels;
+}
+
+//Cooks Level1, Level2 and a level with a model too big for 16 bit indices, imported and mapped the pools must hold
+//every model's indices, and every draw a frame records has to read its mesh's LOD indices through the buffer it bound
+inline void TestIndexPools(TEST_CONTEXT& context)
+{
+	for (const char* levelName : { "Level1", "Level2", "Pools" })
+	{
+		bool pools = std::strcmp(levelName, "Pools") == 0;
+		std::string gameLevel = pools ? WritePoolsLevel(context) : PrepareLevel(context, levelName);
+		std::string models = pools ? "TestLevels/Pools/Models" : GetModelsFolder(context, levelName);
+		Level_Data imported, level;
+		if (Check(context, imported.LoadLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " import") == false ||
+			Check(context, level.LoadLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " cooked load") == false)
+			continue;
+		Check(context, level.levelShortIndices.empty() && level.levelLongIndices.empty(),
+			std::string(levelName) + " pools were copied out of the mapped level");
+		Check(context, CountBadPoolModels(imported) == 0 && CountBadPoolModels(level) == 0,
+			std::string(levelName) + " has models whose pool does not hold their indices");
+		Check(context, imported.levelShortIndices.size() == level.levelShortIndexView.size() &&
+			imported.levelLongIndices.size() == level.levelLongIndexView.size() &&
+			std::equal(level.levelShortIndexView.begin(), level.levelShortIndexView.end(), imported.levelShortIndices.begin()) &&
+			std::equal(level.levelLongIndexView.begin(), level.levelLongIndexView.end(), imported.levelLongIndices.begin()),
+			std::string(levelName) + " cooked pools differ from the imported ones");
+		if (pools)
+			Check(context, level.levelLongIndexView.size() > 0, "the grid did not go to the 32 bit pool");
+
+		//the camera sees every model of the synthetic level, LOD selection stays on so simplified draws get checked too
+		GW::MATH::GVECTORF eye = pools ? GW::MATH::GVECTORF{ 8, 30, -25, 1 } : GW::MATH::GVECTORF{ 0, 20, -40, 1 };
+		GW::MATH::GVECTORF at = pools ? GW::MATH::GVECTORF{ 8, 0, 8, 1 } : GW::MATH::GVECTORF{ 0, 0, 0, 1 };
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetOcclusionCulling(false);
+		frameRenderer.SetClusterCulling(false);
+		frameRenderer.SetCamera(MakeViewProjection(eye, at), eye);
+		frameRenderer.LinkChildrenToParent();
+		frameRenderer.Render(device.BeginFrame());
+		device.EndFrame();
+
+		const std::vector<Draw_Packet_Builder::DRAW_PACKET>& packets = frameRenderer.GetClusterCuller().GetDraws();
+		RENDER_BUFFER indices = 0;
+		unsigned draw = 0, badDraws = 0, geometryChanges = 0;
+		for (const RECORDED_COMMAND& command : device.GetRecordedFrame().GetCommands())
+			if (command.type == RECORDED_COMMAND_TYPE::SET_GEOMETRY)
+			{
+				indices = command.args[1];
+				geometryChanges++;
+			}
+			else if (command.type == RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED && draw < packets.size())
+			{
+				const Draw_Packet_Builder::DRAW_PACKET& packet = packets[draw++];
+				const Level_Data::LEVEL_MODEL& model = level.levelModels[packet.modelIndex];
+				const H2B::BATCH& lodDraw = level.levelLodDraws[level.levelLods[model.lodStart + packet.lod].drawStart + packet.meshIndex - model.meshStart];
+				const std::vector<char>& data = device.GetBufferData(indices);
+				unsigned stride = device.GetBufferDesc(indices).strideInBytes;
+				bool same = indices != 0 && command.args[0] == lodDraw.indexCount && static_cast<int>(command.args[3]) == static_cast<int>(model.vertexStart) &&
+					(command.args[2] + static_cast<size_t>(command.args[0])) * stride <= data.size();
+				for (unsigned i = 0; i < lodDraw.indexCount && same; i++)
+				{
+					const char* read = data.data() + (command.args[2] + static_cast<size_t>(i)) * stride;
+					unsigned index = stride == sizeof(uint16_t) ? *reinterpret_cast<const uint16_t*>(read) : *reinterpret_cast<const unsigned*>(read);
+					same = index == level.levelIndexView[model.indexStart + lodDraw.indexOffset + i];
+				}
+				badDraws += same ? 0 : 1;
+			}
+		Check(context, draw > 0 && draw == packets.size(), std::string(levelName) + " recorded " + std::to_string(draw) + " draws for " +
+			std::to_string(packets.size()) + " packets");
+		Check(context, badDraws == 0, std::string(levelName) + ": " + std::to_string(badDraws) + " draws read other indices than their LOD's");
+		if (pools)
+			Check(context, geometryChanges == 2, "the frame bound geometry " + std::to_string(geometryChanges) + " times for 2 pools");
+
+		//a pool change at a worker's first draw has to be rebound by that worker
+		Recording_Command_List single, split;
+		frameRenderer.SetRecordingWorkers(1);
+		frameRenderer.RecordDraws(single, packets);
+		frameRenderer.SetRecordingWorkers(4, 1);
+		frameRenderer.RecordDraws(split, packets);
+		Check(context, SameRecording(single, split), std::string(levelName) + ": 4 workers recorded different draws than 1");
+		std::printf("%s: %zu 16 bit and %zu 32 bit indices, %u draws, %u geometry binds\n", levelName, level.levelShortIndexView.size(),
+			level.levelLongIndexView.size(), draw, geometryChanges);
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+//One draw as the GPU would see it, the index buffer it reads and its INDIRECT_DRAW record
+struct SUBMITTED_DRAW
+{
+	RENDER_BUFFER indices;
+	INDIRECT_DRAW draw;
+};
+
+//Draws of a frame recorded with DrawIndexedInstanced, each with the instance start constant set before it
+inline std::vector<SUBMITTED_DRAW> ReadDirectDraws(const Recording_Command_List& frame)
+{
+	std::vector<SUBMITTED_DRAW> draws;
+	RENDER_BUFFER indices = 0;
+	unsigned instanceStart = 0;
+	for (const RECORDED_COMMAND& command : frame.GetCommands())
+		if (command.type == RECORDED_COMMAND_TYPE::SET_GEOMETRY)
+			indices = command.args[1];
+		else if (command.type == RECORDED_COMMAND_TYPE::SET_CONSTANT && command.args[0] == DRAW_CONSTANTS && command.args[1] == 0)
+			instanceStart = command.args[2];
+		else if (command.type == RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED)
+			draws.push_back({ indices, { instanceStart, command.args[0], command.args[1], command.args[2],
+				static_cast<int>(command.args[3]), command.args[4] } });
+	return draws;
+}
+
+//Draws of a frame submitted with ExecuteIndirect, read back from the argument buffer the commands point at
+inline std::vector<SUBMITTED_DRAW> ReadIndirectDraws(const Recording_Render_Device& device, const Recording_Command_List& frame)
+{
+	std::vector<SUBMITTED_DRAW> draws;
+	RENDER_BUFFER indices = 0;
+	for (const RECORDED_COMMAND& command : frame.GetCommands())
+		if (command.type == RECORDED_COMMAND_TYPE::SET_GEOMETRY)
+			indices = command.args[1];
+		else if (command.type == RECORDED_COMMAND_TYPE::EXECUTE_INDIRECT)
+		{
+			const std::vector<char>& arguments = device.GetBufferData(command.args[0]);
+			for (unsigned d = 0; d < command.args[2]; d++)
+			{
+				SUBMITTED_DRAW draw = { indices, {} };
+				std::memcpy(&draw.draw, arguments.data() + command.args[1] + d * sizeof(INDIRECT_DRAW), sizeof(INDIRECT_DRAW));
+				draws.push_back(draw);
+			}
+		}
+	return draws;
+}
+
+//Packs hand made packets, then renders Level1 & Level2 both ways, the argument buffers have to hold the direct draws in order
+inline void TestIndirectArguments(TEST_CONTEXT& context)
+{
+	std::vector<Draw_Packet_Builder::DRAW_PACKET> packets(3);
+	for (unsigned p = 0; p < 3; p++)
+	{
+		packets[p] = {};
+		packets[p].indexCount = 36 * (p + 1);
+		packets[p].instanceCount = p + 2;
+		packets[p].startIndex = 1000 * p;
+		packets[p].baseVertex = -static_cast<int>(p);
+		packets[p].instanceStart = 7 * p;
+	}
+	Indirect_Argument_Builder builder;
+	builder.Build(packets);
+	bool packed = builder.GetDrawCount() == 3 && builder.GetSizeInBytes() == 3 * sizeof(INDIRECT_DRAW);
+	for (unsigned p = 0; p < 3 && packed; p++)
+	{
+		const INDIRECT_DRAW& draw = builder.GetDraws()[p];
+		packed = draw.instanceStart == 7 * p && draw.indexCountPerInstance == 36 * (p + 1) && draw.instanceCount == p + 2 &&
+			draw.startIndexLocation == 1000 * p && draw.baseVertexLocation == -static_cast<int>(p) && draw.startInstanceLocation == 0;
+	}
+	Check(context, packed, "hand made packets packed into the wrong INDIRECT_DRAW records");
+	builder.Build({});
+	Check(context, builder.GetDrawCount() == 0 && builder.GetSizeInBytes() == 0, "no packets still left records behind");
+
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		Level_Data level;
+		std::string gameLevel = PrepareLevel(context, levelName);
+		if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, levelName).c_str(), context.log),
+			std::string(levelName) + " load") == false)
+			continue;
+		GW::MATH::GVECTORF eye = { 0.25f, 6.5f, -0.25f, 1 }, at = { 0, 0, 0, 1 };
+		Recording_Render_Device directDevice, indirectDevice;
+		Frame_Renderer direct(directDevice, level, context.log), indirect(indirectDevice, level, context.log);
+		indirect.SetIndirectDraws(true);
+		for (Frame_Renderer* frameRenderer : { &direct, &indirect })
+		{
+			Recording_Render_Device& device = frameRenderer == &direct ? directDevice : indirectDevice;
+			frameRenderer->SetCamera(MakeViewProjection(eye, at), eye);
+			frameRenderer->LinkChildrenToParent();
+			frameRenderer->Render(device.BeginFrame());
+			device.EndFrame();
+		}
+		std::vector<SUBMITTED_DRAW> directDraws = ReadDirectDraws(directDevice.GetRecordedFrame());
+		std::vector<SUBMITTED_DRAW> indirectDraws = ReadIndirectDraws(indirectDevice, indirectDevice.GetRecordedFrame());
+		Check(context, directDraws.empty() == false && directDraws.size() == indirectDraws.size() &&
+			std::memcmp(directDraws.data(), indirectDraws.data(), directDraws.size() * sizeof(SUBMITTED_DRAW)) == 0,
+			std::string(levelName) + " argument buffer does not hold the draws the direct path records");
+		Check(context, indirect.GetIndirectArgs().GetDrawCount() <= Indirect_Argument_Builder::MaxDraws(level),
+			std::string(levelName) + " drew more than MaxDraws");
+		std::printf("%s: %zu draws, %zu recorded commands direct, %zu indirect\n", levelName, directDraws.size(),
+			directDevice.GetRecordedFrame().GetCommands().size(), indirectDevice.GetRecordedFrame().GetCommands().size());
+	}
+}
+
+//Packing time of the argument buffer for a synthetic 100k object level's frame with one draw per instance
+inline void BenchmarkIndirectArguments(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	if (LoadSyntheticLevel(context, level, "Indirect", 100000, 2.5f) == false)
+		return;
+	GW::MATH::GVECTORF eye = { -20, 20, -20, 1 }, at = { 395, 0, 395, 1 };
+	Recording_Render_Device device;
+	Frame_Renderer frameRenderer(device, level, context.log);
+	frameRenderer.SetOcclusionCulling(false);
+	frameRenderer.SetCamera(MakeViewProjection(eye, at, 2000), eye);
+	frameRenderer.LinkChildrenToParent();
+	frameRenderer.Render(device.BeginFrame());
+	device.EndFrame();
+	std::vector<Draw_Packet_Builder::DRAW_PACKET> draws = ExpandInstances(frameRenderer.GetClusterCuller().GetDraws());
+
+	Indirect_Argument_Builder builder;
+	double bestTime = 0;
+	for (unsigned run = 0; run < 10; run++)
+	{
+		auto buildStart = std::chrono::steady_clock::now();
+		builder.Build(draws);
+		double buildTime = MillisecondsSince(buildStart);
+		bestTime = run == 0 || buildTime < bestTime ? buildTime : bestTime;
+	}
+	unsigned wrongRecords = 0;
+	for (size_t d = 0; d < draws.size(); d++)
+	{
+		const INDIRECT_DRAW& record = builder.GetDraws()[d];
+		wrongRecords += record.instanceStart != draws[d].instanceStart || record.indexCountPerInstance != draws[d].indexCount ||
+			record.instanceCount != 1 || record.startIndexLocation != draws[d].startIndex || record.baseVertexLocation != draws[d].baseVertex ? 1 : 0;
+	}
+	Check(context, builder.GetDrawCount() == draws.size() && wrongRecords == 0, std::to_string(wrongRecords) + " records differ from their packets");
+	Check(context, builder.GetDrawCount() <= Indirect_Argument_Builder::MaxDraws(level), "more records than MaxDraws");
+
+	Recording_Command_List recorded;
+	frameRenderer.RecordDraws(recorded, draws);
+	std::printf("%u draws: Build %.2f ms (%.1f ns per draw, %u bytes), recording them directly takes %zu commands\n",
+		builder.GetDrawCount(), bestTime, bestTime * 1e6 / builder.GetDrawCount(), builder.GetSizeInBytes(), recorded.GetCommands().size());
+}
@@ -0,0 +1,99 @@
+// Headless checks & benchmarks of the level pipeline, no window or GPU needed
+// Level_Renderer_Tests <test> <DirectX12 folder>, CMake registers every test below with CTest
+// The _bench tests print timings, build with CMAKE_BUILD_TYPE=Release before quoting them
+#define GATEWARE_ENABLE_CORE // All libraries need this
+#define GATEWARE_ENABLE_SYSTEM // GFile & GLog
+#define GATEWARE_ENABLE_MATH
+#include "../../gateware-main/Gateware.h"
+
+#include "../lvlData.h"
+#include "../simdMath.h"
+#include "../sceneHierarchy.h"
+#include "../levelBVH.h"
+#include "../frustumCulling.h"
+#include "../occlusionCulling.h"
+#include "../lodSelection.h"
+#include "../renderDevice.h"
+#include "../uploadRing.h"
+#include "../uploadBatcher.h"
+#include "../recordingDevice.h"
+#include "../vertexCompression.h"
+#include "../drawPackets.h"
+#include "../clusterCulling.h"
+#include "../instanceRecords.h"
+#include "../indirectArgs.h"
+#include "../transformUploads.h"
+#include "../frameRenderer.h"
+
+#include "testing.h"
+#include "importTests.h"
+#include "tokenizerTests.h"
+#include "hierarchyTests.h"
+#include "simdMathTests.h"
+#include "bvhTests.h"
+#include "recordingTests.h"
+#include "indirectArgsTests.h"
+#include "lodTests.h"
+#include "clusterTests.h"
+#include "occlusionTests.h"
+#include "indexPoolTests.h"
+#include "mappedLoadTests.h"
+#include "frustumTests.h"
+#include "drawListTests.h"
+#include "uploadRingTests.h"
+#include "transformUploadTests.h"
+#include "uploadBatcherTests.h"
+#include "vertexCompressionTests.h"
+#include "meshOptimizerTests.h"
+
+struct LEVEL_TEST
+{
+	const char* name;
+	void (*run)(TEST_CONTEXT& context);
+};
+
+static const LEVEL_TEST levelTests[] = {
+	{ "import_parallel", TestParallelImport },
+	{ "tokenizer_bench", BenchmarkTokenizer },
+	{ "hierarchy_linear", TestHierarchyScaling },
+	{ "simd_math", TestSimdMath },
+	{ "simd_math_bench", BenchmarkSimdMath },
+	{ "bvh_bench", BenchmarkLevelBVH },
+	{ "recording_workers", BenchmarkRecordingWorkers },
+	{ "indirect_args", TestIndirectArguments },
+	{ "indirect_args_bench", BenchmarkIndirectArguments },
+	{ "lod_selection", TestLodSelection },
+	{ "cluster_bench", BenchmarkClusterCulling },
+	{ "occlusion_culling", TestOcclusionCulling },
+	{ "index_pools", TestIndexPools },
+	{ "load_mapped_bench", BenchmarkMappedLoad },
+	{ "load_cook", CookMappedLevel },
+	{ "load_mapped", TestMappedLoad },
+	{ "load_copied", TestCopiedLoad },
+	{ "frustum_culling", TestFrustumCulling },
+	{ "draw_list", TestDrawList },
+	{ "upload_ring", TestUploadRing },
+	{ "transform_uploads", TestTransformUploads },
+	{ "upload_batcher", TestUploadBatcher },
+	{ "vertex_compression", TestVertexCompression },
+	{ "mesh_optimizer", TestMeshOptimizer },
+};
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3)
+		for (const LEVEL_TEST& test : levelTests)
+			if (std::strcmp(argv[1], test.name) == 0)
+			{
+				TEST_CONTEXT context;
+				context.dataFolder = argv[2];
+				context.log.Create("TestOutput.txt");
+				test.run(context);
+				std::printf("%s: %s\n", test.name, context.failures == 0 ? "passed" : "FAILED");
+				return context.failures == 0 ? 0 : 1;
+			}
+	std::printf("Usage: Level_Renderer_Tests <test> <DirectX12 folder>, tests:\n");
+	for (const LEVEL_TEST& test : levelTests)
+		std::printf("  %s\n", test.name);
+	return 2;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+//Every run a level has, as if the whole level passed the frustum
+inline std::vector<Frustum_Culler::VISIBLE_RUN> AllRuns(const Level_Data& level)
+{
+	std::vector<Frustum_Culler::VISIBLE_RUN> runs;
+	for (unsigned instance = 0; instance < level.levelInstances.size(); instance++)
+		runs.push_back({ instance, level.levelInstances[instance].transformStart, level.levelInstances[instance].transformCount });
+	return runs;
+}
+
+//Checks the LOD chains Level2 imports with, then Lod_Selector against placements whose answer is known:
+//a transform moving away never gets finer, a bigger threshold never draws more, disabled draws full detail,
+//and the triangles a frame records are the ones the selector's stats report
+inline void TestLodSelection(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	std::string gameLevel = PrepareLevel(context, "Level2");
+	if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, "Level2").c_str(), context.log), "Level2 load") == false)
+		return;
+
+	//LOD 0 draws the model's own meshes, every further LOD has fewer triangles, a larger error and valid indices
+	unsigned badLods = 0, chainedModels = 0;
+	for (const Level_Data::LEVEL_MODEL& model : level.levelModels)
+	{
+		chainedModels += model.lodCount > 1 ? 1 : 0;
+		unsigned previousTriangles = ~0u;
+		float previousError = -1;
+		for (unsigned lod = 0; lod < model.lodCount; lod++)
+		{
+			const Level_Data::LEVEL_LOD& levelLod = level.levelLods[model.lodStart + lod];
+			unsigned triangles = 0;
+			for (unsigned mesh = 0; mesh < model.meshCount; mesh++)
+			{
+				const H2B::BATCH& draw = level.levelLodDraws[levelLod.drawStart + mesh];
+				triangles += draw.indexCount / 3;
+				if (draw.indexOffset + draw.indexCount > model.indexCount)
+				{
+					badLods++;
+					continue;
+				}
+				for (unsigned i = draw.indexOffset; i < draw.indexOffset + draw.indexCount; i++)
+					badLods += level.levelIndexView[model.indexStart + i] >= model.vertexCount ? 1 : 0;
+				if (lod == 0)
+					badLods += draw.indexOffset != level.levelMeshes[model.meshStart + mesh].drawInfo.indexOffset ? 1 : 0;
+			}
+			badLods += lod > 0 && (triangles >= previousTriangles || levelLod.error < previousError) ? 1 : 0;
+			previousTriangles = triangles;
+			previousError = levelLod.error;
+		}
+	}
+	Check(context, chainedModels > 0 && badLods == 0, std::to_string(badLods) + " bad LODs, " + std::to_string(chainedModels) + " models with a chain");
+
+	Scene_Hierarchy hierarchy;
+	hierarchy.Build(level);
+	std::vector<GW::MATH::GMATRIXF> world;
+	hierarchy.CopyWorldTransforms(world);
+	std::vector<Frustum_Culler::VISIBLE_RUN> runs = AllRuns(level);
+	GW::MATH::GVECTORF eye = { 0, 60, -90, 1 }, at = { 0, 0, 0, 1 };
+	GW::MATH::GMATRIXF viewProjection = MakeViewProjection(eye, at);
+	Lod_Selector selector;
+	selector.Build(level);
+
+	//one instance of the model with the longest chain walked away from the camera along the view axis
+	unsigned chainInstance = 0;
+	for (unsigned instance = 0; instance < level.levelInstances.size(); instance++)
+		if (level.levelModels[level.levelInstances[instance].modelIndex].lodCount >
+			level.levelModels[level.levelInstances[chainInstance].modelIndex].lodCount)
+			chainInstance = instance;
+	const Level_Data::MODEL_INSTANCES& walked = level.levelInstances[chainInstance];
+	std::vector<Frustum_Culler::VISIBLE_RUN> walkedRun = { { chainInstance, walked.transformStart, 1 } };
+	std::vector<GW::MATH::GMATRIXF> walkedWorld = world;
+	unsigned previousLod = 0, farLod = 0, walkBackwards = 0;
+	GW::MATH::GVECTORF forward = { at.x - eye.x, at.y - eye.y, at.z - eye.z, 0 };
+	float forwardLength = std::sqrt(forward.x * forward.x + forward.y * forward.y + forward.z * forward.z);
+	for (float distance = 1; distance < 100000; distance *= 1.5f)
+	{
+		walkedWorld[walked.transformStart] = GW::MATH::GIdentityMatrixF;
+		float step = distance / forwardLength;
+		walkedWorld[walked.transformStart].row4 = { eye.x + forward.x * step, eye.y + forward.y * step, eye.z + forward.z * step, 1 };
+		selector.Select(level, walkedRun, walkedWorld, viewProjection);
+		farLod = selector.GetLod(walked.transformStart);
+		walkBackwards += farLod < previousLod ? 1 : 0;
+		previousLod = farLod;
+	}
+	unsigned chainLength = level.levelModels[walked.modelIndex].lodCount;
+	Check(context, walkBackwards == 0, "a transform moving away switched to a finer LOD " + std::to_string(walkBackwards) + " times");
+	Check(context, farLod + 1 == chainLength, "far away transform drew LOD " + std::to_string(farLod) + " of " + std::to_string(chainLength));
+
+	//the stats have to add up the triangles of the LODs picked
+	unsigned long long previousTriangles = ~0ull;
+	unsigned thresholdIncreases = 0;
+	for (float threshold : { 0.0f, 0.0005f, 0.001f, 0.004f, 0.016f })
+	{
+		selector.SetThreshold(threshold);
+		selector.Select(level, runs, world, viewProjection);
+		const Lod_Selector::LOD_STATS& stats = selector.GetStats();
+		unsigned long long triangles = 0, fullDetail = 0;
+		for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+		{
+			const Level_Data::LEVEL_MODEL& model = level.levelModels[level.levelInstances[run.instanceIndex].modelIndex];
+			for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+				for (unsigned mesh = 0; mesh < model.meshCount; mesh++)
+				{
+					triangles += level.levelLodDraws[level.levelLods[model.lodStart + selector.GetLod(transform)].drawStart + mesh].indexCount / 3;
+					fullDetail += level.levelLodDraws[level.levelLods[model.lodStart].drawStart + mesh].indexCount / 3;
+				}
+		}
+		Check(context, stats.triangles == triangles && stats.fullDetailTriangles == fullDetail, "LOD stats do not add up");
+		thresholdIncreases += triangles > previousTriangles ? 1 : 0;
+		if (threshold == 0)
+			Check(context, triangles == fullDetail, "threshold 0 drew simplified LODs");
+		std::printf("threshold %.4f: %llu of %llu triangles, instances per LOD %u %u %u %u\n", threshold, triangles, fullDetail,
+			stats.instances[0], stats.instances[1], stats.instances[2], stats.instances[3]);
+		previousTriangles = triangles;
+	}
+	Check(context, thresholdIncreases == 0, "a bigger threshold drew more triangles");
+	selector.SetEnabled(false);
+	selector.Select(level, runs, world, viewProjection);
+	Check(context, selector.GetStats().triangles == selector.GetStats().fullDetailTriangles, "disabled selection drew simplified LODs");
+
+	//a whole frame without meshlet splits or occlusion records exactly the selector's triangles
+	for (bool lods : { true, false })
+	{
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetClusterCulling(false);
+		frameRenderer.SetOcclusionCulling(false);
+		frameRenderer.SetLodSelection(lods);
+		frameRenderer.SetCamera(viewProjection, eye);
+		frameRenderer.LinkChildrenToParent();
+		frameRenderer.Render(device.BeginFrame());
+		device.EndFrame();
+		unsigned long long recorded = 0;
+		for (const RECORDED_COMMAND& command : device.GetRecordedFrame().GetCommands())
+			if (command.type == RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED)
+				recorded += static_cast<unsigned long long>(command.args[0] / 3) * command.args[1];
+		const Lod_Selector::LOD_STATS& stats = frameRenderer.GetLodSelector().GetStats();
+		Check(context, recorded == stats.triangles, "frame recorded " + std::to_string(recorded) + " triangles, the selector counted " +
+			std::to_string(stats.triangles));
+		Check(context, lods || stats.triangles == stats.fullDetailTriangles, "frame with LODs off drew simplified LODs");
+		std::printf("Level2 frame from (0, 60, -90) with LODs %s: %llu of %llu triangles\n", lods ? "on" : "off", stats.triangles, stats.fullDetailTriangles);
+	}
+}
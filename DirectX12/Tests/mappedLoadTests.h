@@ -0,0 +1,114 @@
+#pragma once
+#if defined(__linux__)
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+//TestLevels/Mapped, twelve 256 x 256 vertex grids that make about 70 MB of cooked geometry
+//Only the geometry matters here so the cook skips optimizing, LODs and meshlets, every load has to use the same settings
+inline std::string WriteMappedLevel(TEST_CONTEXT& context)
+{
+	std::filesystem::path models = std::filesystem::path("TestLevels") / "Mapped" / "Models";
+	std::filesystem::create_directories(models);
+	std::vector<std::string> names;
+	for (unsigned grid = 0; grid < 12; grid++)
+		names.push_back("Grid" + std::to_string(grid));
+	if (Check(context, WriteGridModel((models / "Grid0.h2b").string(), 256), "Grid0.h2b write") == false)
+		return "";
+	for (unsigned grid = 1; grid < names.size(); grid++)
+		std::filesystem::copy_file(models / "Grid0.h2b", models / (names[grid] + ".h2b"), std::filesystem::copy_options::overwrite_existing);
+	return WriteSyntheticLevel("Mapped", static_cast<unsigned>(names.size()), names, 30);
+}
+
+inline void ConfigureMappedLevel(Level_Data& level, bool mapped)
+{
+	level.mapCookedGeometry = mapped;
+	level.optimizeMeshes = false;
+	level.generateLods = false;
+	level.buildMeshlets = false;
+}
+
+#if defined(__linux__)
+//Peak resident set of this process so far, ru_maxrss is in kilobytes on Linux
+inline double PeakResidentMegabytes()
+{
+	rusage usage = {};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+}
+#endif
+
+//Loads the level load_cook cooked and prints the peak resident set after LoadLevel and after the renderer uploads it
+//Run in a fresh process so ru_maxrss only covers this load
+inline void LoadCookedLevel(TEST_CONTEXT& context, bool mapped)
+{
+#if defined(__linux__)
+	const char* mode = mapped ? "mapped" : "copied";
+	double startPeak = PeakResidentMegabytes();
+	std::string gameLevel = (std::filesystem::path("TestLevels") / "Mapped" / "GameLevel.txt").string();
+	if (Check(context, std::filesystem::exists(Level_Data::GetCookedLevelPath(gameLevel.c_str())),
+		"no cooked level, load_cook cooks it") == false)
+		return;
+	Level_Data level;
+	ConfigureMappedLevel(level, mapped);
+	auto loadStart = std::chrono::steady_clock::now();
+	if (Check(context, level.LoadLevel(gameLevel.c_str(), "TestLevels/Mapped/Models", context.log), std::string(mode) + " load") == false)
+		return;
+	double loadTime = MillisecondsSince(loadStart);
+	Check(context, level.levelVertices.empty() == mapped, std::string(mode) + " load did not " + (mapped ? "map" : "copy") + " the geometry");
+	double loadPeak = PeakResidentMegabytes();
+	{
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+	}
+	double uploadPeak = PeakResidentMegabytes();
+	std::printf("%s: %.1f ms load, peak RSS %.1f MB before, %.1f MB after LoadLevel, %.1f MB after the renderer uploads\n",
+		mode, loadTime, startPeak, loadPeak, uploadPeak);
+#else
+	std::printf("ru_maxrss needs Linux, skipped\n");
+#endif
+}
+
+inline void TestMappedLoad(TEST_CONTEXT& context) { LoadCookedLevel(context, true); }
+inline void TestCopiedLoad(TEST_CONTEXT& context) { LoadCookedLevel(context, false); }
+
+//Cooks the level load_mapped_bench wrote, with the settings every load of it uses
+inline void CookMappedLevel(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	ConfigureMappedLevel(level, true);
+	std::string gameLevel = (std::filesystem::path("TestLevels") / "Mapped" / "GameLevel.txt").string();
+	if (Check(context, level.CookLevel(gameLevel.c_str(), "TestLevels/Mapped/Models", context.log), "Mapped cook"))
+		std::printf("cooked %.1f MB: %zu vertices, %zu indices\n",
+			std::filesystem::file_size(Level_Data::GetCookedLevelPath(gameLevel.c_str())) / (1024.0 * 1024.0),
+			level.levelVertices.size(), level.levelIndices.size());
+}
+
+//Writes a level of about 70 MB of cooked geometry, then cooks it, loads it mapped and loads it copied, each in its own run of
+//this executable: Linux keeps ru_maxrss across exec, so nothing big may happen in this process before the loads start
+//The renderer uploads the compressed vertices and index pools, so a mapped level never reads its H2B vertices or 32 bit indices
+//The recording device keeps a copy of every buffer it is given, that part of the upload peak is the same both ways
+inline void BenchmarkMappedLoad(TEST_CONTEXT& context)
+{
+#if defined(__linux__)
+	if (WriteMappedLevel(context).empty())
+		return;
+	std::filesystem::remove(std::filesystem::path("TestLevels") / "Mapped" / "GameLevel.lvl");
+	std::fflush(stdout);
+	for (const char* test : { "load_cook", "load_mapped", "load_copied" })
+	{
+		char executable[] = "/proc/self/exe";
+		std::string dataFolder = context.dataFolder;
+		char* arguments[] = { executable, const_cast<char*>(test), &dataFolder[0], nullptr };
+		pid_t child = 0;
+		int status = -1;
+		bool ran = posix_spawn(&child, executable, nullptr, nullptr, arguments, environ) == 0 && waitpid(child, &status, 0) == child;
+		if (Check(context, ran && WIFEXITED(status) && WEXITSTATUS(status) == 0, std::string(test) + " failed") == false)
+			return;
+	}
+#else
+	std::printf("ru_maxrss needs Linux, skipped\n");
+#endif
+}
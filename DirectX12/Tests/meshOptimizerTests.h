@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <map>
+
+//Triangles of one index range of a model, sorted, each corner named by its vertex's contents since OptimizeVertexFetch
+//renumbers vertices, and every triangle turned to start at its lowest corner so only a change of winding tells
+inline std::vector<std::array<unsigned, 3>> GetRangeTriangles(const Level_Data& level, const Level_Data::LEVEL_MODEL& model,
+	const H2B::BATCH& range, std::map<std::string, unsigned>& vertexIds)
+{
+	std::vector<std::array<unsigned, 3>> triangles;
+	for (unsigned i = 0; i + 2 < range.indexCount; i += 3)
+	{
+		std::array<unsigned, 3> corners;
+		for (unsigned c = 0; c < 3; c++)
+		{
+			const H2B::VERTEX& vertex = level.levelVertexView[model.vertexStart + level.levelIndexView[model.indexStart + range.indexOffset + i + c]];
+			std::string bytes(reinterpret_cast<const char*>(&vertex), sizeof(H2B::VERTEX));
+			corners[c] = vertexIds.emplace(bytes, static_cast<unsigned>(vertexIds.size())).first->second;
+		}
+		unsigned lowest = corners[0] <= corners[1] && corners[0] <= corners[2] ? 0 : (corners[1] <= corners[2] ? 1 : 2);
+		std::rotate(corners.begin(), corners.begin() + lowest, corners.end());
+		triangles.push_back(corners);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+//Imports Level1 & Level2 as exported and again through the mesh optimizer, with and without optimizeOverdraw and with the
+//LODs and meshlets every level gets, every mesh and material batch has to keep its range, its vertex count and exactly
+//the triangles it was exported with, winding included
+inline void TestMeshOptimizer(TEST_CONTEXT& context)
+{
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		std::string gameLevel = PrepareLevel(context, levelName);
+		std::string models = GetModelsFolder(context, levelName);
+		Level_Data exported;
+		exported.optimizeMeshes = false;
+		exported.generateLods = false;
+		exported.buildMeshlets = false;
+		if (Check(context, exported.LoadLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " import as exported") == false)
+			continue;
+		std::map<std::string, unsigned> vertexIds;
+		for (bool overdraw : { false, true })
+		{
+			const std::string name = std::string(levelName) + (overdraw ? " with optimizeOverdraw" : " without optimizeOverdraw");
+			Level_Data optimized;
+			optimized.optimizeOverdraw = overdraw;
+			if (Check(context, optimized.LoadLevel(gameLevel.c_str(), models.c_str(), context.log), name + " import") == false ||
+				Check(context, optimized.levelModels.size() == exported.levelModels.size(), name + " has other models") == false)
+				continue;
+			unsigned ranges = 0, changedRanges = 0, reordered = 0;
+			unsigned long long triangles = 0;
+			for (unsigned m = 0; m < exported.levelModels.size(); m++)
+			{
+				const Level_Data::LEVEL_MODEL& before = exported.levelModels[m];
+				const Level_Data::LEVEL_MODEL& after = optimized.levelModels[m];
+				if (Check(context, std::strcmp(before.filename, after.filename) == 0 && before.vertexCount == after.vertexCount &&
+					before.meshCount == after.meshCount && before.materialCount == after.materialCount,
+					name + " " + before.filename + " changed its vertex, mesh or material count") == false)
+					continue;
+				//every mesh's draw range and every material batch
+				std::vector<std::pair<H2B::BATCH, H2B::BATCH>> modelRanges;
+				for (unsigned mesh = 0; mesh < before.meshCount; mesh++)
+					modelRanges.push_back({ exported.levelMeshes[before.meshStart + mesh].drawInfo, optimized.levelMeshes[after.meshStart + mesh].drawInfo });
+				for (unsigned batch = 0; batch < before.materialCount; batch++)
+					modelRanges.push_back({ exported.levelBatches[before.batchStart + batch], optimized.levelBatches[after.batchStart + batch] });
+				for (const std::pair<H2B::BATCH, H2B::BATCH>& range : modelRanges)
+				{
+					ranges++;
+					if (range.first.indexOffset != range.second.indexOffset || range.first.indexCount != range.second.indexCount)
+					{
+						changedRanges++;
+						continue;
+					}
+					std::vector<std::array<unsigned, 3>> exportedTriangles = GetRangeTriangles(exported, before, range.first, vertexIds);
+					changedRanges += exportedTriangles == GetRangeTriangles(optimized, after, range.second, vertexIds) ? 0 : 1;
+					triangles += exportedTriangles.size();
+					reordered += std::equal(exported.levelIndexView.begin() + before.indexStart + range.first.indexOffset,
+						exported.levelIndexView.begin() + before.indexStart + range.first.indexOffset + range.first.indexCount,
+						optimized.levelIndexView.begin() + after.indexStart + range.second.indexOffset) ? 0 : 1;
+				}
+			}
+			Check(context, changedRanges == 0, name + ": " + std::to_string(changedRanges) + " of " + std::to_string(ranges) +
+				" mesh and batch ranges lost, gained or turned triangles");
+			Check(context, reordered > 0, name + " reordered nothing");
+			std::printf("%s: %u mesh and batch ranges of %llu triangles, %u of them reordered\n", name.c_str(), ranges, triangles, reordered);
+		}
+	}
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <random>
+
+//A depth buffer every frustum visible triangle is drawn into, keeping which transform is nearest at each pixel center
+//Exact depths and a much finer grid than Occlusion_Culler's buffer, a transform with no pixel here is hidden
+struct REFERENCE_RENDER
+{
+	static const int width = 1024, height = 512;
+	std::vector<float> depth;
+	std::vector<int> transforms;
+
+	void Clear()
+	{
+		depth.assign(width * height, 1.0f);
+		transforms.assign(width * height, -1);
+	}
+
+	//Clips at the near plane like the culler, facing is decided by the caller in world space
+	void DrawTriangle(const GW::MATH::GVECTORF& a, const GW::MATH::GVECTORF& b, const GW::MATH::GVECTORF& c, int transform)
+	{
+		const GW::MATH::GVECTORF* corners[3] = { &a, &b, &c };
+		GW::MATH::GVECTORF polygon[4];
+		unsigned count = 0;
+		for (unsigned v = 0; v < 3; v++)
+		{
+			const GW::MATH::GVECTORF& from = *corners[v];
+			const GW::MATH::GVECTORF& to = *corners[(v + 1) % 3];
+			if (from.z >= 0)
+				polygon[count++] = from;
+			if ((from.z >= 0) != (to.z >= 0))
+			{
+				float t = from.z / (from.z - to.z);
+				polygon[count++] = { from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, 0, from.w + (to.w - from.w) * t };
+			}
+		}
+		double screen[4][3];
+		for (unsigned v = 0; v < count; v++)
+		{
+			screen[v][0] = (polygon[v].x / polygon[v].w * 0.5 + 0.5) * width;
+			screen[v][1] = (0.5 - polygon[v].y / polygon[v].w * 0.5) * height;
+			screen[v][2] = polygon[v].z / polygon[v].w;
+		}
+		for (unsigned v = 2; v < count; v++)
+			DrawScreenTriangle(screen[0], screen[v - 1], screen[v], transform);
+	}
+
+	//Either winding, in doubles so no pixel center is lost to rounding
+	void DrawScreenTriangle(const double* a, const double* b, const double* c, int transform)
+	{
+		double area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		if (area == 0)
+			return;
+		int x0 = std::max(0, static_cast<int>(std::ceil(std::min(a[0], std::min(b[0], c[0])) - 0.5)));
+		int x1 = std::min(width - 1, static_cast<int>(std::floor(std::max(a[0], std::max(b[0], c[0])) - 0.5)));
+		int y0 = std::max(0, static_cast<int>(std::ceil(std::min(a[1], std::min(b[1], c[1])) - 0.5)));
+		int y1 = std::min(height - 1, static_cast<int>(std::floor(std::max(a[1], std::max(b[1], c[1])) - 0.5)));
+		for (int y = y0; y <= y1; y++)
+			for (int x = x0; x <= x1; x++)
+			{
+				double px = x + 0.5, py = y + 0.5;
+				double w0 = (c[0] - b[0]) * (py - b[1]) - (c[1] - b[1]) * (px - b[0]);
+				double w1 = (a[0] - c[0]) * (py - c[1]) - (a[1] - c[1]) * (px - c[0]);
+				double w2 = (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+				if (area > 0 ? (w0 < 0 || w1 < 0 || w2 < 0) : (w0 > 0 || w1 > 0 || w2 > 0))
+					continue;
+				float z = static_cast<float>((w0 * a[2] + w1 * b[2] + w2 * c[2]) / area);
+				if (z >= 0 && z <= 1 && z < depth[y * width + x])
+				{
+					depth[y * width + x] = z;
+					transforms[y * width + x] = transform;
+				}
+			}
+	}
+};
+
+//Pixels of the reference render every transform of the runs wins, indexed like world
+inline std::vector<unsigned> RenderReferencePixels(REFERENCE_RENDER& reference, const Level_Data& level,
+	const std::vector<Frustum_Culler::VISIBLE_RUN>& runs, const std::vector<GW::MATH::GMATRIXF>& world,
+	const GW::MATH::GMATRIXF& viewProjection, const GW::MATH::GVECTORF& eye)
+{
+	reference.Clear();
+	std::vector<GW::MATH::GVECTORF> clipVertices, worldVertices;
+	for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+	{
+		const Level_Data::LEVEL_MODEL& model = level.levelModels[level.levelInstances[run.instanceIndex].modelIndex];
+		clipVertices.resize(model.vertexCount);
+		worldVertices.resize(model.vertexCount);
+		for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+		{
+			GW::MATH::GMATRIXF worldViewProjection;
+			SIMD_MATH::MultiplyMatrix(world[transform], viewProjection, worldViewProjection);
+			for (unsigned v = 0; v < model.vertexCount; v++)
+			{
+				const float* position = &level.levelVertexView[model.vertexStart + v].pos.x;
+				SIMD_MATH::TransformPoint(worldViewProjection, position, &clipVertices[v].x);
+				SIMD_MATH::TransformPoint(world[transform], position, &worldVertices[v].x);
+			}
+			for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+			{
+				const H2B::BATCH& draw = level.levelMeshes[mesh].drawInfo;
+				const unsigned* indices = level.levelIndexView.data + model.indexStart + draw.indexOffset;
+				for (unsigned i = 0; i + 2 < draw.indexCount; i += 3)
+				{
+					const GW::MATH::GVECTORF& a = worldVertices[indices[i]];
+					const GW::MATH::GVECTORF& b = worldVertices[indices[i + 1]];
+					const GW::MATH::GVECTORF& c = worldVertices[indices[i + 2]];
+					float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z }, e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+					float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+					if (n[0] * (eye.x - a.x) + n[1] * (eye.y - a.y) + n[2] * (eye.z - a.z) <= 0)
+						continue;
+					reference.DrawTriangle(clipVertices[indices[i]], clipVertices[indices[i + 1]], clipVertices[indices[i + 2]], static_cast<int>(transform));
+				}
+			}
+		}
+	}
+	std::vector<unsigned> pixels(world.size(), 0);
+	for (int transform : reference.transforms)
+		if (transform >= 0)
+			pixels[transform]++;
+	return pixels;
+}
+
+//Occlusion_Culler on Level1 & Level2 behind the frustum culler: how many of the frustum's transforms it drops, what that
+//costs, and that none of them has a pixel in a reference render of every frustum visible triangle
+//The printed hash of the culled transforms is what a -DSIMD_MATH_SCALAR build has to match
+inline void TestOcclusionCulling(TEST_CONTEXT& context)
+{
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		Level_Data level;
+		std::string gameLevel = PrepareLevel(context, levelName);
+		if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, levelName).c_str(), context.log),
+			std::string(levelName) + " load") == false)
+			continue;
+
+		//3 fixed cameras then random ones in the farm, every other one near the ground where buildings hide the most
+		std::vector<std::pair<GW::MATH::GVECTORF, GW::MATH::GVECTORF>> cameras = {
+			{ { 0.25f, 6.5f, -0.25f, 1 }, { 0, 0, 0, 1 } }, { { 0, 20, -40, 1 }, { 0, 0, 0, 1 } }, { { 0, 60, -90, 1 }, { 0, 0, 0, 1 } } };
+		std::mt19937 random(11);
+		std::uniform_real_distribution<float> ground(-20, 20), low(1, 4), high(0.5f, 12.5f), target(0, 3);
+		while (cameras.size() < 43)
+		{
+			GW::MATH::GVECTORF eye = { ground(random), cameras.size() % 2 ? low(random) : high(random), ground(random), 1 };
+			GW::MATH::GVECTORF at = { ground(random), target(random), ground(random), 1 };
+			cameras.push_back({ eye, at });
+		}
+
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetOcclusionCulling(false);
+		frameRenderer.SetLodSelection(false);
+		Occlusion_Culler culler;
+		culler.Build(level);
+		REFERENCE_RENDER reference;
+		unsigned long long tested = 0, occluded = 0, hidden = 0, falseCulls = 0, falsePixels = 0, occluders = 0;
+		unsigned long long culledHash = 14695981039346656037ull;
+		double cullTime = 0;
+		std::vector<char> kept;
+		for (const std::pair<GW::MATH::GVECTORF, GW::MATH::GVECTORF>& camera : cameras)
+		{
+			GW::MATH::GMATRIXF viewProjection = MakeViewProjection(camera.first, camera.second);
+			frameRenderer.SetCamera(viewProjection, camera.first);
+			frameRenderer.LinkChildrenToParent();
+			frameRenderer.Render(device.BeginFrame());
+			device.EndFrame();
+			const std::vector<Frustum_Culler::VISIBLE_RUN>& runs = frameRenderer.GetFrustumCuller().GetVisibleRuns();
+			const std::vector<GW::MATH::GMATRIXF>& world = frameRenderer.GetTransforms();
+			//best of 5 so a preempted run does not count
+			double bestTime = 0;
+			for (unsigned run = 0; run < 5; run++)
+			{
+				auto cullStart = std::chrono::steady_clock::now();
+				culler.Cull(level, runs, world, viewProjection);
+				double time = MillisecondsSince(cullStart);
+				bestTime = run == 0 || time < bestTime ? time : bestTime;
+			}
+			cullTime += bestTime;
+			const Occlusion_Culler::OCCLUSION_STATS& stats = culler.GetStats();
+			tested += stats.transformsTested;
+			occluded += stats.transformsOccluded;
+			occluders += stats.occluders;
+
+			kept.assign(world.size(), 0);
+			for (const Frustum_Culler::VISIBLE_RUN& run : culler.GetVisibleRuns())
+				for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+					kept[transform] = 1;
+			std::vector<unsigned> pixels = RenderReferencePixels(reference, level, runs, world, viewProjection, camera.first);
+			for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+				for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+				{
+					hidden += pixels[transform] == 0 ? 1 : 0;
+					if (kept[transform])
+						continue;
+					culledHash = (culledHash ^ transform) * 1099511628211ull;
+					falseCulls += pixels[transform] > 0 ? 1 : 0;
+					falsePixels += pixels[transform];
+				}
+			culledHash = (culledHash ^ 0xFFFFFFFFull) * 1099511628211ull;
+		}
+		Check(context, falseCulls == 0, std::string(levelName) + ": " + std::to_string(falseCulls) + " culled transforms have " +
+			std::to_string(falsePixels) + " visible pixels");
+		std::printf("%s: %zu cameras, %llu of %llu frustum visible transforms occluded (%.1f%%), the reference hides %llu (%.0f%% found)\n",
+			levelName, cameras.size(), occluded, tested, tested ? 100.0 * occluded / tested : 0.0, hidden, hidden ? 100.0 * occluded / hidden : 100.0);
+		std::printf("%s: %.1f occluders, %.3f ms per frame, %s path, culled transforms hash %016llx\n", levelName,
+			static_cast<double>(occluders) / cameras.size(), cullTime / cameras.size(),
+#if defined(SIMD_MATH_SSE)
+			"SSE",
+#else
+			"scalar",
+#endif
+			culledHash);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <thread>
+
+//True when both streams hold the same calls with the same arguments and constant/upload payloads
+inline bool SameRecording(const Recording_Command_List& a, const Recording_Command_List& b)
+{
+	if (a.GetCommands().size() != b.GetCommands().size())
+		return false;
+	for (size_t c = 0; c < a.GetCommands().size(); c++)
+	{
+		const RECORDED_COMMAND& left = a.GetCommands()[c];
+		const RECORDED_COMMAND& right = b.GetCommands()[c];
+		if (left.type != right.type || std::memcmp(left.args, right.args, sizeof(left.args)) != 0 || left.payloadSize != right.payloadSize ||
+			std::memcmp(a.GetPayload(left), b.GetPayload(right), left.payloadSize) != 0)
+			return false;
+	}
+	return true;
+}
+
+//The draws of a frame split into one draw per instance, what the frame would record without instancing
+inline std::vector<Draw_Packet_Builder::DRAW_PACKET> ExpandInstances(const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws)
+{
+	std::vector<Draw_Packet_Builder::DRAW_PACKET> instanceDraws;
+	for (const Draw_Packet_Builder::DRAW_PACKET& draw : draws)
+		for (unsigned instance = 0; instance < draw.instanceCount; instance++)
+		{
+			instanceDraws.push_back(draw);
+			instanceDraws.back().instanceStart = draw.instanceStart + instance;
+			instanceDraws.back().instanceCount = 1;
+		}
+	return instanceDraws;
+}
+
+//Frames of a synthetic level have to record the same stream with 1 to 16 workers as with one
+//Instancing leaves a frame with a draw per mesh & LOD, so the scaling numbers come from the same frame's draws recorded
+//one instance per draw, which is the draw count recording would face without instancing
+inline void BenchmarkRecordingWorkers(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	if (LoadSyntheticLevel(context, level, "Recording", 100000, 2.5f) == false)
+		return;
+	//the level is about 790 units square, the camera looks across it from a corner
+	GW::MATH::GVECTORF eye = { -20, 20, -20, 1 }, at = { 395, 0, 395, 1 };
+	GW::MATH::GMATRIXF viewProjection = MakeViewProjection(eye, at, 2000);
+	const unsigned workerCounts[] = { 1, 2, 4, 8, 12, 16 };
+	std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+	Recording_Command_List singleThreaded;
+	std::vector<Draw_Packet_Builder::DRAW_PACKET> instanceDraws;
+	for (unsigned workers : workerCounts)
+	{
+		//a fresh device per run so every run hands out the same buffers and upload offsets
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, level, context.log);
+		frameRenderer.SetRecordingWorkers(workers, 1);
+		frameRenderer.SetOcclusionCulling(false);
+		frameRenderer.SetCamera(viewProjection, eye);
+		for (unsigned frame = 0; frame < 2; frame++)
+		{
+			frameRenderer.LinkChildrenToParent();
+			frameRenderer.Render(device.BeginFrame());
+			device.EndFrame();
+		}
+		if (workers == 1)
+		{
+			singleThreaded = device.GetRecordedFrame();
+			instanceDraws = ExpandInstances(frameRenderer.GetClusterCuller().GetDraws());
+			continue;
+		}
+		unsigned draws = static_cast<unsigned>(frameRenderer.GetClusterCuller().GetDraws().size());
+		unsigned usedWorkers = static_cast<unsigned>(frameRenderer.GetWorkerDrawStart().size()) - 1;
+		Check(context, usedWorkers == std::min(workers, draws), std::to_string(usedWorkers) + " of " + std::to_string(workers) + " workers recorded");
+		Check(context, SameRecording(singleThreaded, device.GetRecordedFrame()),
+			std::to_string(workers) + " workers recorded a different frame than 1 worker");
+	}
+	std::printf("frame: %u draws for %u instances\n", singleThreaded.CountCommands(RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED),
+		static_cast<unsigned>(instanceDraws.size()));
+	if (Check(context, instanceDraws.size() >= 100000, "only " + std::to_string(instanceDraws.size()) + " instance draws") == false)
+		return;
+	instanceDraws.resize(100000);
+
+	Recording_Render_Device device;
+	Frame_Renderer frameRenderer(device, level, context.log);
+	Recording_Command_List reference, recorded;
+	double singleThreadedTime = 0;
+	for (unsigned workers : workerCounts)
+	{
+		frameRenderer.SetRecordingWorkers(workers);
+		double bestTime = 0;
+		for (unsigned run = 0; run < 5; run++)
+		{
+			recorded.Clear();
+			auto recordStart = std::chrono::steady_clock::now();
+			frameRenderer.RecordDraws(recorded, instanceDraws);
+			double recordTime = MillisecondsSince(recordStart);
+			bestTime = run == 0 || recordTime < bestTime ? recordTime : bestTime;
+		}
+		if (workers == 1)
+		{
+			reference = recorded;
+			singleThreadedTime = bestTime;
+		}
+		else
+			Check(context, SameRecording(reference, recorded), std::to_string(workers) + " workers recorded different draws than 1 worker");
+		std::printf("%2u workers: %zu draws in %zu commands, best %.2f ms (%.2fx)\n", workers, instanceDraws.size(),
+			recorded.GetCommands().size(), bestTime, singleThreadedTime / bestTime);
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <random>
+
+//Random rotation, scale & translation, the affine matrices the level and the camera are made of
+inline GW::MATH::GMATRIXF RandomAffineMatrix(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f), scale(0.25f, 4), translation(-100, 100);
+	GW::MATH::GMATRIXF matrix;
+	GW::MATH::GMatrix::RotationYawPitchRollF(angle(random), angle(random), angle(random), matrix);
+	GW::MATH::GVECTORF scaling = { scale(random), scale(random), scale(random), 1 };
+	GW::MATH::GMatrix::ScaleGlobalF(matrix, scaling, matrix);
+	matrix.row4 = { translation(random), translation(random), translation(random), 1 };
+	return matrix;
+}
+
+//Compares SIMD_MATH against GMatrix: MultiplyMatrix & TransformMatrices bit for bit, AffineInverse to float precision
+//Whichever path simdMath.h picked for this build is the one checked, configure with -DSIMD_MATH_SCALAR for the scalar path
+inline void TestSimdMath(TEST_CONTEXT& context)
+{
+	const unsigned pairCount = 100000;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> value(-10, 10);
+	std::vector<GW::MATH::GMATRIXF> a(pairCount), b(pairCount);
+	for (unsigned i = 0; i < pairCount; i++)
+		for (int e = 0; e < 16; e++)
+		{
+			a[i].data[e] = value(random);
+			b[i].data[e] = value(random);
+		}
+
+	unsigned multiplyDifferences = 0, aliasDifferences = 0;
+	for (unsigned i = 0; i < pairCount; i++)
+	{
+		GW::MATH::GMATRIXF expected, result, aliased = a[i];
+		GW::MATH::GMatrix::MultiplyMatrixF(a[i], b[i], expected);
+		SIMD_MATH::MultiplyMatrix(a[i], b[i], result);
+		SIMD_MATH::MultiplyMatrix(aliased, b[i], aliased);
+		multiplyDifferences += std::memcmp(&expected, &result, sizeof(expected)) != 0 ? 1 : 0;
+		aliasDifferences += std::memcmp(&expected, &aliased, sizeof(expected)) != 0 ? 1 : 0;
+	}
+	Check(context, multiplyDifferences == 0, std::to_string(multiplyDifferences) + " of " + std::to_string(pairCount) +
+		" MultiplyMatrix results differ from GMatrix");
+	Check(context, aliasDifferences == 0, std::to_string(aliasDifferences) + " MultiplyMatrix results differ when out is a");
+
+	std::vector<GW::MATH::GMATRIXF> transformed(pairCount);
+	SIMD_MATH::TransformMatrices(a.data(), b[0], transformed.data(), pairCount);
+	unsigned transformDifferences = 0;
+	for (unsigned i = 0; i < pairCount; i++)
+	{
+		GW::MATH::GMATRIXF expected;
+		GW::MATH::GMatrix::MultiplyMatrixF(a[i], b[0], expected);
+		transformDifferences += std::memcmp(&expected, &transformed[i], sizeof(expected)) != 0 ? 1 : 0;
+	}
+	Check(context, transformDifferences == 0, std::to_string(transformDifferences) + " TransformMatrices results differ from GMatrix");
+
+	//inverses take different paths, so they only have to agree to float precision relative to the matrix's size
+	float worstInverse = 0;
+	for (unsigned i = 0; i < 10000; i++)
+	{
+		GW::MATH::GMATRIXF matrix = RandomAffineMatrix(random), expected, result;
+		GW::MATH::GMatrix::InverseF(matrix, expected);
+		if (Check(context, SIMD_MATH::AffineInverse(matrix, result), "AffineInverse called a scaled rotation singular") == false)
+			break;
+		for (int e = 0; e < 16; e++)
+			worstInverse = std::fmax(worstInverse, std::fabs(expected.data[e] - result.data[e]) / (std::fabs(expected.data[e]) + 1));
+	}
+	Check(context, worstInverse < 1e-4f, "AffineInverse is " + std::to_string(worstInverse) + " away from GMatrix::InverseF");
+	GW::MATH::GMATRIXF singular = {};
+	Check(context, SIMD_MATH::AffineInverse(singular, singular) == false, "AffineInverse inverted a zero matrix");
+	std::printf("%u multiplies & transforms bit identical to GMatrix, worst AffineInverse difference %g\n", pairCount, worstInverse);
+
+	//a camera at z = -10 looking down +z, 10 units ahead the frustum is tan(32.5) * 10 = 6.37 high and 11.33 wide each way
+	GW::MATH::GVECTORF planes[6];
+	SIMD_MATH::ExtractFrustumPlanes(MakeViewProjection({ 0, 0, -10, 1 }, { 0, 0, 0, 1 }), planes);
+	auto inside = [&planes](const GW::MATH::GVECTORF& point) {
+		for (const GW::MATH::GVECTORF& plane : planes)
+			if (plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w < 0)
+				return false;
+		return true;
+	};
+	const std::pair<GW::MATH::GVECTORF, bool> known[] = {
+		{ { 0, 0, 0, 1 }, true }, { { 0, 0, -9.85f, 1 }, true }, { { 0, 0, 89, 1 }, true },
+		{ { 11, 0, 0, 1 }, true }, { { -11, 0, 0, 1 }, true }, { { 0, 6.2f, 0, 1 }, true }, { { 0, -6.2f, 0, 1 }, true },
+		{ { 0, 0, -10.5f, 1 }, false }, { { 0, 0, -9.95f, 1 }, false }, { { 0, 0, 91, 1 }, false },
+		{ { 11.7f, 0, 0, 1 }, false }, { { -11.7f, 0, 0, 1 }, false }, { { 0, 6.6f, 0, 1 }, false }, { { 0, -6.6f, 0, 1 }, false } };
+	unsigned wrongKnown = 0;
+	for (const std::pair<GW::MATH::GVECTORF, bool>& point : known)
+		wrongKnown += inside(point.first) != point.second ? 1 : 0;
+	Check(context, wrongKnown == 0, std::to_string(wrongKnown) + " known points on the wrong side of ExtractFrustumPlanes");
+
+	//from an oblique camera the planes have to agree with clipping the projected point, away from the boundary
+	GW::MATH::GMATRIXF viewProjection = MakeViewProjection({ 30, 25, -40, 1 }, { -5, 2, 10, 1 });
+	SIMD_MATH::ExtractFrustumPlanes(viewProjection, planes);
+	std::uniform_real_distribution<float> coordinate(-120, 120);
+	unsigned tested = 0, wrongRandom = 0, insideCount = 0;
+	for (unsigned i = 0; i < 100000; i++)
+	{
+		GW::MATH::GVECTORF point = { coordinate(random), coordinate(random), coordinate(random), 1 }, clip;
+		GW::MATH::GMatrix::VectorXMatrixF(viewProjection, point, clip);
+		float margin = std::fabs(clip.w) * 1e-3f;
+		float distances[6] = { clip.w + clip.x, clip.w - clip.x, clip.w + clip.y, clip.w - clip.y, clip.z, clip.w - clip.z };
+		bool clipped = false, nearBoundary = false;
+		for (float distance : distances)
+		{
+			clipped = clipped || distance < 0;
+			nearBoundary = nearBoundary || std::fabs(distance) < margin;
+		}
+		if (nearBoundary)
+			continue;
+		tested++;
+		insideCount += clipped ? 0 : 1;
+		wrongRandom += inside(point) == clipped ? 1 : 0;
+	}
+	Check(context, wrongRandom == 0 && insideCount > 0, std::to_string(wrongRandom) + " of " + std::to_string(tested) +
+		" random points disagree with clip space, " + std::to_string(insideCount) + " inside");
+	std::printf("frustum planes: %zu known points, %u random points (%u inside) agree with clip space\n",
+		sizeof(known) / sizeof(known[0]), tested, insideCount);
+}
+
+//A million multiplies through GMatrix::MultiplyMatrixF and SIMD_MATH::MultiplyMatrix, over a working set that stays in cache
+inline void BenchmarkSimdMath(TEST_CONTEXT& context)
+{
+	const unsigned pairCount = 4096, rounds = 256;
+	std::mt19937 random(11);
+	std::vector<GW::MATH::GMATRIXF> a(pairCount), b(pairCount), gmatrixOut(pairCount), simdOut(pairCount), batchOut(pairCount);
+	for (unsigned i = 0; i < pairCount; i++)
+	{
+		a[i] = RandomAffineMatrix(random);
+		b[i] = RandomAffineMatrix(random);
+	}
+
+	//every round multiplies different pairs & sums one result, so no round can be skipped or hoisted
+	float gmatrixSum = 0, simdSum = 0;
+	auto gmatrixStart = std::chrono::steady_clock::now();
+	for (unsigned round = 0; round < rounds; round++)
+	{
+		for (unsigned i = 0; i < pairCount; i++)
+			GW::MATH::GMatrix::MultiplyMatrixF(a[i], b[(i + round) % pairCount], gmatrixOut[i]);
+		gmatrixSum += gmatrixOut[round].data[round % 16];
+	}
+	double gmatrixTime = MillisecondsSince(gmatrixStart);
+	auto simdStart = std::chrono::steady_clock::now();
+	for (unsigned round = 0; round < rounds; round++)
+	{
+		for (unsigned i = 0; i < pairCount; i++)
+			SIMD_MATH::MultiplyMatrix(a[i], b[(i + round) % pairCount], simdOut[i]);
+		simdSum += simdOut[round].data[round % 16];
+	}
+	double simdTime = MillisecondsSince(simdStart);
+	auto batchStart = std::chrono::steady_clock::now();
+	for (unsigned round = 0; round < rounds; round++)
+		SIMD_MATH::TransformMatrices(a.data(), b[round], batchOut.data(), pairCount);
+	double batchTime = MillisecondsSince(batchStart);
+
+	Check(context, std::memcmp(gmatrixOut.data(), simdOut.data(), sizeof(GW::MATH::GMATRIXF) * pairCount) == 0 && gmatrixSum == simdSum,
+		"SIMD_MATH and GMatrix multiplied differently");
+	GW::MATH::GMATRIXF lastBatch;
+	GW::MATH::GMatrix::MultiplyMatrixF(a[pairCount - 1], b[rounds - 1], lastBatch);
+	Check(context, std::memcmp(&lastBatch, &batchOut[pairCount - 1], sizeof(lastBatch)) == 0, "TransformMatrices and GMatrix multiplied differently");
+	std::printf("%u multiplies: GMatrix %.1f ms, SIMD_MATH %.1f ms (%.1fx), TransformMatrices %.1f ms (%.1fx)\n",
+		pairCount * rounds, gmatrixTime, simdTime, gmatrixTime / simdTime, batchTime, gmatrixTime / batchTime);
+}
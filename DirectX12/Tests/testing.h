@@ -0,0 +1,148 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//What every headless test gets: where the DirectX12 folder is, a log for the level loader and the failures so far
+struct TEST_CONTEXT
+{
+	std::string dataFolder;
+	GW::SYSTEM::GLog log;
+	unsigned failures = 0;
+};
+
+//Prints and counts a failed check, returns the condition so a test can stop early
+inline bool Check(TEST_CONTEXT& context, bool condition, const std::string& message)
+{
+	if (condition == false)
+	{
+		std::printf("FAILED: %s\n", message.c_str());
+		context.failures++;
+	}
+	return condition;
+}
+
+inline double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+}
+
+//Copies a shipped level's GameLevel.txt under the working directory so cooking it never writes into the source tree
+//Returns the copy, load it with GetModelsFolder as the .h2b folder
+inline std::string PrepareLevel(const TEST_CONTEXT& context, const char* levelName)
+{
+	std::filesystem::path folder = std::filesystem::path("TestLevels") / levelName;
+	std::filesystem::create_directories(folder);
+	std::filesystem::path gameLevel = folder / "GameLevel.txt";
+	std::filesystem::copy_file(std::filesystem::path(context.dataFolder) / levelName / "GameLevel.txt", gameLevel,
+		std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(folder / "GameLevel.lvl");
+	return gameLevel.string();
+}
+
+inline std::string GetModelsFolder(const TEST_CONTEXT& context, const char* levelName)
+{
+	return context.dataFolder + "/" + levelName + "/Models";
+}
+
+//Writes TestLevels/<levelName>/GameLevel.txt with objectCount objects in the exporter's layout, cycling through models
+//and laid out on a square grid spacing units apart, returns its path
+//With depth > 1 objects form chains of depth MESH entries, each indented under the one before it and half a spacing further
+inline std::string WriteSyntheticLevel(const char* levelName, unsigned objectCount, const std::vector<std::string>& models, float spacing,
+	unsigned depth = 1)
+{
+	std::filesystem::path folder = std::filesystem::path("TestLevels") / levelName;
+	std::filesystem::create_directories(folder);
+	std::filesystem::remove(folder / "GameLevel.lvl");
+	std::string gameLevel = (folder / "GameLevel.txt").string();
+	std::FILE* out = std::fopen(gameLevel.c_str(), "wb");
+	if (out == nullptr)
+		return gameLevel;
+	std::fprintf(out, "# Game Level Exporter v1.3\n");
+	const unsigned side = static_cast<unsigned>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+	for (unsigned object = 0; object < objectCount; object++)
+	{
+		//the exporter writes world matrices, children too
+		unsigned level = depth > 1 ? object % depth : 0, root = object - level;
+		float x = (root % side) * spacing + level * spacing * 0.5f, z = (root / side) * spacing;
+		std::string indent(level * 2, ' ');
+		std::fprintf(out, "%sMESH\n%s%s.%05u\n", indent.c_str(), indent.c_str(), models[object % models.size()].c_str(), object);
+		std::fprintf(out, "%s<Matrix 4x4 (1.0000, 0.0000, 0.0000, 0.0000)\n", indent.c_str());
+		std::fprintf(out, "            (0.0000, 1.0000, 0.0000, 0.0000)\n");
+		std::fprintf(out, "            (0.0000, 0.0000, 1.0000, 0.0000)\n");
+		std::fprintf(out, "            (%.4f, 0.0000, %.4f, 1.0000)>\n", x, z);
+	}
+	std::fclose(out);
+	return gameLevel;
+}
+
+//Writes a side x side vertex grid to an .h2b in the exporter's layout, one mesh and one material
+//The grid lies on the xz plane 0.1 units between vertices with a gentle wave in y so simplification has work to do
+inline bool WriteGridModel(const std::string& path, unsigned side)
+{
+	std::vector<H2B::VERTEX> vertices;
+	for (unsigned z = 0; z < side; z++)
+		for (unsigned x = 0; x < side; x++)
+		{
+			float u = static_cast<float>(x) / (side - 1), v = static_cast<float>(z) / (side - 1);
+			vertices.push_back({ { x * 0.1f, 0.2f * std::sin(u * 12.0f) * std::cos(v * 9.0f), z * 0.1f }, { u, v, 0 }, { 0, 1, 0 } });
+		}
+	std::vector<unsigned> indices;
+	for (unsigned z = 0; z + 1 < side; z++)
+		for (unsigned x = 0; x + 1 < side; x++)
+		{
+			unsigned corner = z * side + x;
+			for (unsigned index : { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 })
+				indices.push_back(index);
+		}
+	std::FILE* out = std::fopen(path.c_str(), "wb");
+	if (out == nullptr)
+		return false;
+	unsigned counts[4] = { static_cast<unsigned>(vertices.size()), static_cast<unsigned>(indices.size()), 1, 1 };
+	H2B::ATTRIBUTES attributes = {};
+	attributes.Kd = { 0.4f, 0.6f, 0.3f };
+	attributes.d = 1;
+	H2B::BATCH draw = { counts[1], 0 };
+	unsigned materialIndex = 0;
+	std::fwrite("019d", 1, 4, out);
+	std::fwrite(counts, sizeof(counts), 1, out);
+	std::fwrite(vertices.data(), sizeof(H2B::VERTEX), vertices.size(), out);
+	std::fwrite(indices.data(), sizeof(unsigned), indices.size(), out);
+	std::fwrite(&attributes, 80, 1, out);
+	//material name and nine empty texture paths
+	std::fwrite("Grid\0\0\0\0\0\0\0\0\0\0", 1, 14, out);
+	std::fwrite(&draw, sizeof(draw), 1, out);
+	std::fwrite("Grid\0", 1, 5, out);
+	std::fwrite(&draw, sizeof(draw), 1, out);
+	std::fwrite(&materialIndex, sizeof(materialIndex), 1, out);
+	return std::fclose(out) == 0;
+}
+
+//Writes a synthetic level with WriteSyntheticLevel and loads it with the shipped Level1 models
+inline bool LoadSyntheticLevel(TEST_CONTEXT& context, Level_Data& level, const char* levelName, unsigned objectCount, float spacing)
+{
+	std::string gameLevel = WriteSyntheticLevel(levelName, objectCount, { "Cow", "Pig", "Sheep", "Horse", "Barn", "Fence" }, spacing);
+	std::string models = GetModelsFolder(context, "Level1");
+	return Check(context, level.LoadLevel(gameLevel.c_str(), models.c_str(), context.log), std::string(levelName) + " load");
+}
+
+//View projection of a camera at eye looking at at, with the renderer's 65 degree 16:9 projection
+inline GW::MATH::GMATRIXF MakeViewProjection(GW::MATH::GVECTORF eye, GW::MATH::GVECTORF at, float farPlane = 100)
+{
+	GW::MATH::GMATRIXF view, projection, viewProjection;
+	GW::MATH::GVECTORF up = { 0, 1, 0, 0 };
+	GW::MATH::GMatrix::LookAtLHF(eye, at, up, view);
+	GW::MATH::GMatrix::ProjectionDirectXLHF(G_DEGREE_TO_RADIAN_F(65), 16.0f / 9.0f, 0.1f, farPlane, projection);
+	GW::MATH::GMatrix::MultiplyMatrixF(view, projection, viewProjection);
+	return viewProjection;
+}
+
+inline std::vector<char> ReadFileBytes(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
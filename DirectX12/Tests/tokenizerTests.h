@@ -0,0 +1,109 @@
+#pragma once
+
+//The GameLevel.txt reader before the tokenizer: GFile::ReadLine into a 1 KB buffer and sscanf at the exporter's column
+//Only understands unindented MESH entries, which is all the synthetic level holds
+inline unsigned ReadLevelLineByLine(const char* gameLevelPath, std::vector<GW::MATH::GMATRIXF>& outTransforms)
+{
+	GW::SYSTEM::GFile file;
+	file.Create();
+	if (-file.OpenTextRead(gameLevelPath))
+		return 0;
+	char linebuffer[1024];
+	while (+file.ReadLine(linebuffer, 1024, '\n'))
+	{
+		if (linebuffer[0] == '\0')
+			break;
+		if (std::strcmp(linebuffer, "MESH") != 0)
+			continue;
+		file.ReadLine(linebuffer, 1024, '\n');
+		GW::MATH::GMATRIXF transform;
+		for (int i = 0; i < 4; ++i)
+		{
+			file.ReadLine(linebuffer, 1024, '\n');
+			std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
+				&transform.data[0 + i * 4], &transform.data[1 + i * 4], &transform.data[2 + i * 4], &transform.data[3 + i * 4]);
+		}
+		outTransforms.push_back(transform);
+	}
+	file.CloseFile();
+	return static_cast<unsigned>(outTransforms.size());
+}
+
+//The same walk with the tokenizer ReadGameLevel uses now
+inline unsigned ReadLevelTokenized(const char* gameLevelPath, std::vector<GW::MATH::GMATRIXF>& outTransforms)
+{
+	std::vector<char> levelText;
+	if (Level_Data::ReadWholeFile(gameLevelPath, levelText) == false)
+		return 0;
+	const char* cursor = levelText.data();
+	const char* end = cursor + levelText.size();
+	Level_Data::LEVEL_LINE line;
+	while (Level_Data::NextLevelLine(cursor, end, line))
+	{
+		if (line.Equals("MESH") == false || Level_Data::NextLevelLine(cursor, end, line) == false)
+			continue;
+		GW::MATH::GMATRIXF transform;
+		if (Level_Data::ParseLevelMatrix(cursor, end, transform) == false)
+			break;
+		outTransforms.push_back(transform);
+	}
+	return static_cast<unsigned>(outTransforms.size());
+}
+
+//Objects per second of both readers on a synthetic 100k object level, they have to agree on every matrix
+//Also feeds the tokenizer layouts the old column offsets could not read
+inline void BenchmarkTokenizer(TEST_CONTEXT& context)
+{
+	const unsigned objectCount = 100000;
+	std::string gameLevel = WriteSyntheticLevel("Tokenizer", objectCount, { "Cow", "Pig", "Sheep", "Horse" }, 2.5f);
+
+	std::vector<GW::MATH::GMATRIXF> oldTransforms, newTransforms;
+	auto oldStart = std::chrono::steady_clock::now();
+	unsigned oldObjects = ReadLevelLineByLine(gameLevel.c_str(), oldTransforms);
+	double oldTime = MillisecondsSince(oldStart);
+	auto newStart = std::chrono::steady_clock::now();
+	unsigned newObjects = ReadLevelTokenized(gameLevel.c_str(), newTransforms);
+	double newTime = MillisecondsSince(newStart);
+
+	Check(context, oldObjects == objectCount && newObjects == objectCount,
+		"read " + std::to_string(oldObjects) + " and " + std::to_string(newObjects) + " of " + std::to_string(objectCount) + " objects");
+	Check(context, oldObjects == newObjects &&
+		std::memcmp(oldTransforms.data(), newTransforms.data(), sizeof(GW::MATH::GMATRIXF) * newObjects) == 0,
+		"tokenizer and sscanf read different matrices");
+	std::printf("%u objects: ReadLine + sscanf %.1f ms (%.0f objects/s), tokenizer %.1f ms (%.0f objects/s), %.1fx\n", objectCount,
+		oldTime, oldObjects / (oldTime / 1000), newTime, newObjects / (newTime / 1000), oldTime / newTime);
+
+	//tabs, \r\n, missing spaces, explicit signs & exponents and deep indentation
+	const char messy[] =
+		"# comment\r\n\r\n"
+		"\t\t\tMESH\r\n\t\t\tCow.001 \r\n"
+		"\t\t\t<Matrix 4x4 (1,0,0,0)\r\n(0,+1.0,0,0)\r\n   (0,  0,\t1e0, 0)\r\n(-2.5, 3.25e1, 0.125,1)>\r\n";
+	const char* cursor = messy;
+	const char* end = messy + sizeof(messy) - 1;
+	Level_Data::LEVEL_LINE line;
+	GW::MATH::GMATRIXF transform = {};
+	bool parsed = Level_Data::NextLevelLine(cursor, end, line) && line.Equals("# comment") &&
+		Level_Data::NextLevelLine(cursor, end, line) && line.Equals("MESH") && line.indent == 3 &&
+		Level_Data::NextLevelLine(cursor, end, line) && line.Equals("Cow.001") &&
+		Level_Data::ParseLevelMatrix(cursor, end, transform);
+	Check(context, parsed && transform.row2.y == 1 && transform.row3.z == 1 &&
+		transform.row4.x == -2.5f && transform.row4.y == 32.5f && transform.row4.z == 0.125f && transform.row4.w == 1,
+		"tokenizer misread the loosely formatted entry");
+	Check(context, Level_Data::NextLevelLine(cursor, end, line) == false, "tokenizer found a line after the last entry");
+
+	//a matrix cut short must fail instead of reading the rows of the MESH after it
+	const char truncated[] =
+		"MESH\nCow.001\n<Matrix 4x4 (1, 0, 0, 0)\n            (0, 1, 0, 0)\n"
+		"MESH\nPig.001\n<Matrix 4x4 (1, 0, 0, 0)\n            (0, 1, 0, 0)\n            (0, 0, 1, 0)\n            (5, 0, 5, 1)>\n";
+	cursor = truncated;
+	end = truncated + sizeof(truncated) - 1;
+	bool failed = Level_Data::NextLevelLine(cursor, end, line) && Level_Data::NextLevelLine(cursor, end, line) &&
+		Level_Data::ParseLevelMatrix(cursor, end, transform) == false;
+	Check(context, failed, "tokenizer read a truncated matrix");
+	const char noRows[] = "MESH\nCow.001\n<Matrix 4x4\n(1, 0, 0, 0)\n(0, 1, 0, 0)\n(0, 0, 1, 0)\n(0, 0, 0, 1)>\n";
+	cursor = noRows;
+	end = noRows + sizeof(noRows) - 1;
+	failed = Level_Data::NextLevelLine(cursor, end, line) && Level_Data::NextLevelLine(cursor, end, line) &&
+		Level_Data::ParseLevelMatrix(cursor, end, transform) == false;
+	Check(context, failed, "tokenizer looked past the <Matrix line for its first row");
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <set>
+
+//Transforms merged into the writes Transform_Uploader makes, as [begin, end) ranges
+inline std::vector<std::pair<unsigned, unsigned>> MergeDirtyTransforms(const std::set<unsigned>& dirty, unsigned mergeGap)
+{
+	std::vector<std::pair<unsigned, unsigned>> ranges;
+	for (unsigned transform : dirty)
+		if (ranges.empty() == false && transform <= ranges.back().second + mergeGap)
+			ranges.back().second = transform + 1;
+		else
+			ranges.push_back({ transform, transform + 1 });
+	return ranges;
+}
+
+//Renders Level1 on a recording device with 3 frames in flight, first static, then turning the windmill blades and two
+//other objects for a while, with some frames where nothing turns, then static again
+//Every frame the bound transform buffer has to hold the world transforms, and the uploader has to write exactly the
+//merged ranges of what changed since that frame's buffer was last recorded, nothing at all once every buffer caught up
+inline void TestTransformUploads(TEST_CONTEXT& context)
+{
+	Level_Data level;
+	std::string gameLevel = PrepareLevel(context, "Level1");
+	if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, "Level1").c_str(), context.log), "Level1 load") == false)
+		return;
+	const unsigned turning[] = { 31, 3, 17 };
+	const float degrees[] = { 90, 45, -30 }, deltaTime = 1 / 60.0f;
+	for (unsigned object : turning)
+		if (Check(context, object < level.blenderObjects.size(), "Level1 has no object " + std::to_string(object)) == false)
+			return;
+
+	Recording_Render_Device device(3);
+	Frame_Renderer frameRenderer(device, level, context.log);
+	GW::MATH::GVECTORF eye = { 0, 20, -40, 1 };
+	frameRenderer.SetCamera(MakeViewProjection(eye, { 0, 0, 0, 1 }), eye);
+	//the hierarchy the renderer keeps, turned the same way, tells which transforms changed every frame
+	Scene_Hierarchy hierarchy;
+	hierarchy.Build(level);
+	std::vector<std::set<unsigned>> dirty(device.GetFrameCount());
+	const unsigned mergeGap = 4;
+	unsigned badFrames = 0, wrongUploads = 0, movingFrames = 0;
+	unsigned long long movingBytes = 0, staticBytes = 0;
+	for (unsigned frame = 0; frame < 40; frame++)
+	{
+		bool moving = frame >= 4 && frame < 30 && frame % 5 != 0;
+		if (moving)
+			for (unsigned o = 0; o < 3; o++)
+			{
+				frameRenderer.RotateObjectY(turning[o], degrees[o], deltaTime);
+				unsigned transform = level.blenderObjects[turning[o]].transformIndex;
+				GW::MATH::GMATRIXF rotated;
+				GW::MATH::GMatrix::RotateYLocalF(hierarchy.GetLocal(transform), G_DEGREE_TO_RADIAN_F(degrees[o]) * deltaTime, rotated);
+				hierarchy.SetLocal(transform, rotated);
+			}
+		hierarchy.UpdateWorldTransforms();
+		for (std::set<unsigned>& frameDirty : dirty)
+			frameDirty.insert(hierarchy.GetChangedTransforms().begin(), hierarchy.GetChangedTransforms().end());
+
+		unsigned frameIndex = device.GetFrameIndex();
+		frameRenderer.LinkChildrenToParent();
+		frameRenderer.Render(device.BeginFrame());
+		device.EndFrame();
+
+		//the buffer the frame bound holds every world transform
+		const Recording_Command_List& commands = device.GetRecordedFrame();
+		RENDER_BUFFER bound = 0;
+		for (const RECORDED_COMMAND& command : commands.GetCommands())
+			if (command.type == RECORDED_COMMAND_TYPE::SET_RESOURCE && command.args[0] == TRANSFORM_RESOURCE)
+				bound = command.args[1];
+		const std::vector<GW::MATH::GMATRIXF>& world = frameRenderer.GetTransforms();
+		bool same = bound == frameRenderer.GetTransformUploads().GetBuffer(frameIndex) && device.IsLive(bound) &&
+			device.GetBufferData(bound).size() == world.size() * sizeof(GW::MATH::GMATRIXF) &&
+			std::memcmp(device.GetBufferData(bound).data(), world.data(), world.size() * sizeof(GW::MATH::GMATRIXF)) == 0;
+		for (unsigned t = 0; t < world.size() && same; t++)
+			same = std::memcmp(&world[t], &hierarchy.GetWorld(t), sizeof(GW::MATH::GMATRIXF)) == 0;
+		badFrames += same ? 0 : 1;
+
+		//and only the merged ranges of what changed since this buffer was last recorded were written into it
+		std::vector<std::pair<unsigned, unsigned>> ranges = MergeDirtyTransforms(dirty[frameIndex], mergeGap);
+		dirty[frameIndex].clear();
+		unsigned expectedBytes = 0, writes = 0, writtenBytes = 0;
+		for (const std::pair<unsigned, unsigned>& range : ranges)
+			expectedBytes += (range.second - range.first) * sizeof(GW::MATH::GMATRIXF);
+		for (const RECORDED_COMMAND& command : commands.GetCommands())
+			if (command.type == RECORDED_COMMAND_TYPE::WRITE_BUFFER && command.args[0] == bound)
+			{
+				const std::pair<unsigned, unsigned>& range = ranges[writes < ranges.size() ? writes : 0];
+				same = same && writes < ranges.size() && command.args[1] == range.first * sizeof(GW::MATH::GMATRIXF) &&
+					command.args[2] == (range.second - range.first) * sizeof(GW::MATH::GMATRIXF);
+				writtenBytes += command.args[2];
+				writes++;
+			}
+		const Transform_Uploader& uploads = frameRenderer.GetTransformUploads();
+		wrongUploads += same && writes == ranges.size() && writtenBytes == expectedBytes &&
+			uploads.GetBytesUploaded() == expectedBytes && uploads.GetRangesUploaded() == ranges.size() ? 0 : 1;
+		movingFrames += moving ? 1 : 0;
+		(moving ? movingBytes : staticBytes) += uploads.GetBytesUploaded();
+		if (frame < 4 || frame >= 30 + device.GetFrameCount())
+			Check(context, uploads.GetBytesUploaded() == 0, "static frame " + std::to_string(frame) + " uploaded " +
+				std::to_string(uploads.GetBytesUploaded()) + " bytes");
+	}
+	Check(context, badFrames == 0, std::to_string(badFrames) + " frames bound transforms that are not the world transforms");
+	Check(context, wrongUploads == 0, std::to_string(wrongUploads) + " frames uploaded other ranges than the merged dirty transforms");
+	Check(context, movingBytes > 0, "turning objects uploaded nothing");
+	std::printf("Level1: %u turning frames uploaded %.0f bytes a frame of %zu, the other frames %llu bytes in all\n", movingFrames,
+		static_cast<double>(movingBytes) / movingFrames, frameRenderer.GetTransforms().size() * sizeof(GW::MATH::GMATRIXF), staticBytes);
+}
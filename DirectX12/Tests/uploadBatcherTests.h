@@ -0,0 +1,85 @@
+#pragma once
+#include <random>
+
+//Bytes nothing else would write
+inline std::vector<char> RandomBytes(std::mt19937& random, size_t count)
+{
+	std::vector<char> bytes(count);
+	for (char& byte : bytes)
+		byte = static_cast<char>(random() & 0xFF);
+	return bytes;
+}
+
+//Fills STATIC buffers of a Recording_Render_Device through its Upload_Batcher over the Recording_Copy_Queue:
+//contents arrive with the first frame, a write bigger than a 4 MB staging block is split across blocks,
+//staging is only released once the copy fence passed its batch, and ReleaseBuffer lands every pending copy first
+inline void TestUploadBatcher(TEST_CONTEXT& context)
+{
+	std::mt19937 random(17);
+	Recording_Render_Device device;
+	const Upload_Batcher& batcher = device.GetUploadBatcher();
+	const Recording_Copy_Queue& queue = device.GetCopyQueue();
+	auto holds = [&device](RENDER_BUFFER buffer, unsigned offset, const std::vector<char>& bytes) {
+		const std::vector<char>& data = device.GetBufferData(buffer);
+		return offset + bytes.size() <= data.size() && std::memcmp(data.data() + offset, bytes.data(), bytes.size()) == 0;
+	};
+
+	//10 MB fills two blocks and half of a third, the small buffer shares the third
+	std::vector<char> bigData = RandomBytes(random, 10 * 1024 * 1024 + 123), smallData = RandomBytes(random, 1000);
+	RENDER_BUFFER big = device.CreateBuffer({ RENDER_BUFFER_TYPE::VERTICES, static_cast<unsigned>(bigData.size()), 4,
+		RENDER_BUFFER_USAGE::STATIC }, bigData.data());
+	RENDER_BUFFER small = device.CreateBuffer({ RENDER_BUFFER_TYPE::STRUCTURED, static_cast<unsigned>(smallData.size()), 4,
+		RENDER_BUFFER_USAGE::STATIC }, smallData.data());
+	std::vector<char> dynamicData = RandomBytes(random, 256);
+	RENDER_BUFFER dynamic = device.CreateBuffer({ RENDER_BUFFER_TYPE::STRUCTURED, static_cast<unsigned>(dynamicData.size()), 4,
+		RENDER_BUFFER_USAGE::DYNAMIC }, dynamicData.data());
+	Check(context, holds(dynamic, 0, dynamicData) && batcher.GetStats().bytesStaged == bigData.size() + smallData.size(),
+		"a DYNAMIC buffer went through the batcher");
+	Check(context, batcher.GetStats().stagingCreated == 3 && batcher.GetStats().copies == 4 && batcher.HasPendingCopies(),
+		"10 MB and 1000 bytes took " + std::to_string(batcher.GetStats().stagingCreated) + " staging blocks and " +
+		std::to_string(batcher.GetStats().copies) + " copies, not 3 and 4");
+	Check(context, queue.GetStats().copies == 0 && holds(big, 0, bigData) == false, "staged writes reached a buffer before a frame");
+
+	//the frame submits the batch, the GPU has not finished it while the frame records
+	device.BeginFrame();
+	Check(context, holds(big, 0, bigData) && holds(small, 0, smallData), "STATIC buffers do not hold their data in the first frame");
+	Check(context, queue.GetStats().copies == 4 && queue.GetStats().buffersFinished == 2 && queue.GetStats().submits == 1,
+		"the batch did not submit 4 copies and finish 2 buffers once");
+	Check(context, queue.GetRecordingFence().GetCompletedValue() < batcher.GetLastSubmitted() && queue.GetLiveStagingCount() == 3,
+		"staging was released before the copy fence passed");
+	device.EndFrame();
+	Check(context, queue.GetRecordingFence().GetCompletedValue() >= batcher.GetLastSubmitted() && queue.GetLiveStagingCount() == 3 &&
+		holds(big, 0, bigData) && holds(small, 0, smallData), "the first frame did not finish the copies, or lost them");
+	//the next flush finds the fence passed and releases everything
+	device.BeginFrame();
+	device.EndFrame();
+	Check(context, queue.GetLiveStagingCount() == 0 && batcher.GetStagingCount() == 0 && batcher.GetStats().stagingReleased == 3,
+		"staging was not released once the copy fence passed");
+
+	//a 5 MB write into the middle of the big buffer spans two new blocks and leaves the rest as it was
+	std::vector<char> patch = RandomBytes(random, 5 * 1024 * 1024);
+	const unsigned patchOffset = 3 * 1024 * 1024 + 7;
+	device.WriteBuffer(big, patchOffset, patch.data(), static_cast<unsigned>(patch.size()));
+	Check(context, batcher.GetStats().stagingCreated == 5 && batcher.GetStats().copies == 6,
+		"a 5 MB write did not span two staging blocks");
+	device.BeginFrame();
+	device.EndFrame();
+	std::copy(patch.begin(), patch.end(), bigData.begin() + patchOffset);
+	Check(context, holds(big, 0, bigData), "the big buffer does not hold the write over it");
+
+	//releasing a buffer with copies pending lands them, the other buffer's too, and frees their staging without a frame
+	std::vector<char> pendingData = RandomBytes(random, 3000), releasedData = RandomBytes(random, 2000);
+	RENDER_BUFFER pending = device.CreateBuffer({ RENDER_BUFFER_TYPE::INDICES, static_cast<unsigned>(pendingData.size()), 2,
+		RENDER_BUFFER_USAGE::STATIC }, pendingData.data());
+	RENDER_BUFFER released = device.CreateBuffer({ RENDER_BUFFER_TYPE::INDICES, static_cast<unsigned>(releasedData.size()), 2,
+		RENDER_BUFFER_USAGE::STATIC }, releasedData.data());
+	unsigned waits = queue.GetRecordingFence().GetWaitCount();
+	device.ReleaseBuffer(released);
+	Check(context, device.IsLive(released) == false && batcher.HasPendingCopies() == false && holds(pending, 0, pendingData),
+		"ReleaseBuffer left copies pending");
+	Check(context, queue.GetRecordingFence().GetWaitCount() == waits + 1 && queue.GetLiveStagingCount() == 0,
+		"ReleaseBuffer did not wait for the copies and release their staging");
+	std::printf("%llu bytes staged in %u copies, %u batches, %u staging blocks created and %u released\n",
+		batcher.GetStats().bytesStaged, batcher.GetStats().copies, batcher.GetStats().batches,
+		batcher.GetStats().stagingCreated, batcher.GetStats().stagingReleased);
+}
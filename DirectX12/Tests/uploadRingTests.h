@@ -0,0 +1,97 @@
+#pragma once
+#include <deque>
+#include <random>
+
+//Drives Upload_Ring with a Recording_Fence standing in for a GPU that runs up to 6 frames behind, over random sizes and
+//alignments, and checks every allocation against a model of the ring's free space: aligned, inside the buffer, clear of
+//every allocation the GPU may still read, and a wait only when the allocation did not fit
+//Then a single frame bigger than the ring has to fail without waiting on anything
+inline void TestUploadRing(TEST_CONTEXT& context)
+{
+	//One handed out range, start is a position that only grows like the ring's own head
+	struct RING_ALLOCATION
+	{
+		uint64_t start, size, fenceValue;
+	};
+	const uint64_t capacities[] = { 4096, 3000, 65536 + 100 };
+	const unsigned frameLags[] = { 0, 2, 4, 6 };
+	std::mt19937 random(3);
+	unsigned long long allocations = 0, badAllocations = 0, wrongStalls = 0, stalls = 0, wraps = 0;
+	for (uint64_t capacity : capacities)
+		for (unsigned maxLag : frameLags)
+		{
+			Recording_Fence fence;
+			Upload_Ring ring;
+			ring.Create(capacity, fence);
+			std::deque<RING_ALLOCATION> live;
+			uint64_t head = 0, tail = 0;
+			//a frame with its alignment padding fits in the ring by itself, so a wait always makes room
+			//but a few of them behind a lagging GPU do not
+			std::uniform_int_distribution<uint64_t> size(1, capacity / 6);
+			std::uniform_int_distribution<unsigned> count(0, 3), alignmentBits(0, 8), lag(0, maxLag);
+			//the model frees what the ring frees, a finished frame up to the end of its last allocation
+			auto reclaim = [&]() {
+				while (live.empty() == false && live.front().fenceValue <= fence.GetCompletedValue())
+				{
+					tail = live.front().start + live.front().size;
+					live.pop_front();
+				}
+			};
+			for (uint64_t frame = 1; frame <= 2000; frame++)
+			{
+				for (unsigned a = count(random); a > 0; a--)
+				{
+					uint64_t bytes = size(random), alignment = uint64_t(1) << alignmentBits(random);
+					reclaim();
+					//aligned after the last allocation, or at 0 when that would straddle the end of the buffer
+					uint64_t offset = head % capacity, aligned = (offset + alignment - 1) & ~(alignment - 1);
+					uint64_t start = aligned + bytes <= capacity ? head + aligned - offset : head + capacity - offset;
+					bool fits = start + bytes - tail <= capacity;
+					unsigned stallsBefore = ring.GetStallCount();
+					uint64_t outOffset = ~uint64_t(0);
+					bool allocated = ring.Allocate(bytes, alignment, outOffset);
+					bool stalled = ring.GetStallCount() != stallsBefore;
+					reclaim();
+					allocations++;
+					stalls += stalled ? 1 : 0;
+					wraps += start % capacity == 0 && head % capacity != 0 ? 1 : 0;
+					wrongStalls += stalled == !fits ? 0 : 1;
+					bool good = allocated && outOffset == start % capacity && outOffset % alignment == 0 && outOffset + bytes <= capacity;
+					for (const RING_ALLOCATION& other : live)
+					{
+						uint64_t otherOffset = other.start % capacity;
+						good = good && (outOffset + bytes <= otherOffset || otherOffset + other.size <= outOffset);
+					}
+					badAllocations += good ? 0 : 1;
+					if (allocated == false)
+						continue;
+					head = start + bytes;
+					live.push_back({ start, bytes, frame });
+					badAllocations += ring.GetUsed() == head - tail ? 0 : 1;
+				}
+				ring.FinishFrame(frame);
+				uint64_t behind = lag(random);
+				if (frame > behind)
+					fence.Complete(frame - behind);
+			}
+		}
+	Check(context, badAllocations == 0, std::to_string(badAllocations) + " of " + std::to_string(allocations) +
+		" allocations were misaligned, outside the ring, over live data or where the model did not expect them");
+	Check(context, wrongStalls == 0, std::to_string(wrongStalls) + " allocations waited with room left or did not wait on a full ring");
+	Check(context, stalls > 0 && wraps > 0, "the random frames never filled or wrapped the ring");
+	std::printf("%llu allocations, %llu waited for the GPU, %llu wrapped to the start\n", allocations, stalls, wraps);
+
+	//a frame that fills the ring by itself has nothing to wait for
+	Recording_Fence fence;
+	Upload_Ring ring;
+	ring.Create(1024, fence);
+	uint64_t offset = 0;
+	Check(context, ring.Allocate(1025, 1, offset) == false, "an allocation bigger than the ring was handed out");
+	bool first = ring.Allocate(300, 1, offset) && offset == 0 && ring.Allocate(300, 256, offset) && offset == 512;
+	Check(context, first && ring.Allocate(300, 256, offset) == false && fence.GetWaitCount() == 0 && ring.GetStallCount() == 0,
+		"a frame bigger than the ring did not fail, or waited on the fence");
+	//once that frame is finished the next one waits for it instead of failing
+	ring.FinishFrame(1);
+	Check(context, ring.Allocate(600, 1, offset) && offset == 0 && fence.GetWaitCount() == 1 && fence.GetCompletedValue() == 1,
+		"a full ring did not wait for the frame holding it");
+}
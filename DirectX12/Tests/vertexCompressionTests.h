@@ -0,0 +1,89 @@
+#pragma once
+
+//FloatToHalf of value has to be expected, prints the first few misses
+inline bool CheckHalf(TEST_CONTEXT& context, float value, uint16_t expected, unsigned& misses)
+{
+	uint16_t half = Vertex_Compressor::FloatToHalf(value);
+	if (half == expected)
+		return true;
+	if (misses++ < 8)
+		std::printf("FloatToHalf(%.9g) is 0x%04x, expected 0x%04x\n", value, half, expected);
+	return false;
+}
+
+//The half conversion over every half: each one round trips through float, the float halfway to the next half rounds to
+//whichever of the two is even and a float either side of it to the nearer one, which covers the subnormals and the step
+//from the largest half to infinity too, then Level1 & Level2 decode within the error -compress quoted when it was added:
+//positions within half a 16 bit step of their model's bounds, normals within 0.040 degrees and uvs within 1.6e-4, both
+//to the digit they were quoted
+inline void TestVertexCompression(TEST_CONTEXT& context)
+{
+	unsigned misses = 0, checks = 0;
+	for (uint32_t half = 0; half <= 0xFFFF; half++)
+	{
+		float value = Vertex_Compressor::HalfToFloat(static_cast<uint16_t>(half));
+		bool nan = (half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0;
+		uint16_t back = Vertex_Compressor::FloatToHalf(value);
+		checks++;
+		if (nan ? (back & 0x7C00) != 0x7C00 || (back & 0x3FF) == 0 || (back & 0x8000) != (half & 0x8000) : back != half)
+		{
+			if (misses++ < 8)
+				std::printf("0x%04x went to %.9g and back to 0x%04x\n", half, value, back);
+		}
+		//every finite half and the next one away from zero, 0x7C00 past the largest is infinity
+		if ((half & 0x7FFF) >= 0x7C00)
+			continue;
+		uint16_t next = static_cast<uint16_t>(half + 1);
+		float nextValue = (next & 0x7FFF) == 0x7C00 ? std::ldexp(half & 0x8000 ? -1.0f : 1.0f, 16) : Vertex_Compressor::HalfToFloat(next);
+		//12 significant bits at most, a float holds the midpoint exactly
+		float midpoint = static_cast<float>((static_cast<double>(value) + nextValue) / 2);
+		float outward = half & 0x8000 ? -INFINITY : INFINITY;
+		CheckHalf(context, midpoint, half & 1 ? next : static_cast<uint16_t>(half), misses);
+		CheckHalf(context, std::nextafter(midpoint, outward), next, misses);
+		CheckHalf(context, std::nextafter(midpoint, -outward), static_cast<uint16_t>(half), misses);
+		checks += 3;
+	}
+	//named edges on top of the sweep
+	const std::pair<float, uint16_t> edges[] = {
+		{ 0.0f, 0x0000 }, { -0.0f, 0x8000 }, { 1.0f, 0x3C00 }, { -2.0f, 0xC000 }, { 65504.0f, 0x7BFF }, { 65519.996f, 0x7BFF },
+		{ 65520.0f, 0x7C00 }, { 1e6f, 0x7C00 }, { -1e6f, 0xFC00 }, { INFINITY, 0x7C00 }, { -INFINITY, 0xFC00 },
+		{ std::ldexp(1.0f, -14), 0x0400 }, { std::ldexp(1.0f, -24), 0x0001 }, { std::ldexp(1.0f, -25), 0x0000 },
+		{ std::ldexp(3.0f, -25), 0x0002 }, { std::ldexp(1023.0f, -24), 0x03FF }, { 1e-10f, 0x0000 }, { -1e-10f, 0x8000 } };
+	for (const std::pair<float, uint16_t>& edge : edges)
+	{
+		CheckHalf(context, edge.first, edge.second, misses);
+		checks++;
+	}
+	uint16_t nan = Vertex_Compressor::FloatToHalf(NAN);
+	Check(context, (nan & 0x7C00) == 0x7C00 && (nan & 0x3FF) != 0, "NaN did not stay NaN");
+	Check(context, misses == 0, std::to_string(misses) + " of " + std::to_string(checks) + " half conversions rounded wrong");
+
+	//the decode error of every model of the shipped levels
+	const float positionBound = 0.5f / 65535, normalBound = 0.0405f, uvBound = 1.65e-4f;
+	for (const char* levelName : { "Level1", "Level2" })
+	{
+		Level_Data level;
+		std::string gameLevel = PrepareLevel(context, levelName);
+		if (Check(context, level.LoadLevel(gameLevel.c_str(), GetModelsFolder(context, levelName).c_str(), context.log),
+			std::string(levelName) + " load") == false)
+			continue;
+		Check(context, level.levelCompressedVertexView.size() == level.levelVertexView.size() &&
+			level.levelVertexQuantization.size() == level.levelModels.size(), std::string(levelName) + " has no compressed vertex per vertex");
+		Vertex_Compressor::MODEL_VERTEX_ERROR worst = {};
+		for (unsigned m = 0; m < level.levelModels.size(); m++)
+		{
+			const Level_Data::LEVEL_MODEL& model = level.levelModels[m];
+			Vertex_Compressor::MODEL_VERTEX_ERROR error = Vertex_Compressor::MeasureModelError(&level.levelVertexView[model.vertexStart],
+				&level.levelCompressedVertexView[model.vertexStart], model.vertexCount, level.levelVertexQuantization[m]);
+			worst.relativePositionError = std::fmax(worst.relativePositionError, error.relativePositionError);
+			worst.maxNormalDegrees = std::fmax(worst.maxNormalDegrees, error.maxNormalDegrees);
+			worst.maxUVError = std::fmax(worst.maxUVError, error.maxUVError);
+			Check(context, error.relativePositionError <= positionBound * 1.001f && error.maxNormalDegrees <= normalBound &&
+				error.maxUVError <= uvBound, std::string(levelName) + " " + model.filename + " decodes " +
+				std::to_string(error.relativePositionError) + " of its bounds, " + std::to_string(error.maxNormalDegrees) +
+				" degrees and " + std::to_string(error.maxUVError) + " uv off");
+		}
+		std::printf("%s: %zu vertices, worst %.5f%% of the bounds, %.4f degrees, %.2e uv\n", levelName, level.levelVertexView.size(),
+			100 * worst.relativePositionError, worst.maxNormalDegrees, worst.maxUVError);
+	}
+}
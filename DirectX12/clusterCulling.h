@@ -0,0 +1,204 @@
+#pragma once
+#include <cmath>
+
+//Splits the sorted draws of a frame into the ranges of their meshlets that can be seen
+//A meshlet is dropped once its sphere is outside the frustum or every triangle in it faces away from the camera
+class Cluster_Culler
+{
+public:
+	//What the last Cull kept, triangle counts are multiplied by the instances drawing them
+	struct CLUSTER_STATS
+	{
+		//Draws passed in and draws left once every visible meshlet range is its own draw
+		unsigned drawsIn, drawsOut;
+		//Meshlets of the draws that were split, and those no instance of their draw could see
+		unsigned clustersTested, frustumCulled, backfaceCulled;
+		//Draws kept whole because splitting them would have gone over the draw budget
+		unsigned overBudget;
+		unsigned long long trianglesIn, trianglesOut;
+	};
+
+private:
+	//The frustum and camera of one instance moved into its model space, so meshlet bounds are tested untransformed
+	struct MODEL_VIEW
+	{
+		GW::MATH::GVECTORF planes[6];
+		//Length of each plane's normal, how far a unit of model space reaches along it
+		float planeScales[6];
+		GW::MATH::GVECTORF eye;
+		//Mirrored or flattened transforms change which side faces the camera, they skip the cone test
+		bool backfaceTest;
+	};
+
+	std::vector<Draw_Packet_Builder::DRAW_PACKET>			mDraws;
+	std::vector<MODEL_VIEW>									mViews;
+	//Draws of more instances than this are kept whole, testing every meshlet per instance stops paying off
+	unsigned												mMaxInstances = 8;
+	//Most draws Cull may output, the argument and record space of a frame is sized for this many
+	unsigned												mMaxDraws = ~0u;
+	bool													mEnabled = true;
+	CLUSTER_STATS											mStats = {};
+
+public:
+
+	//Culls the meshlets of every full detail draw, LODs and meshes with a single meshlet pass through whole
+	//worldTransforms is indexed like Level_Data::levelTransforms and instanceTransforms like the packet builder's
+	//Never outputs more than max(draws.size(), SetMaxDraws), a split that would go over keeps its draw whole
+	void Cull(const Level_Data& level, const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws,
+		const std::vector<unsigned>& instanceTransforms, const std::vector<GW::MATH::GMATRIXF>& worldTransforms,
+		const GW::MATH::GMATRIXF& viewProjection, const GW::MATH::GVECTORF& eye)
+	{
+		mDraws.clear();
+		mStats = {};
+		mStats.drawsIn = static_cast<unsigned>(draws.size());
+		GW::MATH::GVECTORF planes[6];
+		SIMD_MATH::ExtractFrustumPlanes(viewProjection, planes);
+		for (size_t d = 0; d < draws.size(); d++)
+		{
+			const Draw_Packet_Builder::DRAW_PACKET& draw = draws[d];
+			unsigned long long triangles = static_cast<unsigned long long>(draw.indexCount / 3) * draw.instanceCount;
+			mStats.trianglesIn += triangles;
+			const Level_Data::LEVEL_MESHLET_RANGE& range = level.levelMeshletRanges[draw.meshIndex];
+			if (mEnabled == false || draw.lod != 0 || range.meshletCount < 2 || draw.instanceCount > mMaxInstances)
+			{
+				mDraws.push_back(draw);
+				mStats.trianglesOut += triangles;
+				continue;
+			}
+
+			mViews.resize(draw.instanceCount);
+			for (unsigned instance = 0; instance < draw.instanceCount; instance++)
+				BuildView(worldTransforms[instanceTransforms[draw.instanceStart + instance]], planes, eye, mViews[instance]);
+
+			//Meshlets cover the mesh's indices in order, so neighbouring visible meshlets are one range
+			const unsigned meshStart = draw.startIndex - level.levelMeshes[draw.meshIndex].drawInfo.indexOffset;
+			const size_t splitStart = mDraws.size();
+			const unsigned long long trianglesBefore = mStats.trianglesOut;
+			Draw_Packet_Builder::DRAW_PACKET* open = nullptr;
+			for (unsigned m = range.meshletStart; m < range.meshletStart + range.meshletCount; m++)
+			{
+				const Level_Data::LEVEL_MESHLET& meshlet = level.levelMeshlets[m];
+				mStats.clustersTested++;
+				if (IsVisible(meshlet) == false)
+				{
+					open = nullptr;
+					continue;
+				}
+				mStats.trianglesOut += static_cast<unsigned long long>(meshlet.indexCount / 3) * draw.instanceCount;
+				if (open != nullptr)
+				{
+					open->indexCount += meshlet.indexCount;
+					continue;
+				}
+				mDraws.push_back(draw);
+				open = &mDraws.back();
+				open->startIndex = meshStart + meshlet.indexOffset;
+				open->indexCount = meshlet.indexCount;
+			}
+			//Every draw still to come needs at least one slot of the budget
+			if (mDraws.size() + (draws.size() - d - 1) > mMaxDraws)
+			{
+				mDraws.resize(splitStart);
+				mDraws.push_back(draw);
+				mStats.trianglesOut = trianglesBefore + triangles;
+				mStats.overBudget++;
+			}
+		}
+		mStats.drawsOut = static_cast<unsigned>(mDraws.size());
+	}
+
+	//Disabled every draw passes through whole
+	void SetEnabled(bool enabled) { mEnabled = enabled; }
+	bool IsEnabled() const { return mEnabled; }
+	void SetMaxInstances(unsigned maxInstances) { mMaxInstances = maxInstances; }
+	void SetMaxDraws(unsigned maxDraws) { mMaxDraws = maxDraws; }
+
+	const std::vector<Draw_Packet_Builder::DRAW_PACKET>& GetDraws() const { return mDraws; }
+	const CLUSTER_STATS& GetStats() const { return mStats; }
+
+private:
+
+	static float Dot3(const GW::MATH::GVECTORF& a, const GW::MATH::GVECTORF& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static GW::MATH::GVECTORF Cross3(const GW::MATH::GVECTORF& a, const GW::MATH::GVECTORF& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0 };
+	}
+
+	//World points are model points times world, so a world plane p becomes world * p in model space
+	//and the eye is found by solving model * world = eye for the 3x3 part with Cramer's rule
+	static void BuildView(const GW::MATH::GMATRIXF& world, const GW::MATH::GVECTORF (&planes)[6],
+		const GW::MATH::GVECTORF& eye, MODEL_VIEW& out)
+	{
+		for (unsigned p = 0; p < 6; p++)
+		{
+			const GW::MATH::GVECTORF& plane = planes[p];
+			out.planes[p] = {
+				Dot3(world.row1, plane), Dot3(world.row2, plane), Dot3(world.row3, plane),
+				Dot3(world.row4, plane) + plane.w };
+			out.planeScales[p] = std::sqrt(Dot3(out.planes[p], out.planes[p]));
+		}
+		GW::MATH::GVECTORF offset = { eye.x - world.row4.x, eye.y - world.row4.y, eye.z - world.row4.z, 0 };
+		float determinant = Dot3(world.row1, Cross3(world.row2, world.row3));
+		out.backfaceTest = determinant > 0;
+		if (out.backfaceTest == false)
+			return;
+		out.eye = {
+			Dot3(offset, Cross3(world.row2, world.row3)) / determinant,
+			Dot3(world.row1, Cross3(offset, world.row3)) / determinant,
+			Dot3(world.row1, Cross3(world.row2, offset)) / determinant, 1 };
+	}
+
+	//Visible to any instance of the draw, stats count meshlets no instance sees
+	bool IsVisible(const Level_Data::LEVEL_MESHLET& meshlet)
+	{
+		bool inFrustum = false;
+		for (const MODEL_VIEW& view : mViews)
+		{
+			if (IsInFrustum(meshlet, view) == false)
+				continue;
+			inFrustum = true;
+			if (FacesAway(meshlet, view) == false)
+				return true;
+		}
+		if (inFrustum)
+			mStats.backfaceCulled++;
+		else
+			mStats.frustumCulled++;
+		return false;
+	}
+
+	static bool IsInFrustum(const Level_Data::LEVEL_MESHLET& meshlet, const MODEL_VIEW& view)
+	{
+		const GW::MATH::GSPHEREF& sphere = meshlet.sphere;
+		for (unsigned p = 0; p < 6; p++)
+		{
+			const GW::MATH::GVECTORF& plane = view.planes[p];
+			float distance = plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w;
+			if (distance < -sphere.radius * view.planeScales[p])
+				return false;
+		}
+		return true;
+	}
+
+	//Every normal is within the cone's angle a of its axis and every point within the sphere, so with the camera
+	//at distance d from the center and angle t off the axis, all triangles face away once d * cos(t + a) > radius
+	static bool FacesAway(const Level_Data::LEVEL_MESHLET& meshlet, const MODEL_VIEW& view)
+	{
+		const float cutoff = meshlet.cone.w;
+		if (view.backfaceTest == false || !(cutoff > 0))
+			return false;
+		const GW::MATH::GSPHEREF& sphere = meshlet.sphere;
+		GW::MATH::GVECTORF toCenter = { sphere.x - view.eye.x, sphere.y - view.eye.y, sphere.z - view.eye.z, 0 };
+		float distance = std::sqrt(Dot3(toCenter, toCenter));
+		if (!(distance > sphere.radius))
+			return false;
+		float cosine = Dot3(toCenter, meshlet.cone) / distance;
+		float sine = std::sqrt(std::fmax(0.0f, 1 - cosine * cosine));
+		float coneSine = std::sqrt(std::fmax(0.0f, 1 - cutoff * cutoff));
+		return cosine * cutoff - sine * coneSine > sphere.radius / distance;
+	}
+};
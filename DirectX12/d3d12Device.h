@@ -0,0 +1,726 @@
+#pragma once
+#include <d3dcompiler.h> // only compiles shaders on the fly when the build's .cso files are missing
+#pragma comment(lib, "d3dcompiler.lib")
+#include "d3dx12.h" // official helper file provided by microsoft
+
+void PrintLabeledDebugString(const char* label, const char* toPrint)
+{
+	std::cout << label << toPrint << std::endl;
+#if defined WIN32 //OutputDebugStringA is a windows-only function
+	OutputDebugStringA(label);
+	OutputDebugStringA(toPrint);
+#endif
+}
+
+class D3D12_Render_Device;
+
+//Upload_Fence over an ID3D12Fence the device signals on the direct queue once per frame
+class D3D12_Upload_Fence : public Upload_Fence
+{
+	Microsoft::WRL::ComPtr<ID3D12Fence>							fence;
+	HANDLE														fenceEvent = nullptr;
+
+public:
+
+	void Create(ID3D12Device* creator)
+	{
+		creator->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.ReleaseAndGetAddressOf()));
+		fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	}
+
+	~D3D12_Upload_Fence()
+	{
+		if (fenceEvent != nullptr)
+			CloseHandle(fenceEvent);
+	}
+
+	uint64_t GetCompletedValue() const override { return fence->GetCompletedValue(); }
+
+	void WaitFor(uint64_t value) override
+	{
+		if (fence->GetCompletedValue() >= value)
+			return;
+		fence->SetEventOnCompletion(value, fenceEvent);
+		WaitForSingleObject(fenceEvent, INFINITE);
+	}
+
+	ID3D12Fence* Get() const { return fence.Get(); }
+};
+
+//Copy_Queue over a dedicated COPY queue, staging memory is one committed upload heap buffer per block
+class D3D12_Copy_Queue : public Copy_Queue
+{
+	//Allocator and the fence value of the batch recorded with it, reused once the fence passes it
+	struct COPY_ALLOCATOR
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		uint64_t fenceValue;
+	};
+
+	const D3D12_Render_Device&									device;
+	Microsoft::WRL::ComPtr<ID3D12Device>						creator;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>					queue;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>			commandList;
+	//Oldest submitted first, the last one belongs to the batch being recorded while recording is set
+	std::deque<COPY_ALLOCATOR>									allocators;
+	bool														recording = false;
+	//Indexed by COPY_STAGING - 1, released slots are reused
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>			staging;
+	std::vector<COPY_STAGING>									freeStaging;
+	D3D12_Upload_Fence											fence;
+	uint64_t													submitted = 0;
+
+public:
+
+	D3D12_Copy_Queue(const D3D12_Render_Device& _device) : device(_device) {}
+
+	void Create(ID3D12Device* _creator)
+	{
+		creator = _creator;
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+		creator->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(queue.ReleaseAndGetAddressOf()));
+		fence.Create(_creator);
+	}
+
+	COPY_STAGING CreateStaging(unsigned sizeInBytes, void*& outCpuAddress) override
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		creator->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(sizeInBytes),
+			D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(resource.GetAddressOf()));
+		resource->Map(0, &CD3DX12_RANGE(0, 0), &outCpuAddress);
+
+		if (freeStaging.empty() == false)
+		{
+			COPY_STAGING handle = freeStaging.back();
+			freeStaging.pop_back();
+			staging[handle - 1] = resource;
+			return handle;
+		}
+		staging.push_back(resource);
+		return static_cast<COPY_STAGING>(staging.size());
+	}
+
+	void ReleaseStaging(COPY_STAGING handle) override
+	{
+		staging[handle - 1]->Unmap(0, nullptr);
+		staging[handle - 1].Reset();
+		freeStaging.push_back(handle);
+	}
+
+	void CopyBuffer(RENDER_BUFFER destination, unsigned destinationOffset,
+		COPY_STAGING source, unsigned sourceOffset, unsigned sizeInBytes) override;
+	void FinishBuffer(RENDER_BUFFER destination) override;
+
+	uint64_t Submit() override
+	{
+		if (recording == false)
+			return submitted;
+		commandList->Close();
+		ID3D12CommandList* lists[] = { commandList.Get() };
+		queue->ExecuteCommandLists(ARRAYSIZE(lists), lists);
+		queue->Signal(fence.Get(), ++submitted);
+		allocators.back().fenceValue = submitted;
+		recording = false;
+		return submitted;
+	}
+
+	Upload_Fence& GetFence() override { return fence; }
+	ID3D12Fence* GetD3D12Fence() const { return fence.Get(); }
+
+private:
+
+	//Opens the list of the next batch on the oldest allocator the GPU is done with
+	void BeginRecording()
+	{
+		if (recording)
+			return;
+		COPY_ALLOCATOR next = {};
+		if (allocators.empty() == false && allocators.front().fenceValue <= fence.GetCompletedValue())
+		{
+			next = allocators.front();
+			allocators.pop_front();
+			next.allocator->Reset();
+		}
+		else
+			creator->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(next.allocator.GetAddressOf()));
+
+		if (commandList == nullptr)
+			creator->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, next.allocator.Get(), nullptr,
+				IID_PPV_ARGS(commandList.GetAddressOf()));
+		else
+			commandList->Reset(next.allocator.Get(), nullptr);
+		allocators.push_back(next);
+		recording = true;
+	}
+};
+
+//Render_Command_List recorded straight into an ID3D12GraphicsCommandList
+class D3D12_Command_List : public Render_Command_List
+{
+	const D3D12_Render_Device&									device;
+	ID3D12GraphicsCommandList*									commandList = nullptr;
+
+public:
+
+	D3D12_Command_List(const D3D12_Render_Device& _device) : device(_device) {}
+
+	void Attach(ID3D12GraphicsCommandList* _commandList) { commandList = _commandList; }
+	ID3D12GraphicsCommandList* Get() const { return commandList; }
+
+	void SetGeometry(RENDER_BUFFER vertices, RENDER_BUFFER indices) override;
+	void SetConstants(RENDER_CONSTANT_SLOT slot, unsigned count32, const void* data) override;
+	void SetConstant(RENDER_CONSTANT_SLOT slot, unsigned offset32, unsigned value) override
+	{
+		commandList->SetGraphicsRoot32BitConstant(static_cast<UINT>(slot), value, offset32);
+	}
+	void SetConstantBuffer(RENDER_CONSTANT_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) override;
+	void SetResource(RENDER_RESOURCE_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) override;
+	void DrawIndexedInstanced(unsigned indexCount, unsigned instanceCount,
+		unsigned startIndex, int baseVertex, unsigned startInstance) override
+	{
+		commandList->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+	void ExecuteIndirect(RENDER_BUFFER arguments, unsigned offsetInBytes, unsigned drawCount) override;
+};
+
+//Direct3D 12 backend on top of a GDirectX12Surface, owns the level pipeline and every buffer
+class D3D12_Render_Device : public Render_Device
+{
+	GW::GRAPHICS::GDirectX12Surface								d3d;
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature>					rootSignature;
+	//One pipeline per vertex format, SetGeometry picks the one matching the bound vertex buffer
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>					pipeline;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>					compressedPipeline;
+	//Layout of one INDIRECT_DRAW: the three b1 constants then a DrawIndexedInstanced
+	Microsoft::WRL::ComPtr<ID3D12CommandSignature>				drawSignature;
+	//Hash of the serialized root signature, part of the pipeline cache key
+	uint64_t													rootSignatureHash = 0;
+	//Serialized pipeline states from earlier runs
+	Pipeline_Cache												pipelineCache;
+	const char*													pipelineCachePath = "../Shaders/PipelineCache.bin";
+
+	struct D3D12_BUFFER
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		RENDER_BUFFER_DESC desc;
+		//Upload heap buffers stay mapped for their whole life, null for DEFAULT heap ones
+		UINT8* mapped;
+	};
+	//Indexed by RENDER_BUFFER - 1, released slots are reused
+	std::vector<D3D12_BUFFER>									buffers;
+	std::vector<RENDER_BUFFER>									freeBuffers;
+
+	//Number of buffers in the swapchain
+	unsigned int												maxActiveFrames;
+	D3D12_Command_List											frameCommands;
+
+	//Frame uploads, one persistently mapped buffer reclaimed through uploadFence
+	Upload_Ring													uploadRing;
+	D3D12_Upload_Fence											uploadFence;
+	RENDER_BUFFER												uploadBuffer = 0;
+	UINT8*														uploadMemory = nullptr;
+	//Value the last recorded frame was tagged with, signalled once Gateware has submitted that frame
+	UINT64														frameFenceValue = 0;
+	bool														frameFencePending = false;
+
+	//STATIC buffers sit in the DEFAULT heap and are filled from staging on the copy queue
+	//The batcher is declared after the queue and the buffers so it drains into them before they go
+	D3D12_Copy_Queue											copyQueue;
+	Upload_Batcher												uploadBatcher;
+	//Highest copy fence value the direct queue was told to wait for
+	uint64_t													copiesWaitedFor = 0;
+
+public:
+
+	D3D12_Render_Device(GW::GRAPHICS::GDirectX12Surface _d3d) : frameCommands(*this), copyQueue(*this)
+	{
+		d3d = _d3d;
+
+		IDXGISwapChain4* swapChain = nullptr;
+		d3d.GetSwapchain4((void**)&swapChain);
+		DXGI_SWAP_CHAIN_DESC desc;
+		swapChain->GetDesc(&desc);
+		maxActiveFrames = desc.BufferCount;
+		swapChain->Release();
+
+		ID3D12Device* creator;
+		d3d.GetDevice((void**)&creator);
+		InitializeGraphicsPipeline(creator);
+		uploadFence.Create(creator);
+		copyQueue.Create(creator);
+		uploadBatcher.Create(copyQueue);
+		// free temporary handle
+		creator->Release();
+	}
+
+	RENDER_BUFFER CreateBuffer(const RENDER_BUFFER_DESC& desc, const void* initialData) override
+	{
+		ID3D12Device* creator;
+		d3d.GetDevice((void**)&creator);
+		D3D12_BUFFER buffer;
+		buffer.desc = desc;
+		buffer.mapped = nullptr;
+		if (desc.usage == RENDER_BUFFER_USAGE::STATIC)
+		{
+			//COMMON lets the copy queue promote it to COPY_DEST and the direct queue to whatever read state it needs
+			creator->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+				D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(desc.sizeInBytes),
+				D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(buffer.resource.GetAddressOf()));
+		}
+		else
+		{
+			creator->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+				D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(desc.sizeInBytes),
+				D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(buffer.resource.GetAddressOf()));
+			buffer.resource->Map(0, &CD3DX12_RANGE(0, 0), reinterpret_cast<void**>(&buffer.mapped));
+		}
+		creator->Release();
+
+		RENDER_BUFFER handle;
+		if (freeBuffers.empty() == false)
+		{
+			handle = freeBuffers.back();
+			freeBuffers.pop_back();
+			buffers[handle - 1] = buffer;
+		}
+		else
+		{
+			buffers.push_back(buffer);
+			handle = static_cast<RENDER_BUFFER>(buffers.size());
+		}
+		if (initialData != nullptr)
+			WriteBuffer(handle, 0, initialData, desc.sizeInBytes);
+		return handle;
+	}
+
+	void ReleaseBuffer(RENDER_BUFFER buffer) override
+	{
+		if (buffer == 0 || buffer > buffers.size() || buffers[buffer - 1].resource == nullptr)
+			return;
+		//Frames still in flight may read it, e.g. when a level swap releases the old level's buffers
+		SignalFrameFence();
+		uploadFence.WaitFor(frameFenceValue);
+		if (buffers[buffer - 1].mapped != nullptr)
+			buffers[buffer - 1].resource->Unmap(0, nullptr);
+		else
+			uploadBatcher.WaitIdle(); // copies into it may still be queued or running
+		buffers[buffer - 1].resource.Reset();
+		buffers[buffer - 1].mapped = nullptr;
+		freeBuffers.push_back(buffer);
+	}
+
+	void WriteBuffer(RENDER_BUFFER buffer, unsigned offsetInBytes, const void* data, unsigned sizeInBytes) override
+	{
+		if (buffers[buffer - 1].mapped != nullptr)
+			memcpy(buffers[buffer - 1].mapped + offsetInBytes, data, sizeInBytes);
+		else
+			uploadBatcher.Enqueue(buffer, offsetInBytes, data, sizeInBytes);
+	}
+
+	bool AllocateUpload(unsigned sizeInBytes, unsigned alignment, RENDER_UPLOAD& outUpload) override
+	{
+		uint64_t offset;
+		if (uploadBuffer == 0 || uploadRing.Allocate(sizeInBytes, alignment, offset) == false)
+			return false;
+		outUpload = { uploadMemory + offset, uploadBuffer, static_cast<unsigned>(offset) };
+		return true;
+	}
+
+	void ReserveUploadSpace(unsigned bytesPerFrame) override
+	{
+		//One extra frame absorbs the space skipped when an allocation wraps
+		uint64_t capacity = static_cast<uint64_t>(bytesPerFrame) * (maxActiveFrames + 1);
+		if (uploadBuffer != 0 && uploadRing.GetCapacity() >= capacity)
+			return;
+
+		//The old ring goes once the GPU is done with every frame that used it, ReleaseBuffer waits for that
+		ReleaseBuffer(uploadBuffer);
+
+		uploadBuffer = CreateBuffer({ RENDER_BUFFER_TYPE::UPLOAD_RING, static_cast<unsigned>(capacity), 1, RENDER_BUFFER_USAGE::DYNAMIC }, nullptr);
+		uploadMemory = buffers[uploadBuffer - 1].mapped;
+		uploadRing.Create(capacity, uploadFence);
+	}
+
+	unsigned GetFrameCount() const override { return maxActiveFrames; }
+
+	unsigned GetFrameIndex() const override
+	{
+		UINT curFrame = 0;
+		d3d.GetSwapChainBufferIndex(curFrame);
+		return curFrame;
+	}
+
+	float GetAspectRatio() const override
+	{
+		float aspectRatio;
+		d3d.GetAspectRatio(aspectRatio);
+		return aspectRatio;
+	}
+
+	Render_Command_List& BeginFrame() override
+	{
+		//Gateware submitted the last frame in between, its uploads are freed once this value is reached
+		SignalFrameFence();
+		SubmitCopies();
+
+		PipelineHandles curHandles = GetCurrentPipelineHandles();
+		SetUpPipeline(curHandles);
+		frameCommands.Attach(curHandles.commandList);
+		return frameCommands;
+	}
+
+	void EndFrame() override
+	{
+		frameCommands.Get()->Release();
+		frameCommands.Attach(nullptr);
+		uploadRing.FinishFrame(++frameFenceValue);
+		frameFencePending = true;
+	}
+
+	ID3D12Resource* GetResource(RENDER_BUFFER buffer) const
+	{
+		return buffers[buffer - 1].resource.Get();
+	}
+
+	const RENDER_BUFFER_DESC& GetBufferDesc(RENDER_BUFFER buffer) const
+	{
+		return buffers[buffer - 1].desc;
+	}
+
+	ID3D12CommandSignature* GetDrawSignature() const { return drawSignature.Get(); }
+
+	//The input layout has to match the vertex buffer's format, the stride tells them apart
+	ID3D12PipelineState* GetPipeline(RENDER_BUFFER vertices) const
+	{
+		return GetBufferDesc(vertices).strideInBytes == sizeof(COMPRESSED_VERTEX) ? compressedPipeline.Get() : pipeline.Get();
+	}
+
+private:
+	void SignalFrameFence()
+	{
+		if (frameFencePending == false)
+			return;
+		ID3D12CommandQueue* queue;
+		d3d.GetCommandQueue((void**)&queue);
+		queue->Signal(uploadFence.Get(), frameFenceValue);
+		queue->Release();
+		frameFencePending = false;
+	}
+
+	//Sends the staged copies to the copy queue, the frame's work on the direct queue starts after they land
+	void SubmitCopies()
+	{
+		uint64_t copies = uploadBatcher.Flush();
+		if (copies <= copiesWaitedFor)
+			return;
+		ID3D12CommandQueue* queue;
+		d3d.GetCommandQueue((void**)&queue);
+		queue->Wait(copyQueue.GetD3D12Fence(), copies);
+		queue->Release();
+		copiesWaitedFor = copies;
+	}
+
+	struct PipelineHandles
+	{
+		ID3D12GraphicsCommandList* commandList;
+		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView;
+		D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView;
+	};
+
+	PipelineHandles GetCurrentPipelineHandles()
+	{
+		PipelineHandles retval;
+		d3d.GetCommandList((void**)&retval.commandList);
+		d3d.GetCurrentRenderTargetView((void**)&retval.renderTargetView);
+		d3d.GetDepthStencilView((void**)&retval.depthStencilView);
+		return retval;
+	}
+
+	void SetUpPipeline(PipelineHandles handles)
+	{
+		handles.commandList->SetGraphicsRootSignature(rootSignature.Get());
+		handles.commandList->OMSetRenderTargets(1, &handles.renderTargetView, FALSE, &handles.depthStencilView);
+		handles.commandList->SetPipelineState(pipeline.Get());
+		handles.commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	}
+
+	void InitializeGraphicsPipeline(ID3D12Device* creator)
+	{
+		auto initStart = std::chrono::steady_clock::now();
+
+		//FXC writes these next to the .hlsl files at build time
+		Microsoft::WRL::ComPtr<ID3DBlob> vsBlob = LoadShaderBytecode("../Shaders/VertexShader.cso");
+		Microsoft::WRL::ComPtr<ID3DBlob> compressedVsBlob = LoadShaderBytecode("../Shaders/VertexShaderCompressed.cso");
+		Microsoft::WRL::ComPtr<ID3DBlob> psBlob = LoadShaderBytecode("../Shaders/PixelShader.cso");
+		bool compiled = vsBlob == nullptr || compressedVsBlob == nullptr || psBlob == nullptr;
+		if (compiled)
+		{
+			UINT compilerFlags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if _DEBUG
+			compilerFlags |= D3DCOMPILE_DEBUG;
+#endif
+			const D3D_SHADER_MACRO compressedDefines[] = { { "COMPRESSED_VERTICES", "1" }, { nullptr, nullptr } };
+			vsBlob = CompileVertexShader(creator, compilerFlags, nullptr);
+			compressedVsBlob = CompileVertexShader(creator, compilerFlags, compressedDefines);
+			psBlob = CompilePixelShader(creator, compilerFlags);
+		}
+		auto shadersReady = std::chrono::steady_clock::now();
+
+		CreateRootSignature(creator);
+		pipelineCache.Load(pipelineCachePath);
+		//H2B::VERTEX as is
+		D3D12_INPUT_ELEMENT_DESC formats[3] = {
+			InputElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT),
+			InputElement("UVW", DXGI_FORMAT_R32G32B32_FLOAT),
+			InputElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT) };
+		//COMPRESSED_VERTEX
+		D3D12_INPUT_ELEMENT_DESC compressedFormats[3] = {
+			InputElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM),
+			InputElement("NORMAL", DXGI_FORMAT_R16G16_SNORM),
+			InputElement("UVW", DXGI_FORMAT_R16G16_FLOAT) };
+		bool cached = CreatePipelineState(vsBlob, psBlob, creator, formats, ARRAYSIZE(formats), pipeline);
+		cached &= CreatePipelineState(compressedVsBlob, psBlob, creator, compressedFormats, ARRAYSIZE(compressedFormats),
+			compressedPipeline);
+		pipelineCache.Save();
+		CreateDrawSignature(creator);
+
+		auto initEnd = std::chrono::steady_clock::now();
+		std::string timings = std::string(cached ? "warm" : "cold") + " start in " +
+			std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(initEnd - initStart).count() / 1000.0f) +
+			" ms, shaders " + (compiled ? "compiled" : "loaded") + " in " +
+			std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(shadersReady - initStart).count() / 1000.0f) +
+			" ms, pipeline states " + (cached ? "from cache" : "created");
+		PrintLabeledDebugString("Graphics pipeline: ", timings.c_str());
+	}
+
+	//nullptr when the file is missing
+	Microsoft::WRL::ComPtr<ID3DBlob> LoadShaderBytecode(const char* filePath)
+	{
+		GW::SYSTEM::GFile file;
+		file.Create();
+		unsigned sizeInBytes = 0;
+		if (-file.GetFileSize(filePath, sizeInBytes) || sizeInBytes == 0 || -file.OpenBinaryRead(filePath))
+			return nullptr;
+		Microsoft::WRL::ComPtr<ID3DBlob> bytecode;
+		D3DCreateBlob(sizeInBytes, bytecode.GetAddressOf());
+		GW::GReturn readResult = file.Read(static_cast<char*>(bytecode->GetBufferPointer()), sizeInBytes);
+		file.CloseFile();
+		return G_FAIL(readResult) ? nullptr : bytecode;
+	}
+
+	//defines select the variant, COMPRESSED_VERTICES for the COMPRESSED_VERTEX input
+	Microsoft::WRL::ComPtr<ID3DBlob> CompileVertexShader(ID3D12Device* creator, UINT compilerFlags, const D3D_SHADER_MACRO* defines)
+	{
+		std::string vertexShaderSource = ReadFileIntoString("../Shaders/VertexShader.hlsl");
+
+		Microsoft::WRL::ComPtr<ID3DBlob> vsBlob, errors;
+
+		HRESULT compilationResult =
+			D3DCompile(vertexShaderSource.c_str(), vertexShaderSource.length(),
+				nullptr, defines, nullptr, "main", "vs_5_1", compilerFlags, 0,
+				vsBlob.GetAddressOf(), errors.GetAddressOf());
+
+		if (FAILED(compilationResult))
+		{
+			PrintLabeledDebugString("Vertex Shader Errors:\n", (char*)errors->GetBufferPointer());
+			abort();
+			return nullptr;
+		}
+
+		return vsBlob;
+	}
+
+	Microsoft::WRL::ComPtr<ID3DBlob> CompilePixelShader(ID3D12Device* creator, UINT compilerFlags)
+	{
+		std::string pixelShaderSource = ReadFileIntoString("../Shaders/PixelShader.hlsl");
+
+		Microsoft::WRL::ComPtr<ID3DBlob> psBlob, errors;
+
+		HRESULT compilationResult =
+			D3DCompile(pixelShaderSource.c_str(), pixelShaderSource.length(),
+				nullptr, nullptr, nullptr, "main", "ps_5_1", compilerFlags, 0,
+				psBlob.GetAddressOf(), errors.GetAddressOf());
+
+		if (FAILED(compilationResult))
+		{
+			PrintLabeledDebugString("Pixel Shader Errors:\n", (char*)errors->GetBufferPointer());
+			abort();
+			return nullptr;
+		}
+
+		return psBlob;
+	}
+
+	void CreateRootSignature(ID3D12Device* creator)
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> signature, errors;
+		CD3DX12_ROOT_PARAMETER rootParams[6] = {};
+		CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+
+		//Order must match RENDER_CONSTANT_SLOT followed by RENDER_RESOURCE_SLOT
+		rootParams[0].InitAsConstantBufferView(0);
+		rootParams[1].InitAsConstants(1, 1);
+		rootParams[2].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+		rootParams[3].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+		rootParams[4].InitAsShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+		rootParams[5].InitAsShaderResourceView(2, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+		rootSignatureDesc.Init(ARRAYSIZE(rootParams), rootParams, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+		D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &errors);
+		rootSignatureHash = Pipeline_Cache::Hash(signature->GetBufferPointer(), signature->GetBufferSize());
+
+		creator->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+	}
+
+	void CreateDrawSignature(ID3D12Device* creator)
+	{
+		D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+		arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		arguments[0].Constant.RootParameterIndex = DRAW_CONSTANTS;
+		arguments[0].Constant.DestOffsetIn32BitValues = 0;
+		arguments[0].Constant.Num32BitValuesToSet = 1;
+		arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+		D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+		signatureDesc.ByteStride = sizeof(INDIRECT_DRAW);
+		signatureDesc.NumArgumentDescs = ARRAYSIZE(arguments);
+		signatureDesc.pArgumentDescs = arguments;
+		//Root signature is required because the signature changes root constants
+		creator->CreateCommandSignature(&signatureDesc, rootSignature.Get(), IID_PPV_ARGS(&drawSignature));
+	}
+
+	static D3D12_INPUT_ELEMENT_DESC InputElement(const char* semanticName, DXGI_FORMAT format)
+	{
+		return { semanticName, 0, format, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+	}
+
+	//True when the pipeline came out of the cache
+	bool CreatePipelineState(Microsoft::WRL::ComPtr<ID3DBlob> vsBlob, Microsoft::WRL::ComPtr<ID3DBlob> psBlob, ID3D12Device* creator,
+		const D3D12_INPUT_ELEMENT_DESC* formats, UINT formatCount, Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState)
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC psDesc;
+		ZeroMemory(&psDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+
+		psDesc.InputLayout = { formats, formatCount };
+		psDesc.pRootSignature = rootSignature.Get();
+		psDesc.VS = CD3DX12_SHADER_BYTECODE(vsBlob.Get());
+		psDesc.PS = CD3DX12_SHADER_BYTECODE(psBlob.Get());
+		psDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		psDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+		psDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+		psDesc.SampleMask = UINT_MAX;
+		psDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		psDesc.NumRenderTargets = 1;
+		psDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		psDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+		psDesc.SampleDesc.Count = 1;
+
+		uint64_t key = HashPipelineState(psDesc);
+		const std::vector<char>* cachedBlob = pipelineCache.Find(key);
+		if (cachedBlob != nullptr)
+		{
+			psDesc.CachedPSO = { cachedBlob->data(), cachedBlob->size() };
+			if (SUCCEEDED(creator->CreateGraphicsPipelineState(&psDesc, IID_PPV_ARGS(pipelineState.ReleaseAndGetAddressOf()))))
+				return true;
+			//Another driver or adapter wrote it, build from scratch and replace it
+			pipelineCache.Remove(key);
+			psDesc.CachedPSO = {};
+		}
+
+		HRESULT creationResult = creator->CreateGraphicsPipelineState(&psDesc, IID_PPV_ARGS(pipelineState.ReleaseAndGetAddressOf()));
+		if (FAILED(creationResult))
+		{
+			PrintLabeledDebugString("Pipeline State Errors:\n", "CreateGraphicsPipelineState failed");
+			abort();
+			return false;
+		}
+		Microsoft::WRL::ComPtr<ID3DBlob> serialized;
+		if (SUCCEEDED(pipelineState->GetCachedBlob(serialized.GetAddressOf())))
+			pipelineCache.Store(key, serialized->GetBufferPointer(), serialized->GetBufferSize());
+		return false;
+	}
+
+	//Hashes what the description points at instead of the pointers themselves
+	uint64_t HashPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& psDesc) const
+	{
+		//Copied bytewise so the zeroed padding comes along
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC flat;
+		std::memcpy(&flat, &psDesc, sizeof(flat));
+		flat.pRootSignature = nullptr;
+		flat.VS = flat.PS = {};
+		flat.InputLayout.pInputElementDescs = nullptr;
+		flat.CachedPSO = {};
+		uint64_t key = Pipeline_Cache::Hash(&flat, sizeof(flat), rootSignatureHash);
+		key = Pipeline_Cache::Hash(psDesc.VS.pShaderBytecode, psDesc.VS.BytecodeLength, key);
+		key = Pipeline_Cache::Hash(psDesc.PS.pShaderBytecode, psDesc.PS.BytecodeLength, key);
+		for (UINT e = 0; e < psDesc.InputLayout.NumElements; e++)
+		{
+			D3D12_INPUT_ELEMENT_DESC element = psDesc.InputLayout.pInputElementDescs[e];
+			key = Pipeline_Cache::Hash(element.SemanticName, strlen(element.SemanticName), key);
+			element.SemanticName = nullptr;
+			key = Pipeline_Cache::Hash(&element, sizeof(element), key);
+		}
+		return key;
+	}
+};
+
+inline void D3D12_Copy_Queue::CopyBuffer(RENDER_BUFFER destination, unsigned destinationOffset,
+	COPY_STAGING source, unsigned sourceOffset, unsigned sizeInBytes)
+{
+	BeginRecording();
+	commandList->CopyBufferRegion(device.GetResource(destination), destinationOffset,
+		staging[source - 1].Get(), sourceOffset, sizeInBytes);
+}
+
+inline void D3D12_Copy_Queue::FinishBuffer(RENDER_BUFFER destination)
+{
+	//The copies promoted it to COPY_DEST, back in COMMON the direct queue can promote it to any read state
+	BeginRecording();
+	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(device.GetResource(destination),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
+	commandList->ResourceBarrier(1, &barrier);
+}
+
+inline void D3D12_Command_List::SetGeometry(RENDER_BUFFER vertices, RENDER_BUFFER indices)
+{
+	commandList->SetPipelineState(device.GetPipeline(vertices));
+
+	D3D12_VERTEX_BUFFER_VIEW vertexView;
+	vertexView.BufferLocation = device.GetResource(vertices)->GetGPUVirtualAddress();
+	vertexView.StrideInBytes = device.GetBufferDesc(vertices).strideInBytes;
+	vertexView.SizeInBytes = device.GetBufferDesc(vertices).sizeInBytes;
+	commandList->IASetVertexBuffers(0, 1, &vertexView);
+
+	D3D12_INDEX_BUFFER_VIEW indexView;
+	indexView.BufferLocation = device.GetResource(indices)->GetGPUVirtualAddress();
+	indexView.Format = device.GetBufferDesc(indices).strideInBytes == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	indexView.SizeInBytes = device.GetBufferDesc(indices).sizeInBytes;
+	commandList->IASetIndexBuffer(&indexView);
+}
+
+inline void D3D12_Command_List::SetConstants(RENDER_CONSTANT_SLOT slot, unsigned count32, const void* data)
+{
+	commandList->SetGraphicsRoot32BitConstants(static_cast<UINT>(slot), count32, data, 0);
+}
+
+inline void D3D12_Command_List::SetConstantBuffer(RENDER_CONSTANT_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes)
+{
+	commandList->SetGraphicsRootConstantBufferView(static_cast<UINT>(slot),
+		device.GetResource(buffer)->GetGPUVirtualAddress() + offsetInBytes);
+}
+
+inline void D3D12_Command_List::SetResource(RENDER_RESOURCE_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes)
+{
+	commandList->SetGraphicsRootShaderResourceView(RENDER_CONSTANT_SLOT_COUNT + static_cast<UINT>(slot),
+		device.GetResource(buffer)->GetGPUVirtualAddress() + offsetInBytes);
+}
+
+inline void D3D12_Command_List::ExecuteIndirect(RENDER_BUFFER arguments, unsigned offsetInBytes, unsigned drawCount)
+{
+	//Upload heap buffers stay in GENERIC_READ which already covers INDIRECT_ARGUMENT
+	commandList->ExecuteIndirect(device.GetDrawSignature(), drawCount, device.GetResource(arguments),
+		offsetInBytes, nullptr, 0);
+}
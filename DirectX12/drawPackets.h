@@ -0,0 +1,233 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+//Turns the visible runs of a frame into sorted draw packets and records them with as few constant changes as possible
+//Merged draws list the transforms of their instances, the shaders reach everything per instance through those lists
+class Draw_Packet_Builder
+{
+public:
+	//Sort key layout, most significant first: pipeline | index pool | material | mesh | lod | depth
+	static const unsigned pipelineBits = 3, indexPoolBits = 1, materialBits = 20, meshBits = 20, lodBits = 2, depthBits = 18;
+	static const unsigned depthShift = 0, lodShift = depthBits, meshShift = lodShift + lodBits, materialShift = meshShift + meshBits,
+		indexPoolShift = materialShift + materialBits, pipelineShift = indexPoolShift + indexPoolBits;
+
+	//One instanced draw of a single mesh
+	struct DRAW_PACKET
+	{
+		uint64_t key;
+		unsigned indexCount, instanceCount, startIndex;
+		int baseVertex;
+		unsigned materialIndex, modelIndex;
+		//Before merging a packet draws transforms [transformStart, transformStart + instanceCount)
+		unsigned transformStart;
+		//Merged draws read their transforms from GetInstanceTransforms() starting here, the draw constant the shaders get
+		unsigned instanceStart;
+		//Index buffer startIndex points into
+		INDEX_POOL indexPool;
+		//Level mesh and LOD the indices belong to
+		unsigned meshIndex, lod;
+	};
+
+	//What the sorted and merged packets of the last Build cost to record
+	struct DRAW_STATS
+	{
+		//Draws before and after merging adjacent compatible packets
+		unsigned packets, draws;
+		//Draw constant writes that changed a value, and the writes a constant per packet would have made on top of them
+		unsigned constantWrites, constantWritesAvoided;
+		unsigned pipelineChanges, indexPoolChanges;
+	};
+
+private:
+	std::vector<DRAW_PACKET>								mPackets;
+	std::vector<DRAW_PACKET>								mSorted;
+	//Transform of every instance of every merged draw, in draw order
+	std::vector<unsigned>									mInstanceTransforms;
+	//Radix sort scratch, key and the packet it belongs to
+	std::vector<uint64_t>									mKeys, mKeysScratch;
+	std::vector<unsigned>									mOrder, mOrderScratch;
+	DRAW_STATS												mStats = {};
+
+public:
+
+	//Builds, sorts and merges the packets of the culler's visible runs, pipeline is the same for every draw for now
+	//Runs are split wherever the selected LOD changes
+	void Build(const Level_Data& level, const Lod_Selector& lods,
+		const std::vector<Frustum_Culler::VISIBLE_RUN>& runs, const std::vector<GW::MATH::GMATRIXF>& worldTransforms,
+		const GW::MATH::GMATRIXF& viewProjection, unsigned pipeline = 0)
+	{
+		mPackets.clear();
+		for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+		{
+			unsigned modelIndex = level.levelInstances[run.instanceIndex].modelIndex;
+			const Level_Data::LEVEL_MODEL& model = level.levelModels[modelIndex];
+			const Index_Pool_Builder::MODEL_INDICES& modelIndices = level.levelModelIndices[modelIndex];
+			const unsigned runEnd = run.transformStart + run.transformCount;
+			for (unsigned first = run.transformStart, last = first; first < runEnd; first = last)
+			{
+				unsigned lod = lods.GetLod(first);
+				while (last < runEnd && lods.GetLod(last) == lod)
+					last++;
+				const Level_Data::LEVEL_LOD& levelLod = level.levelLods[model.lodStart + lod];
+				uint64_t depth = QuantizeDepth(worldTransforms[first], viewProjection);
+				for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+				{
+					const H2B::BATCH& draw = level.levelLodDraws[levelLod.drawStart + mesh - model.meshStart];
+					//Small meshes can simplify away completely
+					if (draw.indexCount == 0)
+						continue;
+					DRAW_PACKET packet;
+					packet.materialIndex = model.materialStart + level.levelMeshes[mesh].materialIndex;
+					packet.transformStart = first;
+					packet.instanceStart = 0;
+					packet.modelIndex = modelIndex;
+					packet.indexCount = draw.indexCount;
+					packet.instanceCount = last - first;
+					packet.startIndex = modelIndices.indexStart + draw.indexOffset;
+					packet.baseVertex = static_cast<int>(model.vertexStart);
+					packet.indexPool = modelIndices.pool;
+					packet.meshIndex = mesh;
+					packet.lod = lod;
+					packet.key = Field(pipeline, pipelineBits) << pipelineShift | Field(packet.indexPool, indexPoolBits) << indexPoolShift |
+						Field(packet.materialIndex, materialBits) << materialShift | Field(mesh, meshBits) << meshShift |
+						Field(lod, lodBits) << lodShift | depth << depthShift;
+					mPackets.push_back(packet);
+				}
+			}
+		}
+		SortPackets();
+		MergePackets();
+		CountStateChanges();
+	}
+
+	//Records draws [first, last) of GetDraws() or a list derived from it, constants and geometry are only set where
+	//they differ from the draw before first so any split of the draws records the same state as one pass over all of them
+	static void Record(Render_Command_List& commands, const std::vector<DRAW_PACKET>& draws, unsigned first, unsigned last,
+		RENDER_BUFFER vertices, const RENDER_BUFFER (&indexBuffers)[INDEX_POOL_COUNT])
+	{
+		//INDEX_POOL_COUNT matches no draw so the first one always sets its geometry
+		INDEX_POOL indexPool = first > 0 ? draws[first - 1].indexPool : INDEX_POOL_COUNT;
+		unsigned instanceStart = first > 0 ? draws[first - 1].instanceStart : ~0u;
+		for (unsigned d = first; d < last; d++)
+		{
+			const DRAW_PACKET& packet = draws[d];
+			if (packet.indexPool != indexPool)
+				commands.SetGeometry(vertices, indexBuffers[indexPool = packet.indexPool]);
+			if (packet.instanceStart != instanceStart)
+				commands.SetConstant(DRAW_CONSTANTS, 0, instanceStart = packet.instanceStart);
+			commands.DrawIndexedInstanced(packet.indexCount, packet.instanceCount, packet.startIndex, packet.baseVertex, 0);
+		}
+	}
+
+	const std::vector<DRAW_PACKET>& GetDraws() const { return mSorted; }
+	//Indexed by instanceStart + SV_InstanceID of a draw
+	const std::vector<unsigned>& GetInstanceTransforms() const { return mInstanceTransforms; }
+	const DRAW_STATS& GetStats() const { return mStats; }
+
+private:
+
+	static uint64_t Field(unsigned value, unsigned bits)
+	{
+		return static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1);
+	}
+
+	//Front to back, the top bits of a positive float sort the same as the float so they make a log scale depth
+	static uint64_t QuantizeDepth(const GW::MATH::GMATRIXF& world, const GW::MATH::GMATRIXF& viewProjection)
+	{
+		float viewDepth = world.row4.x * viewProjection.row1.w + world.row4.y * viewProjection.row2.w +
+			world.row4.z * viewProjection.row3.w + viewProjection.row4.w;
+		if (!(viewDepth > 0))
+			viewDepth = 0;
+		uint32_t bits;
+		std::memcpy(&bits, &viewDepth, sizeof(bits));
+		return bits >> (31 - depthBits);
+	}
+
+	//LSD radix sort of the keys, 8 bits a pass, passes where every key has the same byte are skipped
+	void SortPackets()
+	{
+		size_t count = mPackets.size();
+		mKeys.resize(count);
+		mOrder.resize(count);
+		mKeysScratch.resize(count);
+		mOrderScratch.resize(count);
+		for (unsigned i = 0; i < count; i++)
+		{
+			mKeys[i] = mPackets[i].key;
+			mOrder[i] = i;
+		}
+
+		//Every byte's histogram comes from one read of the keys
+		unsigned histograms[8][256] = {};
+		for (size_t i = 0; i < count; i++)
+			for (unsigned byte = 0; byte < 8; byte++)
+				histograms[byte][(mKeys[i] >> (byte * 8)) & 0xFF]++;
+
+		for (unsigned byte = 0; byte < 8 && count > 0; byte++)
+		{
+			unsigned* histogram = histograms[byte];
+			unsigned shift = byte * 8;
+			if (histogram[(mKeys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			unsigned offset = 0;
+			for (unsigned bucket = 0; bucket < 256; bucket++)
+			{
+				unsigned size = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += size;
+			}
+			for (size_t i = 0; i < count; i++)
+			{
+				unsigned slot = histogram[(mKeys[i] >> shift) & 0xFF]++;
+				mKeysScratch[slot] = mKeys[i];
+				mOrderScratch[slot] = mOrder[i];
+			}
+			mKeys.swap(mKeysScratch);
+			mOrder.swap(mOrderScratch);
+		}
+
+		mSorted.resize(count);
+		for (size_t i = 0; i < count; i++)
+			mSorted[i] = mPackets[mOrder[i]];
+	}
+
+	//Same mesh, LOD, material, index pool and pipeline becomes one instanced draw wherever its transforms are,
+	//the instances keep the packets' front to back order
+	void MergePackets()
+	{
+		mStats = {};
+		mStats.packets = static_cast<unsigned>(mSorted.size());
+		mInstanceTransforms.clear();
+		size_t kept = 0;
+		const uint64_t stateMask = ~((uint64_t(1) << lodShift) - 1);
+		for (size_t i = 0; i < mSorted.size(); i++)
+		{
+			const DRAW_PACKET& next = mSorted[i];
+			if (kept == 0 || (mSorted[kept - 1].key & stateMask) != (next.key & stateMask))
+			{
+				mSorted[kept] = next;
+				mSorted[kept++].instanceStart = static_cast<unsigned>(mInstanceTransforms.size());
+			}
+			else
+				mSorted[kept - 1].instanceCount += next.instanceCount;
+			for (unsigned transform = next.transformStart; transform < next.transformStart + next.instanceCount; transform++)
+				mInstanceTransforms.push_back(transform);
+		}
+		mSorted.resize(kept);
+		mStats.draws = static_cast<unsigned>(kept);
+	}
+
+	void CountStateChanges()
+	{
+		for (size_t d = 0; d < mSorted.size(); d++)
+		{
+			bool first = d == 0;
+			mStats.constantWrites += first || mSorted[d].instanceStart != mSorted[d - 1].instanceStart ? 1 : 0;
+			mStats.pipelineChanges += first || (mSorted[d].key >> pipelineShift) != (mSorted[d - 1].key >> pipelineShift) ? 1 : 0;
+			mStats.indexPoolChanges += first || mSorted[d].indexPool != mSorted[d - 1].indexPool ? 1 : 0;
+		}
+		mStats.constantWritesAvoided = mStats.packets - mStats.constantWrites;
+	}
+};
@@ -0,0 +1,393 @@
+#pragma once
+#include <thread>
+
+//Everything a frame needs that does not depend on the graphics API:
+//scene updates, culling, constant packing, buffer updates and draw recording
+class Frame_Renderer
+{
+	//Where resources and commands go
+	Render_Device&												device;
+	//Handle to the level data to draw
+	Level_Data&													levelHandle;
+	//Logger for render debugging
+	GW::SYSTEM::GLog&											renderLog;
+
+	//Struct of Scene Data for GPU
+	struct SCENE_DATA {
+		//Sun Light settings and Camera Position
+		GW::MATH::GVECTORF sunDirection, sunColor, sunAmbiet, camPos;
+		//Combined view and projection matrices for homogenization
+		GW::MATH::GMATRIXF viewProjection;
+	};
+
+	//Instance of Scene Data to send to GPU
+	SCENE_DATA													sceneDataForGPU;
+
+	//*HARD CODED* sun settings
+	GW::MATH::GVECTORF											sunLightDir = { -1, -1, 2 },
+																sunLightColor = { 0.9f, 0.9f, 1, 1 },
+																sunLightAmbient = { 0.75f, 0.9f, 0.9f, 0 };
+
+	//The vector of transforms to update/send to gpu
+	std::vector<GW::MATH::GMATRIXF>								transformsForGPU;
+	//Parent before child local/world transforms of the level
+	Scene_Hierarchy												sceneHierarchy;
+	//World bounds of every transform for culling and ray/overlap queries
+	Level_BVH													levelBVH;
+	//Visible instance runs of the current frame
+	Frustum_Culler												frustumCuller;
+	//The frustum's visible runs without the transforms hidden behind the biggest models
+	Occlusion_Culler											occlusionCuller;
+	//Level of detail of every visible transform
+	Lod_Selector												lodSelector;
+	//Visible runs as draws sorted by pipeline, material, mesh, LOD and depth
+	Draw_Packet_Builder											drawPackets;
+	//Sorted draws split into their visible meshlet ranges
+	Cluster_Culler												clusterCuller;
+	//What the shaders know about every drawn instance, written into the upload ring every frame
+	Instance_Record_Builder										instanceRecords;
+	//Sorted draws packed for ExecuteIndirect
+	Indirect_Argument_Builder									indirectArgs;
+	//Submit the whole frame with one ExecuteIndirect instead of a draw per packet
+	bool														indirectDraws = false;
+
+	//Level geometry, copied once into GPU memory - GPU Resource
+	RENDER_BUFFER												vertexBuffer = 0;
+	//The level's index pools, indexed by INDEX_POOL, an unused pool stays 0
+	RENDER_BUFFER												indexBuffers[INDEX_POOL_COUNT] = {};
+	//Upload the 16 byte COMPRESSED_VERTEX stream instead of H2B::VERTEX, applies from the next LoadLevelResources
+	bool														compressedVertices = true;
+	//Per model bounds the compressed positions decode against - GPU Resource
+	RENDER_BUFFER												quantizationBuffer = 0;
+	//All Materials in the level, they never change so one copy serves every frame - GPU Resource
+	RENDER_BUFFER												materialStructuredBuffer = 0;
+	//All Transforms in the level, one copy per frame in flight that only gets its dirty ranges rewritten - GPU Resource
+	Transform_Uploader											transformUploads;
+	//Scene constants and indirect arguments are written into the device's upload ring every frame
+
+	//Draw recording is split across this many threads, 1 records straight into the frame's list
+	unsigned													recordingWorkers = 1;
+	//Workers are only added while each of them gets at least this many draws
+	unsigned													minDrawsPerWorker = 256;
+	//One stream per worker, replayed in worker order so the frame matches a single threaded recording
+	std::vector<Recording_Command_List>							workerCommands;
+	//Sorted draw each worker starts at, one extra entry closes the last range
+	std::vector<unsigned>										workerDrawStart;
+
+public:
+
+	Frame_Renderer(Render_Device& _device, Level_Data& _handle, GW::SYSTEM::GLog& _log)
+		: device(_device), levelHandle(_handle), renderLog(_log)
+	{
+		//Scene Variables that currently Don't change throughout the program
+		sceneDataForGPU.sunColor = sunLightColor;
+		sceneDataForGPU.sunDirection = sunLightDir;
+		sceneDataForGPU.sunAmbiet = sunLightAmbient;
+		sceneDataForGPU.camPos = GW::MATH::GIdentityVectorF;
+		sceneDataForGPU.viewProjection = GW::MATH::GIdentityMatrixF;
+
+		LoadLevelResources();
+	}
+
+	~Frame_Renderer()
+	{
+		ReleaseLevelResources();
+	}
+
+	//(Re)builds the scene state and GPU buffers of whatever level levelHandle holds
+	void LoadLevelResources()
+	{
+		ReleaseLevelResources();
+		InitializeSceneHierarchy();
+		InitializeVertexBuffer();
+		InitializeIndexBuffer();
+		InitializeStructuredBuffers();
+	}
+
+	void SetCamera(const GW::MATH::GMATRIXF& viewProjection, const GW::MATH::GVECTORF& cameraPosition)
+	{
+		sceneDataForGPU.viewProjection = viewProjection;
+		sceneDataForGPU.camPos = cameraPosition;
+	}
+
+	void RotateObjectY(unsigned blenderObjIndex, float degrees, float deltaTime)
+	{
+		float radians = G_DEGREE_TO_RADIAN_F(degrees) * deltaTime;
+		unsigned transformIndex = levelHandle.blenderObjects[blenderObjIndex].transformIndex;
+
+		GW::MATH::GMATRIXF rotated;
+		GW::MATH::GMatrix::RotateYLocalF(sceneHierarchy.GetLocal(transformIndex), radians, rotated);
+		sceneHierarchy.SetLocal(transformIndex, rotated);
+	}
+
+	void LinkChildrenToParent()
+	{
+		//Only subtrees below changed locals are recomputed, parents always settle before children
+		sceneHierarchy.UpdateWorldTransforms();
+		sceneHierarchy.CopyChangedWorldTransforms(transformsForGPU);
+		transformUploads.MarkDirty(sceneHierarchy.GetChangedTransforms());
+		//Moved transforms only refit the BVH nodes above them
+		levelBVH.Refit(transformsForGPU, sceneHierarchy.GetChangedTransforms());
+	}
+
+	//Records the level into a command list obtained from device.BeginFrame()
+	void Render(Render_Command_List& commands)
+	{
+		unsigned curFrame = device.GetFrameIndex();
+		transformUploads.Upload(curFrame, transformsForGPU);
+
+		RENDER_UPLOAD sceneUpload;
+		if (UploadFrameData(&sceneDataForGPU, sizeof(SCENE_DATA), RENDER_CONSTANT_ALIGNMENT, sceneUpload) == false)
+			return;
+
+		commands.SetConstantBuffer(SCENE_CONSTANTS, sceneUpload.buffer, sceneUpload.offsetInBytes);
+		commands.SetResource(TRANSFORM_RESOURCE, transformUploads.GetBuffer(curFrame), 0);
+		commands.SetResource(MATERIAL_RESOURCE, materialStructuredBuffer, 0);
+		if (quantizationBuffer != 0)
+			commands.SetResource(QUANTIZATION_RESOURCE, quantizationBuffer, 0);
+
+		//Only draw the transforms that can be seen this frame
+		frustumCuller.Cull(levelHandle, levelBVH, transformsForGPU, sceneDataForGPU.viewProjection);
+		occlusionCuller.Cull(levelHandle, frustumCuller.GetVisibleRuns(), transformsForGPU, sceneDataForGPU.viewProjection);
+		const std::vector<Frustum_Culler::VISIBLE_RUN>& visibleRuns = occlusionCuller.GetVisibleRuns();
+		lodSelector.Select(levelHandle, visibleRuns, transformsForGPU, sceneDataForGPU.viewProjection);
+		drawPackets.Build(levelHandle, lodSelector, visibleRuns, transformsForGPU, sceneDataForGPU.viewProjection);
+		clusterCuller.Cull(levelHandle, drawPackets.GetDraws(), drawPackets.GetInstanceTransforms(), transformsForGPU,
+			sceneDataForGPU.viewProjection, sceneDataForGPU.camPos);
+		const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws = clusterCuller.GetDraws();
+		if (draws.empty())
+			return;
+
+		instanceRecords.Write(drawPackets.GetDraws(), drawPackets.GetInstanceTransforms());
+		RENDER_UPLOAD instanceUpload;
+		if (UploadFrameData(instanceRecords.GetRecords().data(), instanceRecords.GetSizeInBytes(), sizeof(unsigned), instanceUpload) == false)
+			return;
+		commands.SetResource(INSTANCE_RESOURCE, instanceUpload.buffer, instanceUpload.offsetInBytes);
+
+		if (indirectDraws)
+		{
+			indirectArgs.Build(draws);
+			RENDER_UPLOAD argumentUpload;
+			if (indirectArgs.GetDrawCount() == 0 ||
+				UploadFrameData(indirectArgs.GetDraws().data(), indirectArgs.GetSizeInBytes(), sizeof(unsigned), argumentUpload) == false)
+				return;
+			//Draws are sorted by index pool, one ExecuteIndirect per pool
+			for (unsigned first = 0, last = 0; first < draws.size(); first = last)
+			{
+				while (last < draws.size() && draws[last].indexPool == draws[first].indexPool)
+					last++;
+				commands.SetGeometry(vertexBuffer, indexBuffers[draws[first].indexPool]);
+				commands.ExecuteIndirect(argumentUpload.buffer, argumentUpload.offsetInBytes + first * sizeof(INDIRECT_DRAW), last - first);
+			}
+			return;
+		}
+
+		RecordDraws(commands, draws);
+	}
+
+	//Records draws split across the recording workers, the worker streams are replayed into commands in order
+	//Render calls it with the frame's sorted draws, any list derived from GetDrawPackets().GetDraws() can be recorded
+	void RecordDraws(Render_Command_List& commands, const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws)
+	{
+		unsigned workers = SplitDraws(static_cast<unsigned>(draws.size()));
+		if (workers <= 1)
+		{
+			Draw_Packet_Builder::Record(commands, draws, 0, static_cast<unsigned>(draws.size()), vertexBuffer, indexBuffers);
+			return;
+		}
+
+		auto recordJob = [&](unsigned worker) {
+			workerCommands[worker].Clear();
+			Draw_Packet_Builder::Record(workerCommands[worker], draws, workerDrawStart[worker], workerDrawStart[worker + 1], vertexBuffer, indexBuffers);
+		};
+		std::vector<std::thread> recordThreads;
+		for (unsigned w = 1; w < workers; ++w)
+			recordThreads.emplace_back(recordJob, w);
+		recordJob(0); // this thread records the first range
+		for (auto& thread : recordThreads)
+			thread.join();
+
+		for (unsigned w = 0; w < workers; ++w)
+			workerCommands[w].Replay(commands);
+	}
+
+	//Picks the vertex stream the next LoadLevelResources uploads
+	void SetCompressedVertices(bool enabled) { compressedVertices = enabled; }
+
+	//Distant transforms draw simplified LODs while their error stays under threshold of the viewport height
+	void SetLodSelection(bool enabled, float threshold = 0.001f)
+	{
+		lodSelector.SetEnabled(enabled);
+		lodSelector.SetThreshold(threshold);
+	}
+
+	//Drops transforms hidden behind the biggest visible models, off draws everything inside the frustum
+	void SetOcclusionCulling(bool enabled) { occlusionCuller.SetEnabled(enabled); }
+
+	//Splits full detail draws into the meshlet ranges that can be seen, off draws every mesh whole
+	void SetClusterCulling(bool enabled) { clusterCuller.SetEnabled(enabled); }
+
+	//Draws every mesh of a transform with one level material, Instance_Record_Builder::noMaterialOverride undoes it
+	void SetMaterialOverride(unsigned transformIndex, unsigned materialIndex) { instanceRecords.SetMaterialOverride(transformIndex, materialIndex); }
+	//Multiplies the lit color of a transform's meshes, white leaves them as they are
+	void SetTint(unsigned transformIndex, float red, float green, float blue)
+	{
+		instanceRecords.SetTint(transformIndex, Instance_Record_Builder::PackTint(red, green, blue, 1));
+	}
+
+	//Switches between one ExecuteIndirect per frame and recording every draw
+	void SetIndirectDraws(bool enabled) { indirectDraws = enabled; }
+
+	//Sets how many threads record draws, the sorted draws are split into that many contiguous ranges
+	//minDraws keeps small frames from paying for threads they do not need
+	void SetRecordingWorkers(unsigned workerCount, unsigned minDraws = 256)
+	{
+		recordingWorkers = workerCount == 0 ? 1 : workerCount;
+		minDrawsPerWorker = minDraws == 0 ? 1 : minDraws;
+		workerCommands.resize(recordingWorkers);
+	}
+
+	//Draw ranges of the last Render, worker w recorded sorted draws [start[w], start[w + 1])
+	const std::vector<unsigned>& GetWorkerDrawStart() const { return workerDrawStart; }
+
+	const Frustum_Culler& GetFrustumCuller() const { return frustumCuller; }
+	const Occlusion_Culler& GetOcclusionCuller() const { return occlusionCuller; }
+	const Lod_Selector& GetLodSelector() const { return lodSelector; }
+	const Draw_Packet_Builder& GetDrawPackets() const { return drawPackets; }
+	const Cluster_Culler& GetClusterCuller() const { return clusterCuller; }
+	const Instance_Record_Builder& GetInstanceRecords() const { return instanceRecords; }
+	const Indirect_Argument_Builder& GetIndirectArgs() const { return indirectArgs; }
+	const Transform_Uploader& GetTransformUploads() const { return transformUploads; }
+	const Level_BVH& GetLevelBVH() const { return levelBVH; }
+	const std::vector<GW::MATH::GMATRIXF>& GetTransforms() const { return transformsForGPU; }
+
+private:
+
+	void InitializeSceneHierarchy()
+	{
+		sceneHierarchy.Build(levelHandle);
+		sceneHierarchy.CopyWorldTransforms(transformsForGPU);
+
+		auto buildStart = std::chrono::steady_clock::now();
+		levelBVH.Build(levelHandle, transformsForGPU);
+		auto buildTime = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - buildStart).count() / 1000.0f;
+		renderLog.Log((std::string("Level BVH built with ") + std::to_string(levelBVH.GetNodes().size()) +
+			" nodes in " + std::to_string(buildTime) + " ms").c_str());
+		frustumCuller.Build(levelHandle);
+		occlusionCuller.Build(levelHandle);
+		lodSelector.Build(levelHandle);
+		instanceRecords.Build(levelHandle);
+	}
+
+	void InitializeVertexBuffer()
+	{
+		if (compressedVertices)
+		{
+			//Compressed while importing, a mapped level uploads it straight from the cooked file
+			const Level_Data::LEVEL_VIEW<COMPRESSED_VERTEX>& vertices = levelHandle.levelCompressedVertexView;
+			const std::vector<VERTEX_QUANTIZATION>& quantization = levelHandle.levelVertexQuantization;
+			vertexBuffer = device.CreateBuffer({ RENDER_BUFFER_TYPE::VERTICES,
+				static_cast<unsigned>(sizeof(COMPRESSED_VERTEX) * vertices.size()), sizeof(COMPRESSED_VERTEX),
+				RENDER_BUFFER_USAGE::STATIC }, vertices.data);
+			quantizationBuffer = device.CreateBuffer({ RENDER_BUFFER_TYPE::STRUCTURED,
+				static_cast<unsigned>(sizeof(VERTEX_QUANTIZATION) * quantization.size()), sizeof(VERTEX_QUANTIZATION),
+				RENDER_BUFFER_USAGE::STATIC }, quantization.data());
+			renderLog.Log(("Vertex stream compressed from " + std::to_string(sizeof(H2B::VERTEX) * vertices.size()) +
+				" to " + std::to_string(sizeof(COMPRESSED_VERTEX) * vertices.size()) + " bytes").c_str());
+			return;
+		}
+
+		//Level geometry may be a view straight into the mapped cooked level
+		unsigned sizeInBytes = sizeof(H2B::VERTEX) * levelHandle.levelVertexView.size();
+		vertexBuffer = device.CreateBuffer({ RENDER_BUFFER_TYPE::VERTICES, sizeInBytes, sizeof(H2B::VERTEX),
+			RENDER_BUFFER_USAGE::STATIC },
+			levelHandle.levelVertexView.data);
+	}
+
+	void InitializeIndexBuffer()
+	{
+		//The pools were packed at import, a mapped level uploads them straight from the cooked file
+		const void* poolData[INDEX_POOL_COUNT] = { levelHandle.levelShortIndexView.data, levelHandle.levelLongIndexView.data };
+		size_t poolCount[INDEX_POOL_COUNT] = { levelHandle.levelShortIndexView.size(), levelHandle.levelLongIndexView.size() };
+		unsigned poolBytes = 0;
+		for (unsigned pool = 0; pool < INDEX_POOL_COUNT; pool++)
+		{
+			unsigned stride = Index_Pool_Builder::GetStride(static_cast<INDEX_POOL>(pool));
+			unsigned sizeInBytes = static_cast<unsigned>(stride * poolCount[pool]);
+			if (sizeInBytes > 0)
+				indexBuffers[pool] = device.CreateBuffer({ RENDER_BUFFER_TYPE::INDICES, sizeInBytes, stride, RENDER_BUFFER_USAGE::STATIC },
+					poolData[pool]);
+			poolBytes += sizeInBytes;
+		}
+		renderLog.Log(("Index pools hold " + std::to_string(poolCount[SHORT_INDEX_POOL]) + " 16 bit and " +
+			std::to_string(poolCount[LONG_INDEX_POOL]) + " 32 bit indices, " + std::to_string(poolBytes) +
+			" of " + std::to_string(sizeof(unsigned) * levelHandle.levelIndexView.size()) + " bytes").c_str());
+	}
+
+	void InitializeStructuredBuffers()
+	{
+		std::vector<H2B::ATTRIBUTES> attributes(levelHandle.levelMaterials.size());
+		for (int j = 0; j < levelHandle.levelMaterials.size(); j++)
+			attributes[j] = levelHandle.levelMaterials[j].attrib;
+
+		materialStructuredBuffer = device.CreateBuffer({ RENDER_BUFFER_TYPE::STRUCTURED,
+			static_cast<unsigned>(sizeof(H2B::ATTRIBUTES) * attributes.size()), sizeof(H2B::ATTRIBUTES), RENDER_BUFFER_USAGE::STATIC },
+			attributes.data());
+		transformUploads.Create(device, transformsForGPU);
+
+		//Worst frame: scene constants and every mesh of every transform drawn on its own with a record of its own
+		//meshlet splits are capped to the same count so the indirect arguments always fit
+		unsigned maxDraws = Indirect_Argument_Builder::MaxDraws(levelHandle);
+		clusterCuller.SetMaxDraws(maxDraws);
+		unsigned uploadBytes = AlignUp(sizeof(SCENE_DATA), RENDER_CONSTANT_ALIGNMENT) +
+			AlignUp(sizeof(INSTANCE_RECORD) * maxDraws, RENDER_CONSTANT_ALIGNMENT) +
+			AlignUp(sizeof(INDIRECT_DRAW) * maxDraws, RENDER_CONSTANT_ALIGNMENT);
+		device.ReserveUploadSpace(uploadBytes);
+	}
+
+	void ReleaseLevelResources()
+	{
+		device.ReleaseBuffer(vertexBuffer);
+		for (RENDER_BUFFER& indices : indexBuffers)
+		{
+			device.ReleaseBuffer(indices);
+			indices = 0;
+		}
+		device.ReleaseBuffer(materialStructuredBuffer);
+		device.ReleaseBuffer(quantizationBuffer);
+		transformUploads.Release();
+		vertexBuffer = materialStructuredBuffer = quantizationBuffer = 0;
+	}
+
+	//Splits the sorted draws into contiguous ranges of equal size, one per worker
+	unsigned SplitDraws(unsigned drawCount)
+	{
+		unsigned workers = recordingWorkers;
+		if (workers > drawCount / minDrawsPerWorker)
+			workers = drawCount / minDrawsPerWorker;
+		if (workers < 1)
+			workers = 1;
+		workerDrawStart.resize(workers + 1);
+		for (unsigned w = 0; w <= workers; w++)
+			workerDrawStart[w] = static_cast<unsigned>(static_cast<unsigned long long>(drawCount) * w / workers);
+		return workers;
+	}
+
+	//Copies data into this frame's part of the upload ring
+	bool UploadFrameData(const void* data, unsigned sizeInBytes, unsigned alignment, RENDER_UPLOAD& outUpload)
+	{
+		if (device.AllocateUpload(sizeInBytes, alignment, outUpload) == false)
+		{
+			renderLog.Log("Upload ring is full, frame skipped");
+			return false;
+		}
+		memcpy(outUpload.cpuAddress, data, sizeInBytes);
+		return true;
+	}
+
+	static unsigned AlignUp(unsigned value, unsigned alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+//Tests every placed transform of a level against the camera frustum and compacts the survivors into draw runs
+//Cull with a Level_BVH skips whole subtrees outside the frustum and gives the same runs as testing every transform
+class Frustum_Culler
+{
+public:
+	//Contiguous visible transforms of one level instance, drawn with a single instanced draw
+	struct VISIBLE_RUN
+	{
+		unsigned instanceIndex, transformStart, transformCount;
+	};
+
+private:
+	//Model space OBB of a model with its axes already scaled by the half extents
+	struct MODEL_BOX
+	{
+		GW::MATH::GVECTORF center, axisX, axisY, axisZ;
+		//Colliders with no extent carry no bounds and are never culled
+		bool bounded;
+	};
+
+	std::vector<MODEL_BOX>									mModelBoxes;
+	std::vector<VISIBLE_RUN>								mVisibleRuns;
+	//Transforms the BVH found touching the frustum, tested precisely afterwards
+	std::vector<unsigned>									mCandidates;
+	//Per level transform, 1 inside the frustum, 2 needs the precise test, 0 culled
+	std::vector<char>										mVisibleFlags;
+	//Left, right, bottom, top, near, far
+	GW::MATH::GVECTORF										mPlanes[6];
+	unsigned												mTestedCount = 0;
+	unsigned												mVisibleCount = 0;
+
+public:
+
+	//Caches the model space box of every model from levelColliders, call again after a level load
+	void Build(const Level_Data& level)
+	{
+		mModelBoxes.resize(level.levelModels.size());
+		for (size_t model = 0; model < level.levelModels.size(); model++)
+		{
+			MODEL_BOX& box = mModelBoxes[model];
+			box = {};
+			unsigned collider = level.levelModels[model].colliderIndex;
+			if (collider >= level.levelColliders.size())
+				continue;
+			const GW::MATH::GOBBF& obb = level.levelColliders[collider];
+			box.bounded = obb.extent.x > 0 || obb.extent.y > 0 || obb.extent.z > 0;
+			if (box.bounded == false)
+				continue;
+			GW::MATH::GMATRIXF rotation = GW::MATH::GIdentityMatrixF;
+			GW::MATH::GMatrix::ConvertQuaternionF(obb.rotation, rotation);
+			box.center = { obb.center.x, obb.center.y, obb.center.z, 1 };
+			box.axisX = ScaleAxis(rotation.row1, obb.extent.x);
+			box.axisY = ScaleAxis(rotation.row2, obb.extent.y);
+			box.axisZ = ScaleAxis(rotation.row3, obb.extent.z);
+		}
+		mVisibleRuns.clear();
+		mTestedCount = mVisibleCount = 0;
+	}
+
+	//Culls every level instance against the frustum of viewProjection
+	//worldTransforms is indexed like Level_Data::levelTransforms
+	void Cull(const Level_Data& level, const std::vector<GW::MATH::GMATRIXF>& worldTransforms,
+		const GW::MATH::GMATRIXF& viewProjection)
+	{
+		SIMD_MATH::ExtractFrustumPlanes(viewProjection, mPlanes);
+		mVisibleRuns.clear();
+		mTestedCount = mVisibleCount = 0;
+
+		for (unsigned instance = 0; instance < level.levelInstances.size(); instance++)
+		{
+			const Level_Data::MODEL_INSTANCES& drawn = level.levelInstances[instance];
+			for (unsigned transform = drawn.transformStart; transform < drawn.transformStart + drawn.transformCount; transform++)
+			{
+				mTestedCount++;
+				if (IsVisible(drawn.modelIndex, worldTransforms[transform]))
+					AppendVisible(instance, transform);
+			}
+		}
+	}
+
+	//Same result as the brute force Cull, but only transforms the BVH finds touching the frustum are tested
+	void Cull(const Level_Data& level, const Level_BVH& bvh, const std::vector<GW::MATH::GMATRIXF>& worldTransforms,
+		const GW::MATH::GMATRIXF& viewProjection)
+	{
+		SIMD_MATH::ExtractFrustumPlanes(viewProjection, mPlanes);
+		mVisibleRuns.clear();
+		mCandidates.clear();
+		mTestedCount = mVisibleCount = 0;
+
+		bvh.QueryFrustum(mPlanes, mCandidates);
+		mVisibleFlags.assign(worldTransforms.size(), 0);
+		for (unsigned candidate : mCandidates)
+			mVisibleFlags[candidate & ~Level_BVH::insideBit] = (candidate & Level_BVH::insideBit) ? 1 : 2;
+		mTestedCount = static_cast<unsigned>(mCandidates.size());
+
+		//Bounds fully inside the frustum are visible as is, the rest get the precise OBB test
+		for (unsigned instance = 0; instance < level.levelInstances.size(); instance++)
+		{
+			const Level_Data::MODEL_INSTANCES& drawn = level.levelInstances[instance];
+			for (unsigned transform = drawn.transformStart; transform < drawn.transformStart + drawn.transformCount; transform++)
+			{
+				char flag = mVisibleFlags[transform];
+				if (flag == 1 || (flag == 2 && IsVisible(drawn.modelIndex, worldTransforms[transform])))
+					AppendVisible(instance, transform);
+			}
+		}
+	}
+
+	//Test a single model placed with a world matrix against the planes of the last Cull
+	bool IsVisible(unsigned modelIndex, const GW::MATH::GMATRIXF& world) const
+	{
+		if (modelIndex >= mModelBoxes.size() || mModelBoxes[modelIndex].bounded == false)
+			return true;
+		return IsBoxVisible(mModelBoxes[modelIndex], world);
+	}
+
+	const std::vector<VISIBLE_RUN>& GetVisibleRuns() const { return mVisibleRuns; }
+	const GW::MATH::GVECTORF* GetPlanes() const { return mPlanes; }
+	unsigned GetTestedCount() const { return mTestedCount; }
+	unsigned GetVisibleCount() const { return mVisibleCount; }
+
+private:
+
+	//Extends the last run when the transform directly follows it, otherwise starts a new one
+	void AppendVisible(unsigned instance, unsigned transform)
+	{
+		mVisibleCount++;
+		if (mVisibleRuns.empty() == false)
+		{
+			VISIBLE_RUN& last = mVisibleRuns.back();
+			if (last.instanceIndex == instance && last.transformStart + last.transformCount == transform)
+			{
+				last.transformCount++;
+				return;
+			}
+		}
+		mVisibleRuns.push_back({ instance, transform, 1 });
+	}
+
+	static GW::MATH::GVECTORF ScaleAxis(const GW::MATH::GVECTORF& axis, float scale)
+	{
+		return { axis.x * scale, axis.y * scale, axis.z * scale, 0 };
+	}
+
+	//Row vector transform of a direction, translation is ignored
+	static GW::MATH::GVECTORF TransformAxis(const GW::MATH::GVECTORF& v, const GW::MATH::GMATRIXF& m)
+	{
+		return {
+			v.x * m.row1.x + v.y * m.row2.x + v.z * m.row3.x,
+			v.x * m.row1.y + v.y * m.row2.y + v.z * m.row3.y,
+			v.x * m.row1.z + v.y * m.row2.z + v.z * m.row3.z,
+			0 };
+	}
+
+	//Box is outside once it is fully behind any plane, its projected radius is the sum of its axes on the normal
+	bool IsBoxVisible(const MODEL_BOX& box, const GW::MATH::GMATRIXF& world) const
+	{
+		GW::MATH::GVECTORF center;
+		SIMD_MATH::TransformPoint(world, &box.center.x, &center.x);
+		GW::MATH::GVECTORF axisX = TransformAxis(box.axisX, world);
+		GW::MATH::GVECTORF axisY = TransformAxis(box.axisY, world);
+		GW::MATH::GVECTORF axisZ = TransformAxis(box.axisZ, world);
+		for (const GW::MATH::GVECTORF& plane : mPlanes)
+		{
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			float radius =
+				std::fabs(plane.x * axisX.x + plane.y * axisX.y + plane.z * axisX.z) +
+				std::fabs(plane.x * axisY.x + plane.y * axisY.y + plane.z * axisY.z) +
+				std::fabs(plane.x * axisZ.x + plane.y * axisZ.y + plane.z * axisZ.z);
+			if (distance < -radius)
+				return false;
+		}
+		return true;
+	}
+};
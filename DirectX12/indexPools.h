@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//Index buffers the level's draws read from, models whose indices all fit 16 bits use the short pool
+enum INDEX_POOL { SHORT_INDEX_POOL, LONG_INDEX_POOL, INDEX_POOL_COUNT };
+
+//Repacks a model's 32 bit indices into the 16 bit pool when they all fit and into the 32 bit pool otherwise
+//Level_Data packs every model while importing and cooks the pools, a mapped level hands them to the GPU in place
+//Indices stay relative to the model's vertexStart, draws keep passing it as the base vertex
+class Index_Pool_Builder
+{
+public:
+	//Where the indices of one level model ended up
+	struct MODEL_INDICES
+	{
+		INDEX_POOL pool;
+		//First index of the model inside its pool
+		unsigned indexStart;
+	};
+
+	//Appends one model's indices to the pool they fit
+	static MODEL_INDICES AddModel(const unsigned* indices, unsigned indexCount,
+		std::vector<uint16_t>& shortIndices, std::vector<unsigned>& longIndices)
+	{
+		unsigned largest = 0;
+		for (unsigned i = 0; i < indexCount; i++)
+			largest = indices[i] > largest ? indices[i] : largest;
+
+		if (largest <= 0xFFFF)
+		{
+			MODEL_INDICES placement = { SHORT_INDEX_POOL, static_cast<unsigned>(shortIndices.size()) };
+			for (unsigned i = 0; i < indexCount; i++)
+				shortIndices.push_back(static_cast<uint16_t>(indices[i]));
+			return placement;
+		}
+		MODEL_INDICES placement = { LONG_INDEX_POOL, static_cast<unsigned>(longIndices.size()) };
+		longIndices.insert(longIndices.end(), indices, indices + indexCount);
+		return placement;
+	}
+
+	static unsigned GetStride(INDEX_POOL pool) { return pool == SHORT_INDEX_POOL ? sizeof(uint16_t) : sizeof(unsigned); }
+};
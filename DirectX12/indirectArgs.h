@@ -0,0 +1,48 @@
+#pragma once
+
+//One ExecuteIndirect command: the b1 draw constants followed by the draw itself
+//The draw part has the layout of D3D12_DRAW_INDEXED_ARGUMENTS so the buffer goes to the GPU as is
+struct INDIRECT_DRAW
+{
+	//Root constants of DRAW_CONSTANTS, same order as MESH_DATA in the shaders
+	unsigned instanceStart;
+	//D3D12_DRAW_INDEXED_ARGUMENTS
+	unsigned indexCountPerInstance, instanceCount, startIndexLocation;
+	int baseVertexLocation;
+	unsigned startInstanceLocation;
+};
+static_assert(sizeof(INDIRECT_DRAW) == 24, "INDIRECT_DRAW must stay tightly packed for the command signature");
+
+//Packs draws into the argument buffer layout of an indirect draw
+//Plain C++ with no API calls so it can be built and checked headless
+class Indirect_Argument_Builder
+{
+	std::vector<INDIRECT_DRAW>								mDraws;
+
+public:
+
+	//The sorted and merged draws of a frame
+	void Build(const std::vector<Draw_Packet_Builder::DRAW_PACKET>& packets)
+	{
+		mDraws.resize(packets.size());
+		for (size_t d = 0; d < packets.size(); d++)
+		{
+			const Draw_Packet_Builder::DRAW_PACKET& packet = packets[d];
+			mDraws[d] = { packet.instanceStart, packet.indexCount, packet.instanceCount, packet.startIndex, packet.baseVertex, 0 };
+		}
+	}
+
+	//One per mesh of every placed transform, the most instance records a frame can write
+	//Also the most draws once Cluster_Culler::SetMaxDraws caps its meshlet splits to it
+	static unsigned MaxDraws(const Level_Data& level)
+	{
+		unsigned maxDraws = 0;
+		for (const Level_Data::MODEL_INSTANCES& instance : level.levelInstances)
+			maxDraws += level.levelModels[instance.modelIndex].meshCount * instance.transformCount;
+		return maxDraws;
+	}
+
+	const std::vector<INDIRECT_DRAW>& GetDraws() const { return mDraws; }
+	unsigned GetDrawCount() const { return static_cast<unsigned>(mDraws.size()); }
+	unsigned GetSizeInBytes() const { return static_cast<unsigned>(mDraws.size() * sizeof(INDIRECT_DRAW)); }
+};
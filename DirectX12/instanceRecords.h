@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+
+//One drawn instance of one mesh, the vertex shader reads everything about the instance from here
+//Same layout as INSTANCE_RECORD in VertexShader.hlsl
+struct INSTANCE_RECORD
+{
+	//Level transform holding the world matrix, matrices keep their own buffer so only moved transforms are uploaded
+	unsigned transformIndex;
+	//Model the compressed positions decode against
+	unsigned modelIndex;
+	//Level material, the mesh's own unless the transform overrides it
+	unsigned materialIndex;
+	//MODEL_INSTANCES::flags of the instance the transform belongs to
+	unsigned flags;
+	unsigned lod;
+	//RGBA8 multiplied into the lit color, 0xFFFFFFFF leaves it as it is
+	uint32_t tint;
+};
+static_assert(sizeof(INSTANCE_RECORD) == 24, "INSTANCE_RECORD must match the structured buffer stride in the shaders");
+
+//Keeps the per transform material overrides and tints and writes the instance records of a frame's draws from them
+class Instance_Record_Builder
+{
+public:
+	//Material override of a transform that draws every mesh with its own material
+	static const unsigned noMaterialOverride = ~0u;
+
+private:
+	//What a transform adds to the records of every mesh it draws
+	struct TRANSFORM_INSTANCE
+	{
+		unsigned flags, materialOverride;
+		uint32_t tint;
+	};
+
+	//One per level transform
+	std::vector<TRANSFORM_INSTANCE>							mTransforms;
+	//One per entry of the packet builder's instance transforms
+	std::vector<INSTANCE_RECORD>							mRecords;
+
+public:
+
+	//Clears every override and tint, call again after a level load
+	void Build(const Level_Data& level)
+	{
+		mTransforms.assign(level.levelTransforms.size(), { 0, noMaterialOverride, 0xFFFFFFFF });
+		for (const Level_Data::MODEL_INSTANCES& instances : level.levelInstances)
+			for (unsigned transform = instances.transformStart; transform < instances.transformStart + instances.transformCount; transform++)
+				mTransforms[transform].flags = instances.flags;
+		mRecords.clear();
+	}
+
+	//Records line up with instanceTransforms so a draw's instanceStart finds its first record,
+	//draws split up later keep pointing at the records of the draw they came from
+	void Write(const std::vector<Draw_Packet_Builder::DRAW_PACKET>& draws, const std::vector<unsigned>& instanceTransforms)
+	{
+		mRecords.resize(instanceTransforms.size());
+		for (const Draw_Packet_Builder::DRAW_PACKET& draw : draws)
+			for (unsigned instance = draw.instanceStart; instance < draw.instanceStart + draw.instanceCount; instance++)
+			{
+				unsigned transform = instanceTransforms[instance];
+				const TRANSFORM_INSTANCE& source = mTransforms[transform];
+				INSTANCE_RECORD& record = mRecords[instance];
+				record.transformIndex = transform;
+				record.modelIndex = draw.modelIndex;
+				record.materialIndex = source.materialOverride != noMaterialOverride ? source.materialOverride : draw.materialIndex;
+				record.flags = source.flags;
+				record.lod = draw.lod;
+				record.tint = source.tint;
+			}
+	}
+
+	//Draws every mesh of the transform with one level material, noMaterialOverride goes back to the meshes' own
+	void SetMaterialOverride(unsigned transform, unsigned material) { mTransforms[transform].materialOverride = material; }
+	void SetTint(unsigned transform, uint32_t rgba) { mTransforms[transform].tint = rgba; }
+
+	const std::vector<INSTANCE_RECORD>& GetRecords() const { return mRecords; }
+	unsigned GetSizeInBytes() const { return static_cast<unsigned>(mRecords.size() * sizeof(INSTANCE_RECORD)); }
+
+	//Red in the low byte, the order the vertex shader unpacks
+	static uint32_t PackTint(float red, float green, float blue, float alpha)
+	{
+		float channels[4] = { red, green, blue, alpha };
+		uint32_t packed = 0;
+		for (unsigned c = 0; c < 4; c++)
+		{
+			float unorm = channels[c] < 0 ? 0 : (channels[c] > 1 ? 1 : channels[c]);
+			packed |= static_cast<uint32_t>(unorm * 255.0f + 0.5f) << (c * 8);
+		}
+		return packed;
+	}
+};
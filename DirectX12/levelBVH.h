@@ -0,0 +1,493 @@
+#pragma once
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
+//Bounding volume hierarchy over the world space bounds of every placed transform in a level
+//Built once per level with a binned SAH, refit in place when transforms move
+class Level_BVH
+{
+public:
+	//32 byte node, the two children of an interior node are always stored next to each other
+	struct BVH_NODE
+	{
+		float min[3];
+		//first child when count is 0, otherwise first entry of the leaf in the primitive list
+		unsigned leftOrFirst;
+		float max[3];
+		//primitives in a leaf, 0 for interior nodes
+		unsigned count;
+	};
+
+	struct BVH_BOUNDS
+	{
+		float min[3], max[3];
+	};
+
+private:
+	static constexpr unsigned binCount = 12;
+	static constexpr unsigned maxLeafSize = 8;
+	//SAH cost of visiting a node relative to testing one primitive
+	static constexpr float traversalCost = 1.0f;
+
+public:
+	//Set on transforms returned by QueryFrustum whose bounds are fully inside the frustum
+	static constexpr unsigned insideBit = 0x80000000u;
+
+private:
+
+	std::vector<BVH_NODE>									mNodes;
+	std::vector<unsigned>									mParents;
+	//Level transform indices in leaf order
+	std::vector<unsigned>									mPrimitives;
+	//Per level transform data
+	std::vector<BVH_BOUNDS>									mPrimitiveBounds;
+	std::vector<unsigned>									mPrimitiveModels;
+	std::vector<unsigned>									mLeafOfPrimitive;
+	//Model space box of each model from Level_Data::levelModelBounds
+	std::vector<BVH_BOUNDS>									mModelBounds;
+	//Scratch space reused by refits and queries
+	std::vector<unsigned>									mDirtyNodes;
+	mutable std::vector<unsigned>							mStack;
+
+public:
+
+	//Builds the tree over every transform, worldTransforms is indexed like Level_Data::levelTransforms
+	void Build(const Level_Data& level, const std::vector<GW::MATH::GMATRIXF>& worldTransforms)
+	{
+		const unsigned count = static_cast<unsigned>(worldTransforms.size());
+		mModelBounds.resize(level.levelModels.size());
+		for (size_t model = 0; model < level.levelModels.size(); model++)
+		{
+			BVH_BOUNDS& box = mModelBounds[model];
+			if (model < level.levelModelBounds.size())
+			{
+				const GW::MATH::GAABBMMF& bounds = level.levelModelBounds[model].box;
+				box = { { bounds.min.x, bounds.min.y, bounds.min.z }, { bounds.max.x, bounds.max.y, bounds.max.z } };
+			}
+			else
+				box = {};
+		}
+		mPrimitiveModels.assign(count, ~0u);
+		for (const auto& instance : level.levelInstances)
+			for (unsigned transform = instance.transformStart;
+				transform < instance.transformStart + instance.transformCount && transform < count; transform++)
+				mPrimitiveModels[transform] = instance.modelIndex;
+
+		mPrimitiveBounds.resize(count);
+		for (unsigned transform = 0; transform < count; transform++)
+			mPrimitiveBounds[transform] = ComputeWorldBounds(transform, worldTransforms[transform]);
+
+		mPrimitives.resize(count);
+		for (unsigned transform = 0; transform < count; transform++)
+			mPrimitives[transform] = transform;
+		mNodes.clear();
+		mParents.clear();
+		mLeafOfPrimitive.assign(count, 0);
+		if (count == 0)
+			return;
+
+		std::vector<float> centroids(count * 3);
+		for (unsigned transform = 0; transform < count; transform++)
+			for (int axis = 0; axis < 3; axis++)
+				centroids[transform * 3 + axis] =
+					(mPrimitiveBounds[transform].min[axis] + mPrimitiveBounds[transform].max[axis]) * 0.5f;
+
+		//a binary tree with single primitive leaves never needs more than 2n - 1 nodes
+		mNodes.reserve(count * 2);
+		mParents.reserve(count * 2);
+		mNodes.push_back({});
+		mParents.push_back(~0u);
+		mNodes[0].leftOrFirst = 0;
+		mNodes[0].count = count;
+		UpdateLeafBounds(0);
+		std::vector<unsigned> pending(1, 0);
+		while (pending.empty() == false)
+		{
+			unsigned node = pending.back();
+			pending.pop_back();
+			unsigned left = Split(node, centroids);
+			if (left != 0)
+			{
+				pending.push_back(left);
+				pending.push_back(left + 1);
+			}
+		}
+		for (unsigned node = 0; node < mNodes.size(); node++)
+			if (mNodes[node].count != 0)
+				for (unsigned i = 0; i < mNodes[node].count; i++)
+					mLeafOfPrimitive[mPrimitives[mNodes[node].leftOrFirst + i]] = node;
+	}
+
+	//Recomputes the bounds of the changed transforms and only the nodes above them, the topology is kept
+	void Refit(const std::vector<GW::MATH::GMATRIXF>& worldTransforms, const std::vector<unsigned>& changedTransforms)
+	{
+		if (mNodes.empty())
+			return;
+		mDirtyNodes.clear();
+		for (unsigned transform : changedTransforms)
+		{
+			if (transform >= mPrimitiveBounds.size())
+				continue;
+			mPrimitiveBounds[transform] = ComputeWorldBounds(transform, worldTransforms[transform]);
+			mDirtyNodes.push_back(mLeafOfPrimitive[transform]);
+		}
+		if (mDirtyNodes.empty())
+			return;
+		//children are always stored after their parent, so refitting in descending order settles every level
+		std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+		mDirtyNodes.erase(std::unique(mDirtyNodes.begin(), mDirtyNodes.end()), mDirtyNodes.end());
+		for (unsigned leaf : mDirtyNodes)
+			UpdateLeafBounds(leaf);
+		size_t ancestorStart = mDirtyNodes.size();
+		for (size_t i = 0; i < ancestorStart; i++)
+			for (unsigned parent = mParents[mDirtyNodes[i]]; parent != ~0u; parent = mParents[parent])
+				mDirtyNodes.push_back(parent);
+		std::sort(mDirtyNodes.begin() + ancestorStart, mDirtyNodes.end(), std::greater<unsigned>());
+		unsigned last = ~0u;
+		for (size_t i = ancestorStart; i < mDirtyNodes.size(); i++)
+		{
+			if (mDirtyNodes[i] == last)
+				continue;
+			last = mDirtyNodes[i];
+			const BVH_NODE& left = mNodes[mNodes[last].leftOrFirst];
+			const BVH_NODE& right = mNodes[mNodes[last].leftOrFirst + 1];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				mNodes[last].min[axis] = std::min(left.min[axis], right.min[axis]);
+				mNodes[last].max[axis] = std::max(left.max[axis], right.max[axis]);
+			}
+		}
+	}
+
+	//Appends every transform whose world bounds touch the frustum, planes as made by SIMD_MATH::ExtractFrustumPlanes
+	//Transforms whose bounds are fully inside are tagged with insideBit so callers can skip finer tests
+	void QueryFrustum(const GW::MATH::GVECTORF planes[6], std::vector<unsigned>& outTransforms) const
+	{
+		if (mNodes.empty())
+			return;
+		mStack.clear();
+		mStack.push_back(0);
+		while (mStack.empty() == false)
+		{
+			unsigned entry = mStack.back();
+			mStack.pop_back();
+			const BVH_NODE& node = mNodes[entry & ~insideBit];
+			bool inside = (entry & insideBit) != 0;
+			if (inside == false)
+			{
+				int result = ClassifyBox(node.min, node.max, planes);
+				if (result < 0)
+					continue;
+				inside = result > 0;
+			}
+			if (node.count == 0)
+			{
+				mStack.push_back(node.leftOrFirst | (inside ? insideBit : 0));
+				mStack.push_back((node.leftOrFirst + 1) | (inside ? insideBit : 0));
+				continue;
+			}
+			for (unsigned i = 0; i < node.count; i++)
+			{
+				unsigned transform = mPrimitives[node.leftOrFirst + i];
+				const BVH_BOUNDS& bounds = mPrimitiveBounds[transform];
+				int result = inside ? 1 : ClassifyBox(bounds.min, bounds.max, planes);
+				if (result >= 0)
+					outTransforms.push_back(result > 0 ? (transform | insideBit) : transform);
+			}
+		}
+	}
+
+	//Closest transform whose world bounds the ray enters within maxDistance, direction does not need to be normalized
+	bool RayCast(const float origin[3], const float direction[3], float maxDistance,
+		unsigned& outTransform, float& outDistance) const
+	{
+		if (mNodes.empty())
+			return false;
+		float inverse[3];
+		for (int axis = 0; axis < 3; axis++)
+			inverse[axis] = direction[axis] != 0 ? 1.0f / direction[axis] : FLT_MAX;
+		float closest = maxDistance;
+		bool hit = false;
+		mStack.clear();
+		if (RayBox(origin, inverse, mNodes[0].min, mNodes[0].max, closest) < closest)
+			mStack.push_back(0);
+		while (mStack.empty() == false)
+		{
+			const BVH_NODE& node = mNodes[mStack.back()];
+			mStack.pop_back();
+			if (node.count != 0)
+			{
+				for (unsigned i = 0; i < node.count; i++)
+				{
+					unsigned transform = mPrimitives[node.leftOrFirst + i];
+					float distance = RayBox(origin, inverse,
+						mPrimitiveBounds[transform].min, mPrimitiveBounds[transform].max, closest);
+					if (distance < closest)
+					{
+						closest = distance;
+						outTransform = transform;
+						hit = true;
+					}
+				}
+				continue;
+			}
+			//visit the closer child first so it can shrink the search for the other
+			unsigned closer = node.leftOrFirst, further = node.leftOrFirst + 1;
+			float closerDistance = RayBox(origin, inverse, mNodes[closer].min, mNodes[closer].max, closest);
+			float furtherDistance = RayBox(origin, inverse, mNodes[further].min, mNodes[further].max, closest);
+			if (furtherDistance < closerDistance)
+			{
+				std::swap(closer, further);
+				std::swap(closerDistance, furtherDistance);
+			}
+			if (furtherDistance < closest)
+				mStack.push_back(further);
+			if (closerDistance < closest)
+				mStack.push_back(closer);
+		}
+		if (hit)
+			outDistance = closest;
+		return hit;
+	}
+
+	//Appends every transform whose world bounds overlap the sphere
+	void QuerySphere(const float center[3], float radius, std::vector<unsigned>& outTransforms) const
+	{
+		if (mNodes.empty())
+			return;
+		const float radiusSquared = radius * radius;
+		mStack.clear();
+		mStack.push_back(0);
+		while (mStack.empty() == false)
+		{
+			const BVH_NODE& node = mNodes[mStack.back()];
+			mStack.pop_back();
+			if (DistanceSquared(center, node.min, node.max) > radiusSquared)
+				continue;
+			if (node.count == 0)
+			{
+				mStack.push_back(node.leftOrFirst);
+				mStack.push_back(node.leftOrFirst + 1);
+				continue;
+			}
+			for (unsigned i = 0; i < node.count; i++)
+			{
+				unsigned transform = mPrimitives[node.leftOrFirst + i];
+				if (DistanceSquared(center, mPrimitiveBounds[transform].min, mPrimitiveBounds[transform].max) <= radiusSquared)
+					outTransforms.push_back(transform);
+			}
+		}
+	}
+
+	const std::vector<BVH_NODE>& GetNodes() const { return mNodes; }
+	const BVH_BOUNDS& GetWorldBounds(unsigned transformIndex) const { return mPrimitiveBounds[transformIndex]; }
+
+private:
+
+	//World AABB of a model box placed by a row vector matrix
+	BVH_BOUNDS ComputeWorldBounds(unsigned transform, const GW::MATH::GMATRIXF& world) const
+	{
+		BVH_BOUNDS out = {};
+		unsigned model = mPrimitiveModels[transform];
+		const BVH_BOUNDS local = model < mModelBounds.size() ? mModelBounds[model] : BVH_BOUNDS{};
+		const float* m = world.data;
+		for (int column = 0; column < 3; column++)
+		{
+			//each world axis is the translation plus the min/max contribution of every local axis
+			out.min[column] = out.max[column] = m[12 + column];
+			for (int row = 0; row < 3; row++)
+			{
+				float a = local.min[row] * m[row * 4 + column];
+				float b = local.max[row] * m[row * 4 + column];
+				out.min[column] += std::min(a, b);
+				out.max[column] += std::max(a, b);
+			}
+		}
+		return out;
+	}
+
+	void UpdateLeafBounds(unsigned node)
+	{
+		BVH_NODE& leaf = mNodes[node];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			leaf.min[axis] = FLT_MAX;
+			leaf.max[axis] = -FLT_MAX;
+		}
+		for (unsigned i = 0; i < leaf.count; i++)
+		{
+			const BVH_BOUNDS& bounds = mPrimitiveBounds[mPrimitives[leaf.leftOrFirst + i]];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				leaf.min[axis] = std::min(leaf.min[axis], bounds.min[axis]);
+				leaf.max[axis] = std::max(leaf.max[axis], bounds.max[axis]);
+			}
+		}
+	}
+
+	static float HalfArea(const float min[3], const float max[3])
+	{
+		float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+		return x * y + y * z + z * x;
+	}
+
+	//Splits a leaf with the cheapest binned SAH plane, returns the first child or 0 if it stays a leaf
+	unsigned Split(unsigned nodeIndex, const std::vector<float>& centroids)
+	{
+		const unsigned first = mNodes[nodeIndex].leftOrFirst;
+		const unsigned count = mNodes[nodeIndex].count;
+		if (count <= 1)
+			return 0;
+
+		float centroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, centroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (unsigned i = first; i < first + count; i++)
+			for (int axis = 0; axis < 3; axis++)
+			{
+				centroidMin[axis] = std::min(centroidMin[axis], centroids[mPrimitives[i] * 3 + axis]);
+				centroidMax[axis] = std::max(centroidMax[axis], centroids[mPrimitives[i] * 3 + axis]);
+			}
+
+		struct BIN { BVH_BOUNDS bounds; unsigned count; };
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		unsigned bestBin = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0)
+				continue;
+			BIN bins[binCount];
+			for (BIN& bin : bins)
+				bin = { { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } }, 0 };
+			const float scale = binCount / extent;
+			for (unsigned i = first; i < first + count; i++)
+			{
+				unsigned transform = mPrimitives[i];
+				unsigned bin = std::min(binCount - 1,
+					static_cast<unsigned>((centroids[transform * 3 + axis] - centroidMin[axis]) * scale));
+				bins[bin].count++;
+				for (int k = 0; k < 3; k++)
+				{
+					bins[bin].bounds.min[k] = std::min(bins[bin].bounds.min[k], mPrimitiveBounds[transform].min[k]);
+					bins[bin].bounds.max[k] = std::max(bins[bin].bounds.max[k], mPrimitiveBounds[transform].max[k]);
+				}
+			}
+			//sweep from both sides to get the area/count left and right of every plane between bins
+			float leftArea[binCount - 1], rightArea[binCount - 1];
+			unsigned leftCount[binCount - 1], rightCount[binCount - 1];
+			BVH_BOUNDS leftBox = bins[0].bounds, rightBox = bins[binCount - 1].bounds;
+			unsigned leftSum = 0, rightSum = 0;
+			for (unsigned plane = 0; plane < binCount - 1; plane++)
+			{
+				const BVH_BOUNDS& l = bins[plane].bounds;
+				const BVH_BOUNDS& r = bins[binCount - 1 - plane].bounds;
+				for (int k = 0; k < 3; k++)
+				{
+					leftBox.min[k] = std::min(leftBox.min[k], l.min[k]);
+					leftBox.max[k] = std::max(leftBox.max[k], l.max[k]);
+					rightBox.min[k] = std::min(rightBox.min[k], r.min[k]);
+					rightBox.max[k] = std::max(rightBox.max[k], r.max[k]);
+				}
+				leftSum += bins[plane].count;
+				rightSum += bins[binCount - 1 - plane].count;
+				leftCount[plane] = leftSum;
+				leftArea[plane] = leftSum ? HalfArea(leftBox.min, leftBox.max) : 0;
+				rightCount[binCount - 2 - plane] = rightSum;
+				rightArea[binCount - 2 - plane] = rightSum ? HalfArea(rightBox.min, rightBox.max) : 0;
+			}
+			for (unsigned plane = 0; plane < binCount - 1; plane++)
+			{
+				if (leftCount[plane] == 0 || rightCount[plane] == 0)
+					continue;
+				float cost = leftCount[plane] * leftArea[plane] + rightCount[plane] * rightArea[plane];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = plane;
+				}
+			}
+		}
+		//small nodes stay leaves when visiting two children does not beat testing every primitive
+		const float nodeArea = HalfArea(mNodes[nodeIndex].min, mNodes[nodeIndex].max);
+		if (bestAxis == -1 || (count <= maxLeafSize && bestCost + traversalCost * nodeArea >= count * nodeArea))
+			return 0;
+
+		const float scale = binCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+		auto middle = std::partition(mPrimitives.begin() + first, mPrimitives.begin() + first + count,
+			[&](unsigned transform) {
+				unsigned bin = std::min(binCount - 1,
+					static_cast<unsigned>((centroids[transform * 3 + bestAxis] - centroidMin[bestAxis]) * scale));
+				return bin <= bestBin;
+			});
+		const unsigned leftSize = static_cast<unsigned>(middle - mPrimitives.begin()) - first;
+		if (leftSize == 0 || leftSize == count)
+			return 0;
+
+		const unsigned left = static_cast<unsigned>(mNodes.size());
+		mNodes.push_back({});
+		mNodes.push_back({});
+		mParents.push_back(nodeIndex);
+		mParents.push_back(nodeIndex);
+		mNodes[left].leftOrFirst = first;
+		mNodes[left].count = leftSize;
+		mNodes[left + 1].leftOrFirst = first + leftSize;
+		mNodes[left + 1].count = count - leftSize;
+		UpdateLeafBounds(left);
+		UpdateLeafBounds(left + 1);
+		mNodes[nodeIndex].leftOrFirst = left;
+		mNodes[nodeIndex].count = 0;
+		return left;
+	}
+
+	//-1 outside, 0 intersecting, 1 fully inside
+	static int ClassifyBox(const float min[3], const float max[3], const GW::MATH::GVECTORF planes[6])
+	{
+		int result = 1;
+		for (int p = 0; p < 6; p++)
+		{
+			const GW::MATH::GVECTORF& plane = planes[p];
+			//corner furthest along the normal decides outside, the nearest one decides inside
+			float outerDistance = plane.w + plane.x * (plane.x >= 0 ? max[0] : min[0]) +
+				plane.y * (plane.y >= 0 ? max[1] : min[1]) + plane.z * (plane.z >= 0 ? max[2] : min[2]);
+			if (outerDistance < 0)
+				return -1;
+			float innerDistance = plane.w + plane.x * (plane.x >= 0 ? min[0] : max[0]) +
+				plane.y * (plane.y >= 0 ? min[1] : max[1]) + plane.z * (plane.z >= 0 ? min[2] : max[2]);
+			if (innerDistance < 0)
+				result = 0;
+		}
+		return result;
+	}
+
+	//Entry distance of a slab test, FLT_MAX on a miss or when it starts beyond maxDistance
+	static float RayBox(const float origin[3], const float inverse[3], const float min[3], const float max[3], float maxDistance)
+	{
+		float enter = 0, exit = maxDistance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (min[axis] - origin[axis]) * inverse[axis];
+			float t1 = (max[axis] - origin[axis]) * inverse[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			enter = std::max(enter, t0);
+			exit = std::min(exit, t1);
+			if (enter > exit)
+				return FLT_MAX;
+		}
+		return enter;
+	}
+
+	static float DistanceSquared(const float point[3], const float min[3], const float max[3])
+	{
+		float result = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float d = point[axis] < min[axis] ? min[axis] - point[axis] : (point[axis] > max[axis] ? point[axis] - max[axis] : 0);
+			result += d * d;
+		}
+		return result;
+	}
+};
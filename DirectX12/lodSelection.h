@@ -0,0 +1,104 @@
+#pragma once
+#include <cmath>
+
+//Picks a level of detail for every visible transform from how big its simplification error would look on screen
+//Select takes the coarsest LOD whose error covers at most the threshold's fraction of the viewport height
+class Lod_Selector
+{
+public:
+	//What the visible transforms of the last Select cost, LOD 0 is full detail
+	struct LOD_STATS
+	{
+		unsigned instances[Level_Data::maxLodCount];
+		//Triangles drawn and what the same transforms would have drawn at LOD 0
+		unsigned long long triangles, fullDetailTriangles;
+	};
+
+private:
+	//LOD of every level transform, only visible transforms are written by Select
+	std::vector<unsigned char>								mLods;
+	//Triangles of every entry of levelLods
+	std::vector<unsigned>									mLodTriangles;
+	//A LOD is used while its error covers at most this fraction of the viewport height
+	float													mThreshold = 0.001f;
+	bool													mEnabled = true;
+	LOD_STATS												mStats = {};
+
+public:
+
+	//Sizes the per transform LODs and counts the triangles of every LOD, call again after a level load
+	void Build(const Level_Data& level)
+	{
+		mLods.assign(level.levelTransforms.size(), 0);
+		mLodTriangles.assign(level.levelLods.size(), 0);
+		for (const Level_Data::LEVEL_MODEL& model : level.levelModels)
+			for (unsigned lod = model.lodStart; lod < model.lodStart + model.lodCount; lod++)
+				for (unsigned mesh = 0; mesh < model.meshCount; mesh++)
+					mLodTriangles[lod] += level.levelLodDraws[level.levelLods[lod].drawStart + mesh].indexCount / 3;
+		mStats = {};
+	}
+
+	void Select(const Level_Data& level, const std::vector<Frustum_Culler::VISIBLE_RUN>& runs,
+		const std::vector<GW::MATH::GMATRIXF>& worldTransforms, const GW::MATH::GMATRIXF& viewProjection)
+	{
+		mStats = {};
+		//The y column of the view rotation is unit length, what is left is the projection's y scale
+		float projectionScale = std::sqrt(viewProjection.row1.y * viewProjection.row1.y +
+			viewProjection.row2.y * viewProjection.row2.y + viewProjection.row3.y * viewProjection.row3.y);
+		for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+		{
+			unsigned modelIndex = level.levelInstances[run.instanceIndex].modelIndex;
+			const Level_Data::LEVEL_MODEL& model = level.levelModels[modelIndex];
+			const GW::MATH::GSPHEREF& sphere = level.levelModelBounds[modelIndex].sphere;
+			for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+			{
+				unsigned lod = mEnabled ? SelectLod(level, model, sphere, worldTransforms[transform], viewProjection, projectionScale) : 0;
+				mLods[transform] = static_cast<unsigned char>(lod);
+				mStats.instances[lod]++;
+				mStats.triangles += mLodTriangles[model.lodStart + lod];
+				mStats.fullDetailTriangles += mLodTriangles[model.lodStart];
+			}
+		}
+	}
+
+	//LOD the last Select picked for a visible transform
+	unsigned GetLod(unsigned transform) const { return mLods[transform]; }
+
+	//Fraction of the viewport height a LOD's error may cover, 0.001 is about a pixel at 1080p
+	void SetThreshold(float threshold) { mThreshold = threshold; }
+	//Disabled every transform draws LOD 0
+	void SetEnabled(bool enabled) { mEnabled = enabled; }
+	bool IsEnabled() const { return mEnabled; }
+	const LOD_STATS& GetStats() const { return mStats; }
+
+private:
+
+	unsigned SelectLod(const Level_Data& level, const Level_Data::LEVEL_MODEL& model, const GW::MATH::GSPHEREF& sphere,
+		const GW::MATH::GMATRIXF& world, const GW::MATH::GMATRIXF& viewProjection, float projectionScale) const
+	{
+		if (model.lodCount < 2)
+			return 0;
+		//Distance to the nearest point of the bounding sphere along the view direction
+		GW::MATH::GVECTORF center = {
+			sphere.x * world.row1.x + sphere.y * world.row2.x + sphere.z * world.row3.x + world.row4.x,
+			sphere.x * world.row1.y + sphere.y * world.row2.y + sphere.z * world.row3.y + world.row4.y,
+			sphere.x * world.row1.z + sphere.y * world.row2.z + sphere.z * world.row3.z + world.row4.z, 1 };
+		float scale = std::sqrt(std::fmax(RowLengthSquared(world.row1), std::fmax(RowLengthSquared(world.row2), RowLengthSquared(world.row3))));
+		float viewDepth = center.x * viewProjection.row1.w + center.y * viewProjection.row2.w +
+			center.z * viewProjection.row3.w + viewProjection.row4.w;
+		float distance = viewDepth - sphere.radius * scale;
+		if (!(distance > 0))
+			return 0;
+		//NDC is 2 units high, so half the projected error is the fraction of the viewport it covers
+		float screenPerUnit = scale * projectionScale * 0.5f / distance;
+		unsigned lod = 0;
+		while (lod + 1 < model.lodCount && level.levelLods[model.lodStart + lod + 1].error * screenPerUnit <= mThreshold)
+			lod++;
+		return lod;
+	}
+
+	static float RowLengthSquared(const GW::MATH::GVECTORF& row)
+	{
+		return row.x * row.x + row.y * row.y + row.z * row.z;
+	}
+};
@@ -1,4 +1,17 @@
 #include "h2bParser.h"
+#include "mappedFile.h"
+#include "simdMath.h"
+#include "meshOptimizer.h"
+#include "indexPools.h"
+#include "vertexCompression.h"
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <thread>
 
 
 class Level_Data {
@@ -6,13 +19,27 @@ class Level_Data {
 
 	// transfered from parser
 	std::set<std::string> level_strings;
+	// *NEW* cooked level the geometry views point into when mapped
+	Mapped_File cookedMapping;
 public:
+	// *NEW* non-owning view of level data (see levelVertexView/levelIndexView)
+	template<typename T>
+	struct LEVEL_VIEW
+	{
+		const T* data = nullptr;
+		size_t count = 0;
+		size_t size() const { return count; }
+		const T* begin() const { return data; }
+		const T* end() const { return data + count; }
+		const T& operator[](size_t i) const { return data[i]; }
+	};
 	struct LEVEL_MODEL // one model in the level
 	{
 		const char* filename; // .h2b file data was pulled from
 		unsigned vertexCount, indexCount, materialCount, meshCount;
 		unsigned vertexStart, indexStart, materialStart, meshStart, batchStart;
 		unsigned colliderIndex;// *NEW* location of OBB in levelColliders
+		unsigned lodStart, lodCount;// *NEW* range in levelLods, indexCount includes the simplified LOD indices
 	};
 	struct MODEL_INSTANCES // each instance of a model in the level
 	{
@@ -28,9 +55,61 @@ public:
 		unsigned int modelIndex, transformIndex;
 		int parentTransformIndex;
 	};
+	struct LEVEL_LOD // *NEW* one level of detail of a model, LOD 0 draws the model's own meshes
+	{
+		float error; // furthest the simplified surface strays from the original, in model units
+		unsigned drawStart; // first of the model's meshCount draws in levelLodDraws, in mesh order
+	};
+	struct LEVEL_MESHLET // *NEW* a small cluster of one mesh's triangles that can be culled on its own
+	{
+		GW::MATH::GSPHEREF sphere; // model space, around every vertex it uses
+		GW::MATH::GVECTORF cone; // xyz unit axis of its triangle normals, w cosine of the widest one (<= 0 never faces away)
+		unsigned indexOffset, indexCount; // relative to the model like H2B::BATCH
+	};
+	struct LEVEL_MESHLET_RANGE // *NEW* the meshlets of one mesh, they cover its index range in order
+	{
+		unsigned meshletStart, meshletCount;
+	};
+	struct LEVEL_BOUNDS // *NEW* tight bounds of some geometry in model space
+	{
+		GW::MATH::GAABBMMF box; // min/max of every vertex used
+		GW::MATH::GSPHEREF sphere; // centered on the box, radius reaches the furthest vertex
+	};
 	// All geometry data combined for level to be loaded onto the video card
 	std::vector<H2B::VERTEX> levelVertices;
 	std::vector<unsigned> levelIndices;
+	// *NEW* What the GPU upload should read from. When a cooked level is mapped these
+	// point straight into the file mapping and levelVertices/levelIndices stay empty.
+	LEVEL_VIEW<H2B::VERTEX> levelVertexView;
+	LEVEL_VIEW<unsigned> levelIndexView;
+	// *NEW* levelIndices repacked into the pools the GPU reads, 16 bit for every model that fits (see Index_Pool_Builder)
+	// mapped like the geometry above so the index buffers upload straight from the cooked level
+	std::vector<uint16_t> levelShortIndices;
+	std::vector<unsigned> levelLongIndices;
+	LEVEL_VIEW<uint16_t> levelShortIndexView;
+	LEVEL_VIEW<unsigned> levelLongIndexView;
+	std::vector<Index_Pool_Builder::MODEL_INDICES> levelModelIndices; // same size as levelModels
+	// *NEW* levelVertices compressed to 16 bytes for the GPU (see Vertex_Compressor), same order so indices still apply
+	std::vector<COMPRESSED_VERTEX> levelCompressedVertices;
+	LEVEL_VIEW<COMPRESSED_VERTEX> levelCompressedVertexView;
+	std::vector<VERTEX_QUANTIZATION> levelVertexQuantization; // same size as levelModels
+	// *NEW* map cooked geometry instead of copying it, set before calling LoadLevel
+	bool mapCookedGeometry = true;
+	// *NEW* reorder imported triangles and vertices for the GPU caches, set before calling LoadLevel
+	// a cooked level keeps the order it was cooked with
+	bool optimizeMeshes = true;
+	// *NEW* also order triangle clusters to cut overdraw, costs a little vertex cache efficiency
+	bool optimizeOverdraw = false;
+	// *NEW* simplify every imported model into up to maxLodCount levels of detail, set before calling LoadLevel
+	bool generateLods = true;
+	// *NEW* furthest a LOD may stray from the original, relative to the model's bounding radius
+	float lodMaxError = 0.1f;
+	static constexpr unsigned maxLodCount = 4; // LOD 0 included
+	// *NEW* split every mesh into meshlets for cluster culling, set before calling LoadLevel
+	bool buildMeshlets = true;
+	static constexpr unsigned meshletMaxVertices = 64, meshletMaxTriangles = 124;
+	// *NEW* threads importing .h2b files, 0 uses one per hardware thread, the result is the same for any count
+	unsigned importWorkers = 0;
 	// All material data used by the level
 	std::vector<H2B::MATERIAL> levelMaterials;
 	// This could be populated by the Level_Renderer during GPU transfer
@@ -39,218 +118,830 @@ public:
 	std::vector<GW::MATH::GMATRIXF> levelTransforms;
 	// *NEW* All level boundry data used by the models
 	std::vector<GW::MATH::GOBBF> levelColliders;
+	// *NEW* Bounds computed from the geometry while importing
+	std::vector<LEVEL_BOUNDS> levelModelBounds; // same size as levelModels
+	std::vector<LEVEL_BOUNDS> levelMeshBounds; // same size as levelMeshes
 	// All required drawing information combined
 	std::vector<H2B::BATCH> levelBatches;
 	std::vector<H2B::MESH> levelMeshes;
 	std::vector<LEVEL_MODEL> levelModels;
+	// *NEW* levels of detail of every model, index ranges are relative to the model like H2B::MESH
+	std::vector<LEVEL_LOD> levelLods;
+	std::vector<H2B::BATCH> levelLodDraws;
+	// *NEW* meshlets of every mesh at full detail, the LODs draw whole
+	std::vector<LEVEL_MESHLET> levelMeshlets;
+	std::vector<LEVEL_MESHLET_RANGE> levelMeshletRanges; // same size as levelMeshes
 	// what we actually draw once loaded (using GPU instancing)
 	std::vector<MODEL_INSTANCES> levelInstances;
 	// *NEW* each item from the blender scene graph
 	std::vector<BLENDER_OBJECT> blenderObjects;
 
 	// Imports the default level txt format and collects all .h2b data
+	// *NEW* if a cooked binary of the level exists next to the txt it is loaded instead
 	bool LoadLevel(const char* gameLevelPath,
 		const char* h2bFolderPath,
 		GW::SYSTEM::GLog log) {
 		// What this does:
-		// Parse GameLevel.txt 
+		// Check for an up to date cooked level (GameLevel.lvl) and bulk load it if found.
+		// Otherwise parse GameLevel.txt 
 		// For each model found in the file...
 			// if not encountered create new unique temporary model entry.
 				// Add model transform to a list of transforms for this model.(instances)
 			// if already encountered, just add its transfrom to the existing model entry.
 		// when finished, traverse model entries to import each model's data to the class.
-		std::set<MODEL_ENTRY> uniqueModels; // unique models and their locations
+		// Finally cook the result so the next launch can skip all of the above.
 		log.LogCategorized("EVENT", "LOADING GAME LEVEL [DATA ORIENTED]");
+		auto loadStart = std::chrono::steady_clock::now();
 
 		UnloadLevel();// clear previous level data if there is any
-		if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
-			log.LogCategorized("ERROR", "Fatal error reading game level, aborting level load.");
-			return false;
-		}
-		if (ReadAndCombineH2Bs(h2bFolderPath, uniqueModels, log) == false) {
-			log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
-			return false;
+		const std::string cookedPath = GetCookedLevelPath(gameLevelPath);
+		if (ReadCookedLevel(cookedPath.c_str(), gameLevelPath, h2bFolderPath, log) == false) {
+			if (ImportLevel(gameLevelPath, h2bFolderPath, log) == false)
+				return false;
+			WriteCookedLevel(cookedPath.c_str(), gameLevelPath, h2bFolderPath, log);
 		}
+		if (cookedMapping.IsOpen() == false)
+			ViewOwnedGeometry();
 		// level loaded into CPU ram
-		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [DATA ORIENTED]");
+		auto loadTime = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - loadStart).count() / 1000.0f;
+		log.LogCategorized("EVENT", (std::string("GAME LEVEL WAS LOADED TO CPU [DATA ORIENTED] in ") +
+			std::to_string(loadTime) + " ms").c_str());
 		return true;
 	}
+	// *NEW* Offline cook step, always imports from the txt & .h2b files and writes a cooked level
+	bool CookLevel(const char* gameLevelPath,
+		const char* h2bFolderPath,
+		GW::SYSTEM::GLog log) {
+		log.LogCategorized("EVENT", "COOKING GAME LEVEL [DATA ORIENTED]");
+		UnloadLevel();
+		if (ImportLevel(gameLevelPath, h2bFolderPath, log) == false)
+			return false;
+		return WriteCookedLevel(GetCookedLevelPath(gameLevelPath).c_str(), gameLevelPath, h2bFolderPath, log);
+	}
+	// *NEW* only reads GameLevel.txt and links every object to its parent, no model is imported
+	// returns how many objects it holds, 0 when it could not be read (lets the parse be timed on its own)
+	unsigned ReadGameLevelObjects(const char* gameLevelPath, GW::SYSTEM::GLog log) {
+		std::set<MODEL_ENTRY> models;
+		if (ReadGameLevel(gameLevelPath, models, log) == false)
+			return 0;
+		size_t objects = 0;
+		for (const MODEL_ENTRY& model : models)
+			objects += model.objects.size();
+		return static_cast<unsigned>(objects);
+	}
+	// *NEW* the cooked level lives next to the GameLevel.txt it was built from
+	static std::string GetCookedLevelPath(const char* gameLevelPath) {
+		std::string cookedPath = gameLevelPath;
+		return cookedPath.substr(0, cookedPath.find_last_of(".")) + ".lvl";
+	}
 	// used to wipe CPU level data between levels
 	void UnloadLevel() {
+		levelVertexView = {};
+		levelIndexView = {};
+		levelShortIndexView = {};
+		levelLongIndexView = {};
+		levelCompressedVertexView = {};
+		cookedMapping.Close();
 		level_strings.clear();
 		levelVertices.clear();
 		levelIndices.clear();
+		levelShortIndices.clear();
+		levelLongIndices.clear();
+		levelModelIndices.clear();
+		levelCompressedVertices.clear();
+		levelVertexQuantization.clear();
 		levelMaterials.clear();
 		levelTextures.clear();
 		levelBatches.clear();
 		levelMeshes.clear();
 		levelModels.clear();
+		levelLods.clear();
+		levelLodDraws.clear();
+		levelMeshlets.clear();
+		levelMeshletRanges.clear();
 		levelTransforms.clear();
+		levelColliders.clear();
+		levelModelBounds.clear();
+		levelMeshBounds.clear();
 		levelInstances.clear();
 		blenderObjects.clear();
 	}
+	// *NEW* GameLevel.txt tokenizer used by ReadGameLevel, static so it can be benchmarked on its own
+	// one trimmed line of GameLevel.txt
+	struct LEVEL_LINE
+	{
+		const char* start; // first non whitespace character
+		const char* end; // one past the last non whitespace character
+		unsigned indent; // leading whitespace, nested MESH entries are indented
+		bool Equals(const char* token) const {
+			size_t length = std::strlen(token);
+			return static_cast<size_t>(end - start) == length && std::memcmp(start, token, length) == 0;
+		}
+	};
+	// reads an entire file with one read
+	static bool ReadWholeFile(const char* filePath, std::vector<char>& outData) {
+		GW::SYSTEM::GFile file;
+		file.Create();
+		unsigned fileSize = 0;
+		if (-file.GetFileSize(filePath, fileSize) || -file.OpenBinaryRead(filePath))
+			return false;
+		outData.resize(fileSize);
+		GW::GReturn result = fileSize ? file.Read(outData.data(), fileSize) : GW::GReturn::SUCCESS;
+		file.CloseFile();
+		return G_PASS(result);
+	}
+	// returns the next non blank line, tolerates \r\n and any indentation
+	static bool NextLevelLine(const char*& cursor, const char* end, LEVEL_LINE& outLine) {
+		while (cursor < end) {
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+			if (lineEnd == nullptr)
+				lineEnd = end;
+			outLine.start = cursor;
+			while (outLine.start < lineEnd && (*outLine.start == ' ' || *outLine.start == '\t'))
+				++outLine.start;
+			outLine.indent = static_cast<unsigned>(outLine.start - cursor);
+			outLine.end = lineEnd;
+			while (outLine.end > outLine.start && std::isspace(static_cast<unsigned char>(outLine.end[-1])))
+				--outLine.end;
+			cursor = (lineEnd < end) ? lineEnd + 1 : end;
+			if (outLine.end > outLine.start)
+				return true;
+		}
+		return false;
+	}
+	// parses the 4 "(x, y, z, w)" rows of an exported matrix, the first row is on the cursor's line and
+	// every other row starts the line after it, a line that is not a continuation row fails the entry
+	// so a truncated matrix never borrows rows from the next MESH
+	static bool ParseLevelMatrix(const char*& cursor, const char* end, GW::MATH::GMATRIXF& outMatrix) {
+		for (int row = 0; row < 4; ++row) {
+			if (row == 0) {
+				const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+				cursor = static_cast<const char*>(std::memchr(cursor, '(', (lineEnd != nullptr ? lineEnd : end) - cursor));
+			}
+			else {
+				const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+				if (lineEnd == nullptr)
+					return false;
+				cursor = lineEnd + 1;
+				while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+					++cursor;
+				if (cursor == end || *cursor != '(')
+					cursor = nullptr;
+			}
+			if (cursor == nullptr)
+				return false;
+			++cursor;
+			for (int col = 0; col < 4; ++col) {
+				while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == ',' || *cursor == '+'))
+					++cursor;
+				std::from_chars_result read = std::from_chars(cursor, end, outMatrix.data[col + row * 4]);
+				if (read.ec != std::errc())
+					return false;
+				cursor = read.ptr;
+			}
+		}
+		// skip the rest of the last row, ")>"
+		const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		cursor = (lineEnd != nullptr) ? lineEnd + 1 : end;
+		return true;
+	}
 	// *NO RENDERING/GPU/DRAW LOGIC IN HERE PLEASE* 
 	// *DATA ORIENTED SHOULD AIM TO SEPERATE DATA FROM THE LOGIC THAT USES IT*
 	// The Level Renderer class is a good place to utilize this data.
 	// You can use your chosen API to have one GPU buffer for each type of data.
 	// Then you loop through instances using the API features to draw each mesh only once.
 private:
+	// *NEW* Layout of a cooked level (.lvl), one header followed by raw arrays.
+	// Every array is written exactly as it sits in memory so loading is a bulk copy.
+	// String pointers are stored as (offset + 1) into the STRINGS section, 0 == nullptr.
+	enum COOKED_SECTION_TYPE {
+		VERTICES, INDICES, MATERIALS, BATCHES, MESHES, MODELS,
+		INSTANCES, TRANSFORMS, COLLIDERS, BLENDER_OBJECTS, STRINGS,
+		MODEL_BOUNDS, MESH_BOUNDS, LODS, LOD_DRAWS, MESHLETS, MESHLET_RANGES, MODEL_SOURCES,
+		SHORT_INDICES, LONG_INDICES, MODEL_INDEX_POOLS, PACKED_VERTICES, MODEL_QUANTIZATION,
+		COOKED_SECTION_COUNT
+	};
+	struct COOKED_SECTION
+	{
+		unsigned offset, count; // byte offset from start of file, element count
+	};
+	// *NEW* import settings that change the cooked data, a cook with other settings is stale
+	struct COOKED_OPTIONS
+	{
+		unsigned optimizeMeshes, optimizeOverdraw, generateLods, buildMeshlets;
+		float lodMaxError;
+		unsigned maxLodCount, meshletMaxVertices, meshletMaxTriangles;
+	};
+	// *NEW* the .h2b a model was imported from as it was when cooked, one per levelModels entry
+	struct COOKED_MODEL_SOURCE
+	{
+		unsigned long long size;
+		long long writeTime; // file clock ticks, only ever compared for equality
+	};
+	struct COOKED_HEADER
+	{
+		char magic[4]; // "LVLC"
+		unsigned version; // bump when any cooked struct changes
+		unsigned pointerSize; // cooked levels are not shared between 32/64 bit builds
+		unsigned sourceSize; // size of the GameLevel.txt this was cooked from
+		unsigned long long sourceHash; // *NEW* FNV-1a of the GameLevel.txt contents
+		COOKED_OPTIONS options; // *NEW*
+		COOKED_SECTION sections[COOKED_SECTION_COUNT];
+	};
+	static constexpr unsigned cookedVersion = 8;
+	static constexpr unsigned cookedAlignment = 16; // keeps every section SIMD/map friendly
+
+	// *NEW* internal helper that captures the import settings this instance would cook with
+	COOKED_OPTIONS GetCookedOptions() const {
+		COOKED_OPTIONS options = {};
+		options.optimizeMeshes = optimizeMeshes ? 1 : 0;
+		options.optimizeOverdraw = optimizeOverdraw ? 1 : 0;
+		options.generateLods = generateLods ? 1 : 0;
+		options.buildMeshlets = buildMeshlets ? 1 : 0;
+		options.lodMaxError = lodMaxError;
+		options.maxLodCount = maxLodCount;
+		options.meshletMaxVertices = meshletMaxVertices;
+		options.meshletMaxTriangles = meshletMaxTriangles;
+		return options;
+	}
+	// *NEW* internal helper that hashes the whole GameLevel.txt (FNV-1a), an unreadable file hashes to 0
+	static unsigned long long HashSourceFile(const char* path, unsigned& outSize) {
+		GW::SYSTEM::GFile file;
+		file.Create();
+		outSize = 0;
+		if (-file.GetFileSize(path, outSize) || -file.OpenBinaryRead(path))
+			return 0;
+		std::vector<char> contents(outSize);
+		GW::GReturn readResult = outSize > 0 ? file.Read(contents.data(), outSize) : GW::GReturn::SUCCESS;
+		file.CloseFile();
+		if (G_FAIL(readResult))
+			return 0;
+		unsigned long long hash = 14695981039346656037ull;
+		for (char c : contents)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		return hash;
+	}
+	// *NEW* internal helper that stamps one .h2b with its size & last write time, false if it can't be found
+	static bool StampModelSource(const std::string& path, COOKED_MODEL_SOURCE& out) {
+		std::error_code error;
+		out.size = std::filesystem::file_size(path, error);
+		if (error)
+			return false;
+		out.writeTime = static_cast<long long>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+		return !error;
+	}
+	// internal helper that imports the level the slow way (txt + .h2b files)
+	bool ImportLevel(const char* gameLevelPath,
+		const char* h2bFolderPath,
+		GW::SYSTEM::GLog log) {
+		std::set<MODEL_ENTRY> uniqueModels; // unique models and their locations
+		if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
+			log.LogCategorized("ERROR", "Fatal error reading game level, aborting level load.");
+			return false;
+		}
+		if (ReadAndCombineH2Bs(h2bFolderPath, uniqueModels, log) == false) {
+			log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
+			return false;
+		}
+		return true;
+	}
+	// internal helper that converts a string pointer to a cooked string offset
+	static const char* CookString(const char* str, std::string& stringTable) {
+		if (str == nullptr)
+			return nullptr;
+		std::uintptr_t offset = stringTable.size() + 1;
+		stringTable.append(str, std::strlen(str) + 1);
+		return reinterpret_cast<const char*>(offset);
+	}
+	// internal helper that converts a cooked string offset back to a level string
+	const char* UncookString(const char* str, const char* stringTable, unsigned stringTableSize) {
+		std::uintptr_t offset = reinterpret_cast<std::uintptr_t>(str);
+		if (offset == 0 || offset > stringTableSize)
+			return nullptr;
+		return level_strings.insert(stringTable + offset - 1).first->c_str();
+	}
+	// internal helper that appends one array to the cooked blob
+	template<typename T>
+	static void CookSection(std::vector<char>& blob, COOKED_HEADER& header,
+		COOKED_SECTION_TYPE type, const T* data, size_t count) {
+		blob.resize((blob.size() + cookedAlignment - 1) & ~size_t(cookedAlignment - 1));
+		header.sections[type].offset = static_cast<unsigned>(blob.size());
+		header.sections[type].count = static_cast<unsigned>(count);
+		const char* bytes = reinterpret_cast<const char*>(data);
+		blob.insert(blob.end(), bytes, bytes + sizeof(T) * count);
+	}
+	// internal helper that views one cooked array in place, no copy is made
+	template<typename T>
+	static bool ViewSection(const char* blob, size_t blobSize, const COOKED_HEADER& header,
+		COOKED_SECTION_TYPE type, LEVEL_VIEW<T>& out) {
+		const COOKED_SECTION& section = header.sections[type];
+		if (static_cast<size_t>(section.offset) + sizeof(T) * section.count > blobSize)
+			return false;
+		out.data = reinterpret_cast<const T*>(blob + section.offset);
+		out.count = section.count;
+		return true;
+	}
+	// internal helper that copies one cooked array back out of the blob
+	template<typename T>
+	static bool UncookSection(const char* blob, size_t blobSize, const COOKED_HEADER& header,
+		COOKED_SECTION_TYPE type, std::vector<T>& out) {
+		LEVEL_VIEW<T> view;
+		if (ViewSection(blob, blobSize, header, type, view) == false)
+			return false;
+		out.assign(view.begin(), view.end());
+		return true;
+	}
+	// internal helper that points the geometry views at the owned vectors
+	void ViewOwnedGeometry() {
+		levelVertexView.data = levelVertices.data();
+		levelVertexView.count = levelVertices.size();
+		levelIndexView.data = levelIndices.data();
+		levelIndexView.count = levelIndices.size();
+		levelShortIndexView.data = levelShortIndices.data();
+		levelShortIndexView.count = levelShortIndices.size();
+		levelLongIndexView.data = levelLongIndices.data();
+		levelLongIndexView.count = levelLongIndices.size();
+		levelCompressedVertexView.data = levelCompressedVertices.data();
+		levelCompressedVertexView.count = levelCompressedVertices.size();
+	}
+	// internal helper that writes everything currently loaded to a cooked level
+	bool WriteCookedLevel(const char* cookedPath, const char* gameLevelPath, const char* h2bFolderPath,
+		GW::SYSTEM::GLog log) {
+		log.LogCategorized("MESSAGE", "Begin Writing Cooked Level.");
+		COOKED_HEADER header = {};
+		std::memcpy(header.magic, "LVLC", 4);
+		header.version = cookedVersion;
+		header.pointerSize = sizeof(void*);
+		// *NEW* everything the cooked data was derived from, so ReadCookedLevel can tell when it is stale
+		header.sourceHash = HashSourceFile(gameLevelPath, header.sourceSize);
+		header.options = GetCookedOptions();
+		std::vector<COOKED_MODEL_SOURCE> modelSources(levelModels.size(), COOKED_MODEL_SOURCE{});
+		for (size_t m = 0; m < levelModels.size(); ++m)
+			StampModelSource(std::string(h2bFolderPath) + "/" + levelModels[m].filename, modelSources[m]);
+		GW::SYSTEM::GFile file;
+		file.Create();
+		// swap every string pointer for an offset into one string table
+		std::string stringTable;
+		// *NEW* padding is written too, so copies holding padding are rebuilt member by member into zeroed
+		// memory and the same level always cooks to the same bytes (a value initialized element is not enough,
+		// it may be filled by copying a temporary whose padding was never stored)
+		std::vector<H2B::MATERIAL> materials = levelMaterials;
+		for (auto& material : materials) {
+			for (int k = 0; k < 10; ++k)
+				*((&material.name) + k) = CookString(*((&material.name) + k), stringTable);
+			material.padding[0] = material.padding[1] = nullptr;
+		}
+		std::vector<H2B::MESH> meshes(levelMeshes.size());
+		std::memset(meshes.data(), 0, sizeof(H2B::MESH) * meshes.size());
+		for (size_t j = 0; j < meshes.size(); ++j) {
+			meshes[j].name = CookString(levelMeshes[j].name, stringTable);
+			meshes[j].drawInfo = levelMeshes[j].drawInfo;
+			meshes[j].materialIndex = levelMeshes[j].materialIndex;
+		}
+		std::vector<LEVEL_MODEL> models = levelModels;
+		for (auto& model : models)
+			model.filename = CookString(model.filename, stringTable);
+		std::vector<BLENDER_OBJECT> objects(blenderObjects.size());
+		std::memset(objects.data(), 0, sizeof(BLENDER_OBJECT) * objects.size());
+		for (size_t j = 0; j < objects.size(); ++j) {
+			objects[j].blendername = CookString(blenderObjects[j].blendername, stringTable);
+			objects[j].modelIndex = blenderObjects[j].modelIndex;
+			objects[j].transformIndex = blenderObjects[j].transformIndex;
+			objects[j].parentTransformIndex = blenderObjects[j].parentTransformIndex;
+		}
+		// lay out the blob, header first
+		std::vector<char> blob(sizeof(COOKED_HEADER));
+		CookSection(blob, header, VERTICES, levelVertices.data(), levelVertices.size());
+		CookSection(blob, header, INDICES, levelIndices.data(), levelIndices.size());
+		CookSection(blob, header, MATERIALS, materials.data(), materials.size());
+		CookSection(blob, header, BATCHES, levelBatches.data(), levelBatches.size());
+		CookSection(blob, header, MESHES, meshes.data(), meshes.size());
+		CookSection(blob, header, MODELS, models.data(), models.size());
+		CookSection(blob, header, INSTANCES, levelInstances.data(), levelInstances.size());
+		CookSection(blob, header, TRANSFORMS, levelTransforms.data(), levelTransforms.size());
+		CookSection(blob, header, COLLIDERS, levelColliders.data(), levelColliders.size());
+		CookSection(blob, header, BLENDER_OBJECTS, objects.data(), objects.size());
+		CookSection(blob, header, STRINGS, stringTable.data(), stringTable.size());
+		CookSection(blob, header, MODEL_BOUNDS, levelModelBounds.data(), levelModelBounds.size());
+		CookSection(blob, header, MESH_BOUNDS, levelMeshBounds.data(), levelMeshBounds.size());
+		CookSection(blob, header, LODS, levelLods.data(), levelLods.size());
+		CookSection(blob, header, LOD_DRAWS, levelLodDraws.data(), levelLodDraws.size());
+		CookSection(blob, header, MESHLETS, levelMeshlets.data(), levelMeshlets.size());
+		CookSection(blob, header, MESHLET_RANGES, levelMeshletRanges.data(), levelMeshletRanges.size());
+		CookSection(blob, header, MODEL_SOURCES, modelSources.data(), modelSources.size());
+		CookSection(blob, header, SHORT_INDICES, levelShortIndices.data(), levelShortIndices.size());
+		CookSection(blob, header, LONG_INDICES, levelLongIndices.data(), levelLongIndices.size());
+		CookSection(blob, header, MODEL_INDEX_POOLS, levelModelIndices.data(), levelModelIndices.size());
+		CookSection(blob, header, PACKED_VERTICES, levelCompressedVertices.data(), levelCompressedVertices.size());
+		CookSection(blob, header, MODEL_QUANTIZATION, levelVertexQuantization.data(), levelVertexQuantization.size());
+		std::memcpy(blob.data(), &header, sizeof(COOKED_HEADER));
+		// one write for the whole level
+		if (-file.OpenBinaryWrite(cookedPath) ||
+			-file.Write(blob.data(), static_cast<unsigned>(blob.size()))) {
+			log.LogCategorized("WARNING", (std::string("Unable to write cooked level: ") + cookedPath).c_str());
+			return false;
+		}
+		file.CloseFile();
+		log.LogCategorized("MESSAGE", (std::string("Cooked Level Written: ") + cookedPath).c_str());
+		return true;
+	}
+	// internal helper that bulk loads a cooked level, fails if missing or out of date
+	// *NEW* with mapCookedGeometry the file is mapped and geometry is never copied
+	// *NEW* stale when GameLevel.txt's contents, any model's .h2b or the import settings differ from the cook
+	bool ReadCookedLevel(const char* cookedPath, const char* gameLevelPath, const char* h2bFolderPath,
+		GW::SYSTEM::GLog log) {
+		GW::SYSTEM::GFile file;
+		file.Create();
+		unsigned cookedSize = 0;
+		if (-file.GetFileSize(cookedPath, cookedSize) || cookedSize < sizeof(COOKED_HEADER))
+			return false; // nothing cooked yet, not an error
+		std::vector<char> blobCopy;
+		const char* blob = nullptr;
+		if (mapCookedGeometry && cookedMapping.Open(cookedPath) &&
+			cookedMapping.Size() >= sizeof(COOKED_HEADER)) {
+			blob = cookedMapping.Data();
+		}
+		else {
+			cookedMapping.Close();
+			if (-file.OpenBinaryRead(cookedPath))
+				return false;
+			// one read for the whole level
+			blobCopy.resize(cookedSize);
+			GW::GReturn readResult = file.Read(blobCopy.data(), cookedSize);
+			file.CloseFile();
+			if (G_FAIL(readResult))
+				return false;
+			blob = blobCopy.data();
+		}
+		const size_t blobSize = cookedMapping.IsOpen() ? cookedMapping.Size() : blobCopy.size();
+		COOKED_HEADER header;
+		std::memcpy(&header, blob, sizeof(COOKED_HEADER));
+		if (std::memcmp(header.magic, "LVLC", 4) != 0 ||
+			header.version != cookedVersion || header.pointerSize != sizeof(void*)) {
+			log.LogCategorized("WARNING", "Cooked level is invalid or from an older version, re-cooking.");
+			cookedMapping.Close();
+			return false;
+		}
+		unsigned sourceSize = 0;
+		const unsigned long long sourceHash = HashSourceFile(gameLevelPath, sourceSize);
+		if (header.sourceSize != sourceSize || header.sourceHash != sourceHash) {
+			log.LogCategorized("WARNING", "Cooked level is out of date with its GameLevel.txt, re-cooking.");
+			cookedMapping.Close();
+			return false;
+		}
+		const COOKED_OPTIONS options = GetCookedOptions();
+		if (std::memcmp(&header.options, &options, sizeof(COOKED_OPTIONS)) != 0) {
+			log.LogCategorized("WARNING", "Cooked level was built with other import settings, re-cooking.");
+			cookedMapping.Close();
+			return false;
+		}
+		log.LogCategorized("MESSAGE", (std::string("Begin Reading Cooked Level: ") + cookedPath).c_str());
+		// geometry is the bulk of the file, view it in place when mapped
+		bool valid = true;
+		if (cookedMapping.IsOpen()) {
+			valid = ViewSection(blob, blobSize, header, VERTICES, levelVertexView) &&
+				ViewSection(blob, blobSize, header, INDICES, levelIndexView) &&
+				ViewSection(blob, blobSize, header, SHORT_INDICES, levelShortIndexView) &&
+				ViewSection(blob, blobSize, header, LONG_INDICES, levelLongIndexView) &&
+				ViewSection(blob, blobSize, header, PACKED_VERTICES, levelCompressedVertexView);
+		}
+		else {
+			valid = UncookSection(blob, blobSize, header, VERTICES, levelVertices) &&
+				UncookSection(blob, blobSize, header, INDICES, levelIndices) &&
+				UncookSection(blob, blobSize, header, SHORT_INDICES, levelShortIndices) &&
+				UncookSection(blob, blobSize, header, LONG_INDICES, levelLongIndices) &&
+				UncookSection(blob, blobSize, header, PACKED_VERTICES, levelCompressedVertices);
+		}
+		std::vector<char> stringTable;
+		valid = valid &&
+			UncookSection(blob, blobSize, header, MATERIALS, levelMaterials) &&
+			UncookSection(blob, blobSize, header, BATCHES, levelBatches) &&
+			UncookSection(blob, blobSize, header, MESHES, levelMeshes) &&
+			UncookSection(blob, blobSize, header, MODELS, levelModels) &&
+			UncookSection(blob, blobSize, header, INSTANCES, levelInstances) &&
+			UncookSection(blob, blobSize, header, TRANSFORMS, levelTransforms) &&
+			UncookSection(blob, blobSize, header, COLLIDERS, levelColliders) &&
+			UncookSection(blob, blobSize, header, BLENDER_OBJECTS, blenderObjects) &&
+			UncookSection(blob, blobSize, header, STRINGS, stringTable) &&
+			UncookSection(blob, blobSize, header, MODEL_BOUNDS, levelModelBounds) &&
+			UncookSection(blob, blobSize, header, MESH_BOUNDS, levelMeshBounds) &&
+			UncookSection(blob, blobSize, header, LODS, levelLods) &&
+			UncookSection(blob, blobSize, header, LOD_DRAWS, levelLodDraws) &&
+			UncookSection(blob, blobSize, header, MESHLETS, levelMeshlets) &&
+			UncookSection(blob, blobSize, header, MESHLET_RANGES, levelMeshletRanges) &&
+			UncookSection(blob, blobSize, header, MODEL_INDEX_POOLS, levelModelIndices) &&
+			levelModelIndices.size() == levelModels.size() &&
+			UncookSection(blob, blobSize, header, MODEL_QUANTIZATION, levelVertexQuantization) &&
+			levelVertexQuantization.size() == levelModels.size();
+		std::vector<COOKED_MODEL_SOURCE> modelSources;
+		valid = valid && UncookSection(blob, blobSize, header, MODEL_SOURCES, modelSources) &&
+			modelSources.size() == levelModels.size();
+		if (valid == false) {
+			log.LogCategorized("WARNING", "Cooked level is truncated, re-cooking.");
+			UnloadLevel();
+			return false;
+		}
+		// swap string offsets back to pointers owned by this level
+		const unsigned stringTableSize = static_cast<unsigned>(stringTable.size());
+		for (auto& material : levelMaterials)
+			for (int k = 0; k < 10; ++k)
+				*((&material.name) + k) = UncookString(*((&material.name) + k), stringTable.data(), stringTableSize);
+		for (auto& mesh : levelMeshes)
+			mesh.name = UncookString(mesh.name, stringTable.data(), stringTableSize);
+		for (auto& model : levelModels)
+			model.filename = UncookString(model.filename, stringTable.data(), stringTableSize);
+		for (auto& object : blenderObjects)
+			object.blendername = UncookString(object.blendername, stringTable.data(), stringTableSize);
+		// *NEW* a re-exported .h2b makes the cook stale, a missing one is trusted so cooked levels can ship alone
+		for (size_t m = 0; m < levelModels.size(); ++m) {
+			COOKED_MODEL_SOURCE current;
+			if (levelModels[m].filename == nullptr ||
+				StampModelSource(std::string(h2bFolderPath) + "/" + levelModels[m].filename, current) == false)
+				continue;
+			if (current.size != modelSources[m].size || current.writeTime != modelSources[m].writeTime) {
+				log.LogCategorized("WARNING", (std::string("Cooked level is out of date with ") +
+					levelModels[m].filename + ", re-cooking.").c_str());
+				UnloadLevel();
+				return false;
+			}
+		}
+		log.LogCategorized("MESSAGE", cookedMapping.IsOpen() ?
+			"Cooked Level Reading Complete. [GEOMETRY MAPPED]" : "Cooked Level Reading Complete.");
+		return true;
+	}
+	// *NEW* post transform cache of one model before and after OptimizeModel
+	struct MESH_OPTIMIZATION
+	{
+		MESH_OPTIMIZER::CACHE_STATS before, after;
+		bool optimized;
+	};
+	// *NEW* internal helper that reorders a parsed model for the post transform cache and vertex fetch
+	// every mesh and material range is reordered on its own so the ranges stay valid
+	MESH_OPTIMIZATION OptimizeModel(H2B::Parser& p) const {
+		MESH_OPTIMIZATION out = {};
+		const unsigned indexCount = static_cast<unsigned>(p.indices.size());
+		const unsigned vertexCount = static_cast<unsigned>(p.vertices.size());
+		for (unsigned index : p.indices)
+			if (index >= vertexCount)
+				return out; // malformed, leave it as exported
+		// cut wherever a mesh or material range starts or ends
+		std::vector<unsigned> cuts = { 0, indexCount };
+		for (const H2B::MESH& mesh : p.meshes) {
+			cuts.push_back(mesh.drawInfo.indexOffset);
+			cuts.push_back(mesh.drawInfo.indexOffset + mesh.drawInfo.indexCount);
+		}
+		for (const H2B::BATCH& batch : p.batches) {
+			cuts.push_back(batch.indexOffset);
+			cuts.push_back(batch.indexOffset + batch.indexCount);
+		}
+		std::sort(cuts.begin(), cuts.end());
+		cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+		out.before = MESH_OPTIMIZER::AnalyzeVertexCache(p.indices.data(), indexCount, vertexCount);
+		std::vector<size_t> clusters;
+		for (size_t c = 0; c + 1 < cuts.size() && cuts[c + 1] <= indexCount; ++c) {
+			unsigned* range = p.indices.data() + cuts[c];
+			const size_t rangeCount = (cuts[c + 1] - cuts[c]) / 3 * 3;
+			MESH_OPTIMIZER::OptimizeVertexCache(range, rangeCount, vertexCount, 16,
+				optimizeOverdraw ? &clusters : nullptr);
+			if (optimizeOverdraw)
+				MESH_OPTIMIZER::OptimizeOverdraw(range, rangeCount, p.vertices.data(), clusters);
+		}
+		MESH_OPTIMIZER::OptimizeVertexFetch(p.vertices, p.indices.data(), indexCount);
+		out.after = MESH_OPTIMIZER::AnalyzeVertexCache(p.indices.data(), indexCount, vertexCount);
+		out.optimized = true;
+		return out;
+	}
+	// *NEW* levels of detail of one parsed model before they are added to the level
+	struct MODEL_LODS
+	{
+		std::vector<LEVEL_LOD> lods; // drawStart is relative to draws
+		std::vector<H2B::BATCH> draws;
+	};
+	// *NEW* internal helper that simplifies every mesh of a parsed model into LODs of roughly half the
+	// triangles of the one before, the new indices are appended to p.indices after the model's own
+	MODEL_LODS BuildModelLods(H2B::Parser& p, float radius, unsigned lodCount) const {
+		MODEL_LODS out;
+		out.lods.push_back({ 0, 0 });
+		for (const H2B::MESH& mesh : p.meshes)
+			out.draws.push_back(mesh.drawInfo);
+		if (lodCount < 2)
+			return out;
+		// every mesh is simplified once, stopping at each LOD's target on the way down
+		const unsigned levelCount = lodCount - 1;
+		const unsigned vertexCount = static_cast<unsigned>(p.vertices.size());
+		std::vector<std::vector<unsigned>> simplified(p.meshes.size() * levelCount);
+		std::vector<float> errors(p.meshes.size() * levelCount, 0);
+		std::vector<size_t> targets(levelCount);
+		std::vector<char> malformed(p.meshes.size(), 0); // drawn as they are at every LOD
+		for (size_t j = 0; j < p.meshes.size(); ++j) {
+			const H2B::BATCH& draw = p.meshes[j].drawInfo;
+			malformed[j] = static_cast<size_t>(draw.indexOffset) + draw.indexCount > p.indices.size();
+			if (malformed[j])
+				continue;
+			for (unsigned level = 0; level < levelCount; ++level)
+				targets[level] = (draw.indexCount / 3 >> (level + 1)) * 3;
+			MESH_OPTIMIZER::SimplifyMesh(p.indices.data() + draw.indexOffset, draw.indexCount, p.vertices.data(), vertexCount,
+				targets.data(), levelCount, lodMaxError * radius, &simplified[j * levelCount], &errors[j * levelCount]);
+		}
+		size_t previousTriangles = 0;
+		for (const H2B::MESH& mesh : p.meshes)
+			previousTriangles += mesh.drawInfo.indexCount / 3;
+		for (unsigned level = 0; level < levelCount; ++level) {
+			size_t triangles = 0;
+			for (size_t j = 0; j < p.meshes.size(); ++j)
+				triangles += (malformed[j] ? p.meshes[j].drawInfo.indexCount : simplified[j * levelCount + level].size()) / 3;
+			// a LOD that saves under a quarter of the triangles is not worth its memory, the chain ends there
+			if (triangles * 4 > previousTriangles * 3)
+				break;
+			// the quadrics only estimate the error, what gets selected on is the distance actually measured
+			float error = 0;
+			for (size_t j = 0; j < p.meshes.size(); ++j) {
+				if (malformed[j])
+					continue;
+				const H2B::BATCH& draw = p.meshes[j].drawInfo;
+				const std::vector<unsigned>& indices = simplified[j * levelCount + level];
+				error = std::max(error, std::max(errors[j * levelCount + level], MESH_OPTIMIZER::MeasureDeviation(
+					p.indices.data() + draw.indexOffset, draw.indexCount, indices.data(), indices.size(), p.vertices.data())));
+			}
+			// coarser levels continue from this one, so a LOD past the error budget ends the chain too
+			if (error > lodMaxError * radius)
+				break;
+			previousTriangles = triangles;
+			LEVEL_LOD lod = { error, static_cast<unsigned>(out.draws.size()) };
+			for (size_t j = 0; j < p.meshes.size(); ++j) {
+				std::vector<unsigned>& indices = simplified[j * levelCount + level];
+				if (malformed[j]) {
+					out.draws.push_back(p.meshes[j].drawInfo);
+					continue;
+				}
+				MESH_OPTIMIZER::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+				out.draws.push_back({ static_cast<unsigned>(indices.size()), static_cast<unsigned>(p.indices.size()) });
+				p.indices.insert(p.indices.end(), indices.begin(), indices.end());
+			}
+			out.lods.push_back(lod);
+		}
+		p.indexCount = static_cast<unsigned>(p.indices.size());
+		return out;
+	}
+	// *NEW* meshlets of one parsed model before they are added to the level
+	struct MODEL_MESHLETS
+	{
+		std::vector<LEVEL_MESHLET> meshlets;
+		std::vector<LEVEL_MESHLET_RANGE> ranges; // one per mesh, meshletStart is relative to meshlets
+	};
+	// *NEW* internal helper that splits every mesh of a parsed model into meshlets, each mesh's triangles are
+	// rewritten meshlet by meshlet without crossing a material batch so every draw range still holds
+	// with optimizeMeshes the triangles of each meshlet are put back in vertex cache order afterwards
+	MODEL_MESHLETS BuildModelMeshlets(H2B::Parser& p) const {
+		MODEL_MESHLETS out;
+		out.ranges.assign(p.meshes.size(), LEVEL_MESHLET_RANGE{ 0, 0 });
+		std::vector<MESH_OPTIMIZER::MESHLET> built;
+		for (size_t j = 0; j < p.meshes.size(); ++j) {
+			const H2B::BATCH& draw = p.meshes[j].drawInfo;
+			out.ranges[j].meshletStart = static_cast<unsigned>(out.meshlets.size());
+			if (static_cast<size_t>(draw.indexOffset) + draw.indexCount > p.indices.size())
+				continue; // malformed, drawn whole
+			std::vector<unsigned> cuts = { draw.indexOffset, draw.indexOffset + draw.indexCount };
+			for (const H2B::BATCH& batch : p.batches)
+				for (unsigned cut : { batch.indexOffset, batch.indexOffset + batch.indexCount })
+					if (cut > draw.indexOffset && cut < draw.indexOffset + draw.indexCount)
+						cuts.push_back(cut);
+			std::sort(cuts.begin(), cuts.end());
+			cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+			for (size_t c = 0; c + 1 < cuts.size(); ++c) {
+				MESH_OPTIMIZER::BuildMeshlets(p.indices.data() + cuts[c], (cuts[c + 1] - cuts[c]) / 3 * 3, p.vertices.data(),
+					static_cast<unsigned>(p.vertices.size()), meshletMaxVertices, meshletMaxTriangles, built);
+				if (optimizeMeshes)
+					MESH_OPTIMIZER::OptimizeMeshletVertexCache(p.indices.data() + cuts[c], built,
+						static_cast<unsigned>(p.vertices.size()));
+				for (const MESH_OPTIMIZER::MESHLET& meshlet : built)
+					out.meshlets.push_back({
+						{ meshlet.center[0], meshlet.center[1], meshlet.center[2], meshlet.radius },
+						{ meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2], meshlet.coneCutoff },
+						cuts[c] + meshlet.indexOffset, meshlet.indexCount });
+			}
+			out.ranges[j].meshletCount = static_cast<unsigned>(out.meshlets.size()) - out.ranges[j].meshletStart;
+		}
+		return out;
+	}
 	// internal defintion for reading the GameLevel layout 
 	struct MODEL_ENTRY
 	{
 		std::string modelFile; // path to .h2b file
-		// *NEW* object aligned bounding box data: // LBN, LTN, LTF, LBF, RBN, RTN, RTF, RBF
-		GW::MATH2D::GVECTOR3F boundry[8];
 		mutable std::vector<std::string> blenderNames; // *NEW* names from blender
 		mutable std::vector<GW::MATH::GMATRIXF> instances; // where to draw
-		mutable std::vector<GW::MATH::GMATRIXF> parents; // the transform index of the blender objects parent, set to -1 if no parent
+		mutable std::vector<unsigned> objects; // *NEW* order each instance appeared in the GameLevel
+		mutable std::vector<int> parentObjects; // *NEW* order of each instance's parent, set to -1 if no parent
 		bool operator<(const MODEL_ENTRY& cmp) const {
 			return modelFile < cmp.modelFile; // you need this for std::set to work
 		}
-		// *NEW* converts the vec3 boundries to an OBB
-		GW::MATH::GOBBF ComputeOBB() const {
-			GW::MATH::GOBBF out = {
-				GW::MATH::GIdentityVectorF,
-				GW::MATH::GIdentityVectorF,
-				GW::MATH::GIdentityQuaternionF // initally unrotated (local space)
-			};
-			out.center.x = (boundry[0].x + boundry[4].x) * 0.5f;
-			out.center.y = (boundry[0].y + boundry[1].y) * 0.5f;
-			out.center.z = (boundry[0].z + boundry[2].z) * 0.5f;
-			out.extent.x = std::fabsf(boundry[0].x - boundry[4].x) * 0.5f;
-			out.extent.y = std::fabsf(boundry[0].y - boundry[1].y) * 0.5f;
-			out.extent.z = std::fabsf(boundry[0].z - boundry[2].z) * 0.5f;
-			return out;
-		}
 	};
+	// *NEW* internal helper that bounds the vertices an index list uses (every vertex when indices is null)
+	static LEVEL_BOUNDS ComputeBounds(const H2B::VERTEX* vertices, unsigned vertexCount,
+		const unsigned* indices, unsigned indexCount) {
+		LEVEL_BOUNDS out = {};
+		const size_t count = indices != nullptr ? indexCount : vertexCount;
+		if (vertices == nullptr || count == 0)
+			return out;
+		const float* positions = &vertices->pos.x;
+		float low[3], high[3];
+		SIMD_MATH::PointBounds(positions, sizeof(H2B::VERTEX), indices, count, low, high);
+		out.box.min = { low[0], low[1], low[2], 1 };
+		out.box.max = { high[0], high[1], high[2], 1 };
+		const float center[3] = {
+			(low[0] + high[0]) * 0.5f, (low[1] + high[1]) * 0.5f, (low[2] + high[2]) * 0.5f };
+		out.sphere.x = center[0];
+		out.sphere.y = center[1];
+		out.sphere.z = center[2];
+		out.sphere.radius = std::sqrt(SIMD_MATH::MaxDistanceSquared(
+			positions, sizeof(H2B::VERTEX), indices, count, center));
+		return out;
+	}
+	// *NEW* internal helper that turns model bounds into the (unrotated) collider of that model
+	static GW::MATH::GOBBF ComputeOBB(const LEVEL_BOUNDS& bounds) {
+		GW::MATH::GOBBF out = {
+			GW::MATH::GIdentityVectorF,
+			GW::MATH::GIdentityVectorF,
+			GW::MATH::GIdentityQuaternionF // initally unrotated (local space)
+		};
+		out.center.x = (bounds.box.min.x + bounds.box.max.x) * 0.5f;
+		out.center.y = (bounds.box.min.y + bounds.box.max.y) * 0.5f;
+		out.center.z = (bounds.box.min.z + bounds.box.max.z) * 0.5f;
+		out.extent.x = (bounds.box.max.x - bounds.box.min.x) * 0.5f;
+		out.extent.y = (bounds.box.max.y - bounds.box.min.y) * 0.5f;
+		out.extent.z = (bounds.box.max.z - bounds.box.min.z) * 0.5f;
+		return out;
+	}
 	// internal helper for reading the game level
+	// *NEW* the whole file is read once and scanned in place, MESH entries may be nested to any depth
 	bool ReadGameLevel(const char* gameLevelPath,
 		std::set<MODEL_ENTRY>& outModels,
 		GW::SYSTEM::GLog log) {
 		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
+		std::vector<char> levelText;
+		if (ReadWholeFile(gameLevelPath, levelText) == false) {
 			log.LogCategorized(
 				"ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
 			return false;
 		}
-		char linebuffer[1024];
-		GW::MATH::GMATRIXF* lastParentTransformPtr = nullptr;
-		while (+file.ReadLine(linebuffer, 1024, '\n'))
+		// world transforms of the MESH entries enclosing the current one
+		struct LEVEL_PARENT
 		{
-			// having to have this is a bug, need to have Read/ReadLine return failure at EOF
-			if (linebuffer[0] == '\0')
+			unsigned indent;
+			unsigned object; // order it appeared in the file
+			GW::MATH::GMATRIXF world;
+		};
+		unsigned objectCount = 0;
+		std::vector<LEVEL_PARENT> parentStack;
+		const char* cursor = levelText.data();
+		const char* end = cursor + levelText.size();
+		LEVEL_LINE line;
+		while (NextLevelLine(cursor, end, line))
+		{
+			if (line.Equals("MESH") == false)
+				continue; // comments & anything we don't understand
+			const unsigned indent = line.indent;
+			if (NextLevelLine(cursor, end, line) == false)
 				break;
-			if (std::strcmp(linebuffer, "MESH") == 0)
-			{
-				file.ReadLine(linebuffer, 1024, '\n');
-				std::string blenderName = linebuffer;
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + blenderName).c_str());
-				// create the model file name from this (strip the .001)
-				MODEL_ENTRY add = { linebuffer };
-				add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
-				add.modelFile += ".h2b";
-
-				// now read the transform data as we will need that regardless
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					// read floats
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				//// *NEW* finally read in the boundry data for this model
-				//for (int i = 0; i < 8; ++i) {
-				//	file.ReadLine(linebuffer, 1024, '\n');
-				//	// read floats
-				//	std::sscanf(linebuffer + 9, "%f, %f, %f",
-				//		&add.boundry[i].x, &add.boundry[i].y, &add.boundry[i].z);
-				//}
-				//std::string bounds = "Boundry: Left ";
-				//bounds += std::to_string(add.boundry[0].x) +
-				//" Right " +	std::to_string(add.boundry[4].x) +
-				//" Bottom " + std::to_string(add.boundry[0].y) +
-				//" Top " + std::to_string(add.boundry[1].y) +
-				//" Near " + std::to_string(add.boundry[0].z) +
-				//" Far " + std::to_string(add.boundry[2].z);
-				//log.LogCategorized("INFO", bounds.c_str());
+			std::string blenderName(line.start, line.end);
+			log.LogCategorized("INFO", (std::string("Model Detected: ") + blenderName).c_str());
+			// create the model file name from this (strip the .001)
+			MODEL_ENTRY add = { blenderName, {}, {}, {}, {} };
+			add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
+			add.modelFile += ".h2b";
 
-				// does this model already exist?
-				auto found = outModels.find(add);
-				if (found == outModels.end()) // no
-				{
-					add.blenderNames.push_back(blenderName); // *NEW*
-					add.instances.push_back(transform);
-					add.parents.push_back(GW::MATH::GIdentityMatrixF);
-					outModels.insert(add);
-					lastParentTransformPtr = &transform;
-				}
-				else // yes
-				{
-					found->blenderNames.push_back(blenderName); // *NEW*
-					found->instances.push_back(transform);
-					found->parents.push_back(GW::MATH::GIdentityMatrixF);
-					lastParentTransformPtr = &transform;
-				}
+			// now read the transform data as we will need that regardless
+			GW::MATH::GMATRIXF transform;
+			if (ParseLevelMatrix(cursor, end, transform) == false) {
+				log.LogCategorized("ERROR", (std::string("Malformed transform for: ") + blenderName).c_str());
+				return false;
 			}
-			else if (std::strcmp(linebuffer, "  MESH") == 0)
-			{
-				file.ReadLine(linebuffer, 1024, '\n');
-				std::string blenderName = std::string(linebuffer).substr(2);
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + blenderName).c_str());
-				// create the model file name from this (strip the .001)
-				MODEL_ENTRY add = { std::string(linebuffer).substr(2).c_str() };
-				add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
-				add.modelFile += ".h2b";
+			std::string loc = "Location: X ";
+			loc += std::to_string(transform.row4.x) + " Y " +
+				std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
+			log.LogCategorized("INFO", loc.c_str());
 
-				// now read the transform data as we will need that regardless
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					// read floats
-					if (i == 0)
-					{
-						std::sscanf(linebuffer + 15, "%f, %f, %f, %f",
-							&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-							&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-					}
-					else if (i >= 1)
-					{
-						std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-							&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-							&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-					}
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				//Does this model already exist?
-				auto found = outModels.find(add);
-				if (found == outModels.end()) // no
-				{
-					GW::MATH::GMatrix::MakeRelativeF(transform, *lastParentTransformPtr, transform);
-					add.blenderNames.push_back(blenderName); // *NEW*
-					add.instances.push_back(transform);
-					add.parents.push_back(*lastParentTransformPtr);
-					outModels.insert(add);
-				}
-				else // yes
-				{
-					GW::MATH::GMatrix::MakeRelativeF(transform, *lastParentTransformPtr, transform);
-					found->blenderNames.push_back(blenderName); // *NEW*
-					found->instances.push_back(transform);
-					found->parents.push_back(*lastParentTransformPtr);
-				}
+			// the closest less indented MESH above this one is its parent
+			while (parentStack.empty() == false && parentStack.back().indent >= indent)
+				parentStack.pop_back();
+			int parentObject = -1;
+			if (parentStack.empty() == false) {
+				parentObject = static_cast<int>(parentStack.back().object);
+				// children are stored relative to their parent
+				GW::MATH::GMATRIXF parent = parentStack.back().world;
+				parentStack.push_back({ indent, objectCount, transform });
+				GW::MATH::GMatrix::MakeRelativeF(transform, parent, transform);
 			}
+			else
+				parentStack.push_back({ indent, objectCount, transform });
+
+			// add to the existing model entry or create a new one
+			auto entry = outModels.insert(add).first;
+			entry->blenderNames.push_back(blenderName); // *NEW*
+			entry->instances.push_back(transform);
+			entry->objects.push_back(objectCount++);
+			entry->parentObjects.push_back(parentObject);
 		}
 		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
 		return true;
@@ -260,14 +951,97 @@ private:
 		const std::set<MODEL_ENTRY>& modelSet,
 		GW::SYSTEM::GLog log) {
 		log.LogCategorized("MESSAGE", "Begin Importing .H2B File Data.");
-		// parse each model adding to overall arrays
-		H2B::Parser p; // reads the .h2b format
 		const std::string modelPath = h2bFolderPath;
+		// *NEW* parse every .h2b in parallel, one parser per model
+		std::vector<const MODEL_ENTRY*> entries;
 		for (auto i = modelSet.begin(); i != modelSet.end(); ++i)
+			entries.push_back(&(*i));
+		std::vector<H2B::Parser> parsers(entries.size()); // reads the .h2b format
+		std::vector<char> parsed(entries.size(), 0);
+		// *NEW* bounds are computed by the same workers while each model is still hot in cache
+		std::vector<LEVEL_BOUNDS> modelBounds(entries.size());
+		std::vector<std::vector<LEVEL_BOUNDS>> meshBounds(entries.size());
+		std::vector<MESH_OPTIMIZATION> meshOptimization(entries.size(), MESH_OPTIMIZATION{});
+		std::vector<MODEL_LODS> modelLods(entries.size());
+		std::vector<MODEL_MESHLETS> modelMeshlets(entries.size());
+		std::vector<float> meshletMilliseconds(entries.size(), 0);
+		// Gateware's shared thread pool also runs GLog/GController for the lifetime of the app
+		// so the import uses its own short lived workers that pull the next model to parse.
+		std::atomic_uint nextModel(0);
+		auto importJob = [&]() {
+			for (unsigned m = nextModel++; m < entries.size(); m = nextModel++) {
+				H2B::Parser& p = parsers[m];
+				parsed[m] = p.Parse((modelPath + "/" + entries[m]->modelFile).c_str()) ? 1 : 0;
+				if (parsed[m] == 0)
+					continue;
+				if (optimizeMeshes)
+					meshOptimization[m] = OptimizeModel(p);
+				modelBounds[m] = ComputeBounds(p.vertices.data(), p.vertexCount, nullptr, 0);
+				meshBounds[m].resize(p.meshCount);
+				for (unsigned j = 0; j < p.meshCount; ++j) {
+					const H2B::BATCH& draw = p.meshes[j].drawInfo;
+					if (static_cast<size_t>(draw.indexOffset) + draw.indexCount <= p.indices.size())
+						meshBounds[m][j] = ComputeBounds(p.vertices.data(), p.vertexCount,
+							p.indices.data() + draw.indexOffset, draw.indexCount);
+				}
+				// *NEW* meshlets only reorder triangles inside each mesh so the bounds above still hold
+				if (buildMeshlets) {
+					auto meshletStart = std::chrono::steady_clock::now();
+					modelMeshlets[m] = BuildModelMeshlets(p);
+					meshletMilliseconds[m] = std::chrono::duration_cast<std::chrono::microseconds>(
+						std::chrono::steady_clock::now() - meshletStart).count() / 1000.0f;
+					// *NEW* report the cache behaviour of the indices that actually ship
+					if (meshOptimization[m].optimized)
+						meshOptimization[m].after = MESH_OPTIMIZER::AnalyzeVertexCache(p.indices.data(),
+							p.indices.size(), static_cast<unsigned>(p.vertices.size()));
+				}
+				else
+					modelMeshlets[m].ranges.assign(p.meshes.size(), LEVEL_MESHLET_RANGE{ 0, 0 });
+				// *NEW* LODs go last, their indices are appended after the ranges bounded above
+				modelLods[m] = BuildModelLods(p, modelBounds[m].sphere.radius, generateLods ? maxLodCount : 1);
+			}
+		};
+		unsigned workerCount = importWorkers > 0 ? importWorkers : std::thread::hardware_concurrency();
+		if (workerCount > entries.size())
+			workerCount = static_cast<unsigned>(entries.size());
+		std::vector<std::thread> workers;
+		for (unsigned w = 1; w < workerCount; ++w)
+			workers.emplace_back(importJob);
+		importJob(); // this thread helps too
+		for (auto& worker : workers)
+			worker.join();
+		// *NEW* transform index of every object in GameLevel order, used to resolve parents
+		size_t objectCount = 0;
+		for (auto i = modelSet.begin(); i != modelSet.end(); ++i)
+			objectCount += i->objects.size();
+		std::vector<int> objectTransforms(objectCount, -1);
+		std::vector<int> objectParents; // per blender object, resolved once everything is placed
+		// combine in set order so every offset matches a serial import
+		unsigned modelNum = 0;
+		for (auto i = modelSet.begin(); i != modelSet.end(); ++i, ++modelNum)
 		{
-			if (p.Parse((modelPath + "/" + i->modelFile).c_str()))
+			H2B::Parser& p = parsers[modelNum];
+			if (parsed[modelNum])
 			{
 				log.LogCategorized("INFO", (std::string("H2B Imported: ") + i->modelFile).c_str());
+				if (meshOptimization[modelNum].optimized) {
+					const MESH_OPTIMIZATION& stats = meshOptimization[modelNum];
+					log.LogCategorized("INFO", (std::string("Mesh Optimized: ") + i->modelFile +
+						" ACMR " + std::to_string(stats.before.acmr) + " -> " + std::to_string(stats.after.acmr) +
+						", ATVR " + std::to_string(stats.before.atvr) + " -> " + std::to_string(stats.after.atvr)).c_str());
+				}
+				if (modelLods[modelNum].lods.size() > 1) {
+					const MODEL_LODS& lods = modelLods[modelNum];
+					std::string chain;
+					for (const LEVEL_LOD& lod : lods.lods) {
+						unsigned triangles = 0;
+						for (unsigned j = 0; j < p.meshCount; ++j)
+							triangles += lods.draws[lod.drawStart + j].indexCount / 3;
+						chain += (chain.empty() ? "" : " -> ") + std::to_string(triangles);
+					}
+					log.LogCategorized("INFO", (std::string("LODs Built: ") + i->modelFile + " triangles " + chain +
+						", error " + std::to_string(lods.lods.back().error)).c_str());
+				}
 				// transfer all string data
 				for (int j = 0; j < p.materialCount; ++j) {
 					for (int k = 0; k < 10; ++k) {
@@ -300,9 +1074,33 @@ private:
 				levelMaterials.insert(levelMaterials.end(), p.materials.begin(), p.materials.end());
 				levelBatches.insert(levelBatches.end(), p.batches.begin(), p.batches.end());
 				levelMeshes.insert(levelMeshes.end(), p.meshes.begin(), p.meshes.end());
+				// *NEW* the same indices packed for the GPU, LOD indices included
+				levelModelIndices.push_back(Index_Pool_Builder::AddModel(p.indices.data(), p.indexCount,
+					levelShortIndices, levelLongIndices));
+				// *NEW* and the compressed vertex stream
+				levelVertexQuantization.push_back(Vertex_Compressor::AddModel(p.vertices.data(), p.vertexCount,
+					levelCompressedVertices));
 				// *NEW* add overall collision volume(OBB) for this model and it's submeshes 
+				levelModelBounds.push_back(modelBounds[modelNum]);
+				levelMeshBounds.insert(levelMeshBounds.end(), meshBounds[modelNum].begin(), meshBounds[modelNum].end());
 				model.colliderIndex = levelColliders.size();
-				levelColliders.push_back(i->ComputeOBB());
+				levelColliders.push_back(ComputeOBB(modelBounds[modelNum]));
+				// *NEW* levels of detail, their draws move to the end of levelLodDraws
+				const MODEL_LODS& lods = modelLods[modelNum];
+				model.lodStart = levelLods.size();
+				model.lodCount = lods.lods.size();
+				for (LEVEL_LOD lod : lods.lods) {
+					lod.drawStart += levelLodDraws.size();
+					levelLods.push_back(lod);
+				}
+				levelLodDraws.insert(levelLodDraws.end(), lods.draws.begin(), lods.draws.end());
+				// *NEW* meshlets move to the end of levelMeshlets
+				const MODEL_MESHLETS& meshlets = modelMeshlets[modelNum];
+				for (LEVEL_MESHLET_RANGE range : meshlets.ranges) {
+					range.meshletStart += levelMeshlets.size();
+					levelMeshletRanges.push_back(range);
+				}
+				levelMeshlets.insert(levelMeshlets.end(), meshlets.meshlets.begin(), meshlets.meshlets.end());
 				// add level model
 				levelModels.push_back(model);
 				// add level model instances
@@ -316,15 +1114,17 @@ private:
 				levelInstances.push_back(instances);
 				
 				// *NEW* Add an entry for each unique blender object
-				int offset = 0;
 				for (int j = 0; j < i->blenderNames.size(); j++)
 				{										
 					BLENDER_OBJECT obj{
 						level_strings.insert(i->blenderNames[j]).first->c_str(),
-						instances.modelIndex, instances.transformStart + offset++
+						instances.modelIndex, instances.transformStart + j, -1
 					};
 					blenderObjects.push_back(obj);
+					objectTransforms[i->objects[j]] = static_cast<int>(obj.transformIndex);
+					objectParents.push_back(i->parentObjects[j]);
 				}
+				p = H2B::Parser(); // release this model's parse memory early
 			}
 			else {
 				// notify user that a model file is missing but continue loading
@@ -333,23 +1133,18 @@ private:
 				log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
 			}
 		}
-		int counter = 0;
-		for (auto i = modelSet.begin(); i != modelSet.end(); ++i)
+		// *NEW* parents recorded while reading the level become transform indices (-1 if missing)
+		for (size_t j = 0; j < blenderObjects.size(); j++)
 		{
-			for (int j = 0; j < i->blenderNames.size(); j++)
-			{
-				blenderObjects[counter].parentTransformIndex = -1;
-				for (int t = 0; t < levelTransforms.size(); t++)
-				{
-					if (i->parents[j].row4.data[0] == levelTransforms[t].row4.data[0] &&
-						i->parents[j].row4.data[1] == levelTransforms[t].row4.data[1] &&
-						i->parents[j].row4.data[2] == levelTransforms[t].row4.data[2]) {
-						blenderObjects[counter].parentTransformIndex = t;
-						break;
-					}
-				}
-				counter++;
-			}
+			if (objectParents[j] != -1)
+				blenderObjects[j].parentTransformIndex = objectTransforms[objectParents[j]];
+		}
+		if (buildMeshlets) {
+			float milliseconds = 0;
+			for (float time : meshletMilliseconds)
+				milliseconds += time;
+			log.LogCategorized("INFO", ("Meshlets Built: " + std::to_string(levelMeshlets.size()) + " for " +
+				std::to_string(levelMeshes.size()) + " meshes in " + std::to_string(milliseconds) + " ms of import time").c_str());
 		}
 		log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
 		return true;
@@ -1,6 +1,11 @@
 // Simple basecode showing how to create a window and attatch a d3d12surface
 #define GATEWARE_ENABLE_CORE // All libraries need this
 #define GATEWARE_ENABLE_SYSTEM // Graphics libs require system level libraries
+// the windowed renderer needs Windows & D3D12, the headless target builds everywhere without them
+#if defined(_WIN32) && !defined(LEVEL_RENDERER_HEADLESS)
+#define LEVEL_RENDERER_D3D12
+#endif
+#if defined(LEVEL_RENDERER_D3D12)
 #define GATEWARE_ENABLE_GRAPHICS // Enables all Graphics Libraries
 // Ignore some GRAPHICS libraries we aren't going to use
 #define GATEWARE_DISABLE_GDIRECTX11SURFACE // we have another template for this
@@ -8,27 +13,205 @@
 #define GATEWARE_DISABLE_GVULKANSURFACE // we have another template for this
 #define GATEWARE_DISABLE_GRASTERSURFACE // we have another template for this
 
-#define GATEWARE_ENABLE_MATH
-
 #define GATEWARE_ENABLE_INPUT
 
 #define GATEWARE_ENABLE_AUDIO
+#endif
+
+#define GATEWARE_ENABLE_MATH
 // With what we want & what we don't defined we can include the API
 #include "../gateware-main/Gateware.h"
 
 
 #include "FileIntoString.h" 
 #include "lvlData.h"
+#include "simdMath.h"
+#include "sceneHierarchy.h"
+#include "levelBVH.h"
+#include "frustumCulling.h"
+#include "occlusionCulling.h"
+#include "lodSelection.h"
+#include "renderDevice.h"
+#include "uploadRing.h"
+#include "uploadBatcher.h"
+#include "recordingDevice.h"
+#include "vertexCompression.h"
+#include "drawPackets.h"
+#include "clusterCulling.h"
+#include "instanceRecords.h"
+#include "indirectArgs.h"
+#include "transformUploads.h"
+#include "frameRenderer.h"
+#if defined(LEVEL_RENDERER_D3D12)
 #include "CameraMovement.h"
+#include "pipelineCache.h"
+#include "d3d12Device.h"
 #include "renderer.h"
+#endif
 // open some namespaces to compact the code a bit
 using namespace GW;
 using namespace CORE;
 using namespace SYSTEM;
+#if defined(LEVEL_RENDERER_D3D12)
 using namespace GRAPHICS;
+#endif
 // lets pop a window and use D3D12 to clear to a jade colored screen
-int main()
+int main(int argc, char* argv[])
 {
+	// offline cook step: Level_Renderer_D3D12 -cook ../Level1
+	if (argc == 3 && std::strcmp(argv[1], "-cook") == 0)
+	{
+		GLog log;
+		log.Create("CookOutput.txt");
+		log.EnableConsoleLogging(true);
+		Level_Data cookLevel;
+		std::string levelFolder = argv[2];
+		bool cooked = cookLevel.CookLevel((levelFolder + "/GameLevel.txt").c_str(),
+			(levelFolder + "/Models").c_str(), log);
+		return cooked ? 0 : 1;
+	}
+	// vertex compression report: Level_Renderer_D3D12 -compress ../Level1
+	if (argc == 3 && std::strcmp(argv[1], "-compress") == 0)
+	{
+		GLog log;
+		log.Create("CompressOutput.txt");
+		log.EnableConsoleLogging(true);
+		Level_Data compressLevel;
+		std::string levelFolder = argv[2];
+		if (compressLevel.LoadLevel((levelFolder + "/GameLevel.txt").c_str(),
+			(levelFolder + "/Models").c_str(), log) == false)
+			return 1;
+		for (size_t m = 0; m < compressLevel.levelModels.size(); m++)
+		{
+			const Level_Data::LEVEL_MODEL& model = compressLevel.levelModels[m];
+			Vertex_Compressor::MODEL_VERTEX_ERROR error = Vertex_Compressor::MeasureModelError(
+				&compressLevel.levelVertexView[model.vertexStart], &compressLevel.levelCompressedVertexView[model.vertexStart],
+				model.vertexCount, compressLevel.levelVertexQuantization[m]);
+			log.Log((std::string(model.filename) + ": " + std::to_string(model.vertexCount) + " vertices, position error " +
+				std::to_string(error.maxPositionError) + " (" + std::to_string(error.relativePositionError * 100) +
+				"% of bounds), normal error " + std::to_string(error.maxNormalDegrees) + " degrees, uv error " +
+				std::to_string(error.maxUVError)).c_str());
+		}
+		size_t vertexCount = compressLevel.levelVertexView.size();
+		log.Log((std::to_string(vertexCount) + " vertices, " + std::to_string(sizeof(H2B::VERTEX) * vertexCount) + " bytes as H2B::VERTEX, " +
+			std::to_string(sizeof(COMPRESSED_VERTEX) * vertexCount) + " bytes compressed").c_str());
+		return 0;
+	}
+	// meshlet report: Level_Renderer_D3D12 -meshlets ../Level1
+	if (argc == 3 && std::strcmp(argv[1], "-meshlets") == 0)
+	{
+		GLog log;
+		log.Create("MeshletOutput.txt");
+		log.EnableConsoleLogging(true);
+		Level_Data meshletLevel;
+		std::string levelFolder = argv[2];
+		if (meshletLevel.LoadLevel((levelFolder + "/GameLevel.txt").c_str(),
+			(levelFolder + "/Models").c_str(), log) == false)
+			return 1;
+		// rebuild from a copy of every mesh's indices, a cooked level only carries the result
+		std::vector<unsigned> indices;
+		std::vector<MESH_OPTIMIZER::MESHLET> meshlets;
+		size_t meshletCount = 0, triangleCount = 0, coneCount = 0;
+		float buildTime = 0;
+		for (const Level_Data::LEVEL_MODEL& model : meshletLevel.levelModels)
+			for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+			{
+				const H2B::BATCH& draw = meshletLevel.levelMeshes[mesh].drawInfo;
+				const unsigned* first = meshletLevel.levelIndexView.data + model.indexStart + draw.indexOffset;
+				indices.assign(first, first + draw.indexCount);
+				auto buildStart = std::chrono::steady_clock::now();
+				MESH_OPTIMIZER::BuildMeshlets(indices.data(), indices.size(), meshletLevel.levelVertexView.data + model.vertexStart,
+					model.vertexCount, Level_Data::meshletMaxVertices, Level_Data::meshletMaxTriangles, meshlets);
+				buildTime += std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - buildStart).count() / 1000.0f;
+				meshletCount += meshlets.size();
+				triangleCount += indices.size() / 3;
+				for (const MESH_OPTIMIZER::MESHLET& meshlet : meshlets)
+					coneCount += meshlet.coneCutoff > 0 ? 1 : 0;
+			}
+		meshletCount = meshletCount == 0 ? 1 : meshletCount;
+		log.Log((std::to_string(triangleCount) + " triangles in " + std::to_string(meshletCount) + " meshlets, " +
+			std::to_string(static_cast<float>(triangleCount) / meshletCount) + " triangles per meshlet, " +
+			std::to_string(coneCount * 100.0f / meshletCount) + "% can face away whole, built in " +
+			std::to_string(buildTime) + " ms").c_str());
+		return 0;
+	}
+	// headless run without a window or GPU: Level_Renderer_D3D12 -headless ../Level1 [frames] [recording threads] [indirect] [nomeshlets] [noocclusion]
+	if (argc >= 3 && argc <= 8 && std::strcmp(argv[1], "-headless") == 0)
+	{
+		GLog log;
+		log.Create("HeadlessOutput.txt");
+		log.EnableConsoleLogging(true);
+		Level_Data headlessLevel;
+		std::string levelFolder = argv[2];
+		if (headlessLevel.LoadLevel((levelFolder + "/GameLevel.txt").c_str(),
+			(levelFolder + "/Models").c_str(), log) == false)
+			return 1;
+		unsigned frames = argc >= 4 ? std::strtoul(argv[3], nullptr, 10) : 100;
+		unsigned workers = argc >= 5 ? std::strtoul(argv[4], nullptr, 10) : 1;
+		bool indirect = false, meshletCulling = true, occlusionCulling = true;
+		for (int arg = 5; arg < argc; arg++)
+		{
+			indirect = indirect || std::strcmp(argv[arg], "indirect") == 0;
+			meshletCulling = meshletCulling && std::strcmp(argv[arg], "nomeshlets") != 0;
+			occlusionCulling = occlusionCulling && std::strcmp(argv[arg], "noocclusion") != 0;
+		}
+
+		Recording_Render_Device device;
+		Frame_Renderer frameRenderer(device, headlessLevel, log);
+		frameRenderer.SetRecordingWorkers(workers);
+		frameRenderer.SetIndirectDraws(indirect);
+		frameRenderer.SetClusterCulling(meshletCulling);
+		frameRenderer.SetOcclusionCulling(occlusionCulling);
+		GW::MATH::GMATRIXF view, projection, viewProjection;
+		GW::MATH::GVECTORF eye = { 0.25f, 6.5f, -0.25f, 1 }, at = { 0, 0, 0, 0 }, up = { 0, 1, 0, 0 };
+		GW::MATH::GMatrix::LookAtLHF(eye, at, up, view);
+		GW::MATH::GMatrix::ProjectionDirectXLHF(G_DEGREE_TO_RADIAN_F(65), device.GetAspectRatio(), 0.1f, 100, projection);
+		SIMD_MATH::MultiplyMatrix(view, projection, viewProjection);
+		frameRenderer.SetCamera(viewProjection, eye);
+
+		unsigned long long draws = 0, commands = 0, constantWritesAvoided = 0, triangles = 0, fullDetailTriangles = 0;
+		unsigned long long meshletsTested = 0, meshletsCulled = 0, drawnTriangles = 0, instanceRecords = 0;
+		unsigned long long frustumVisible = 0, occluded = 0, placedTransforms = 0;
+		for (const Level_Data::MODEL_INSTANCES& instances : headlessLevel.levelInstances)
+			placedTransforms += instances.transformCount;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned frame = 0; frame < frames; frame++)
+		{
+			frameRenderer.LinkChildrenToParent();
+			frameRenderer.Render(device.BeginFrame());
+			device.EndFrame();
+			draws += indirect ? frameRenderer.GetIndirectArgs().GetDrawCount() :
+				device.GetRecordedFrame().CountCommands(RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED);
+			commands += device.GetRecordedFrame().GetCommands().size();
+			constantWritesAvoided += frameRenderer.GetDrawPackets().GetStats().constantWritesAvoided;
+			triangles += frameRenderer.GetLodSelector().GetStats().triangles;
+			fullDetailTriangles += frameRenderer.GetLodSelector().GetStats().fullDetailTriangles;
+			const Cluster_Culler::CLUSTER_STATS& clusterStats = frameRenderer.GetClusterCuller().GetStats();
+			meshletsTested += clusterStats.clustersTested;
+			meshletsCulled += clusterStats.frustumCulled + clusterStats.backfaceCulled;
+			drawnTriangles += clusterStats.trianglesOut;
+			instanceRecords += frameRenderer.GetInstanceRecords().GetRecords().size();
+			const Occlusion_Culler::OCCLUSION_STATS& occlusionStats = frameRenderer.GetOcclusionCuller().GetStats();
+			frustumVisible += occlusionStats.transformsTested;
+			occluded += occlusionStats.transformsOccluded;
+		}
+		float totalTime = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count() / 1000.0f;
+		frames = frames == 0 ? 1 : frames;
+		log.Log((std::to_string(frames) + " headless frames, " + std::to_string(totalTime / frames) + " ms per frame, " +
+			std::to_string(draws / frames) + " draws in " + std::to_string(commands / frames) + " commands per frame, " +
+			std::to_string(constantWritesAvoided / frames) + " constant writes avoided per frame, " +
+			std::to_string(triangles / frames) + " of " + std::to_string(fullDetailTriangles / frames) + " triangles per frame after LOD, " +
+			std::to_string(meshletsCulled / frames) + " of " + std::to_string(meshletsTested / frames) + " meshlets culled leaving " +
+			std::to_string(drawnTriangles / frames) + " triangles per frame, " +
+			std::to_string(instanceRecords / frames) + " instance records per frame, " +
+			std::to_string(frustumVisible / frames) + " of " + std::to_string(placedTransforms) + " transforms in the frustum and " +
+			std::to_string(occluded / frames) + " of them occluded per frame, " +
+			std::to_string((device.GetStats().bytesWritten + device.GetStats().bytesUploaded) / frames) + " bytes uploaded per frame").c_str());
+		return 0;
+	}
+#if defined(LEVEL_RENDERER_D3D12)
 	GWindow win;
 	GEventResponder msgs;
 	GDirectX12Surface d3d12;
@@ -79,5 +262,8 @@ int main()
 			}// clean-up when renderer falls off stack
 		}
 	}
+#else
+	std::cout << "Usage: Level_Renderer_Headless -headless|-cook|-compress|-meshlets ../Level1" << std::endl;
+#endif
 	return 0; // that's all folks
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Read only memory mapping of a whole file, pages come straight from the OS file cache
+class Mapped_File
+{
+	const char*											mData = nullptr;
+	size_t												mSize = 0;
+#if defined(_WIN32)
+	HANDLE												mFile = INVALID_HANDLE_VALUE;
+	HANDLE												mMapping = nullptr;
+#else
+	int													mFile = -1;
+#endif
+
+public:
+
+	Mapped_File() {}
+	Mapped_File(const Mapped_File&) = delete;
+	Mapped_File& operator=(const Mapped_File&) = delete;
+	~Mapped_File() { Close(); }
+
+	//Maps the entire file, returns false if it is missing or empty
+	bool Open(const char* filePath)
+	{
+		Close();
+#if defined(_WIN32)
+		mFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+		mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mMapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+		mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+		mFile = open(filePath, O_RDONLY);
+		if (mFile == -1)
+			return false;
+		struct stat fileInfo;
+		if (fstat(mFile, &fileInfo) != 0 || fileInfo.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+		if (view != MAP_FAILED)
+		{
+			// geometry is consumed front to back during the GPU upload
+			madvise(view, static_cast<size_t>(fileInfo.st_size), MADV_SEQUENTIAL);
+			mData = static_cast<const char*>(view);
+			mSize = static_cast<size_t>(fileInfo.st_size);
+		}
+#endif
+		if (mData == nullptr)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+#if defined(_WIN32)
+		if (mData != nullptr)
+			UnmapViewOfFile(mData);
+		if (mMapping != nullptr)
+			CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE)
+			CloseHandle(mFile);
+		mMapping = nullptr;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mData != nullptr)
+			munmap(const_cast<char*>(mData), mSize);
+		if (mFile != -1)
+			close(mFile);
+		mFile = -1;
+#endif
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	bool IsOpen() const { return mData != nullptr; }
+	const char* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+};
@@ -0,0 +1,861 @@
+#pragma once
+// Index and vertex reordering, meshlet building and simplification run on each imported .h2b before it joins the level.
+// Everything works on one index range at a time so mesh and material ranges stay where they are.
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace MESH_OPTIMIZER
+{
+	// post transform cache behaviour of an index list, measured against a FIFO cache
+	struct CACHE_STATS
+	{
+		float acmr; // vertex shader runs per triangle, 0.5 is the best a regular grid can do
+		float atvr; // vertex shader runs per vertex used, 1.0 is ideal
+	};
+
+	// simulates a FIFO post transform cache of cacheSize entries
+	inline CACHE_STATS AnalyzeVertexCache(const unsigned* indices, size_t indexCount, unsigned vertexCount,
+		unsigned cacheSize = 16) {
+		CACHE_STATS out = { 0, 0 };
+		if (indexCount < 3 || vertexCount == 0)
+			return out;
+		std::vector<size_t> cachedAt(vertexCount, ~size_t(0)); // miss count when the vertex entered the cache
+		std::vector<char> used(vertexCount, 0);
+		size_t misses = 0, unique = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned v = indices[i];
+			if (cachedAt[v] == ~size_t(0) || misses - cachedAt[v] >= cacheSize) {
+				cachedAt[v] = misses++;
+			}
+			if (used[v] == 0) {
+				used[v] = 1;
+				++unique;
+			}
+		}
+		out.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+		out.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+		return out;
+	}
+
+	// Tipsify (Sander, Nehab & Barczak 2007): fans around the most recent vertex that is still
+	// in a cache of cacheSize entries, jumping through a dead end stack when the fan runs out.
+	// Indices refer to vertices [0, vertexCount). clusterStarts (optional) receives the first
+	// triangle of every run that restarted from a cold cache, used by OptimizeOverdraw.
+	inline void OptimizeVertexCache(unsigned* indices, size_t indexCount, unsigned vertexCount,
+		unsigned cacheSize = 16, std::vector<size_t>* clusterStarts = nullptr) {
+		const size_t triangleCount = indexCount / 3;
+		if (clusterStarts != nullptr)
+			clusterStarts->assign(1, 0);
+		if (triangleCount < 2 || vertexCount == 0)
+			return;
+		// vertex -> triangles adjacency, counting sort style
+		std::vector<unsigned> live(vertexCount, 0), adjacencyStart(vertexCount + 1, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++live[indices[i]];
+		for (unsigned v = 0; v < vertexCount; ++v)
+			adjacencyStart[v + 1] = adjacencyStart[v] + live[v];
+		std::vector<unsigned> adjacency(adjacencyStart[vertexCount]);
+		std::vector<unsigned> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+			for (unsigned c = 0; c < 3; ++c)
+				adjacency[fill[indices[t * 3 + c]]++] = static_cast<unsigned>(t);
+
+		std::vector<unsigned> output;
+		output.reserve(triangleCount * 3);
+		std::vector<size_t> timestamp(vertexCount, 0);
+		std::vector<char> emitted(triangleCount, 0);
+		std::vector<unsigned> deadEnds, candidates;
+		size_t time = cacheSize + 1;
+		unsigned cursor = 0; // next vertex to try once the dead end stack is empty
+		long long fan = indices[0];
+		while (fan >= 0) {
+			candidates.clear();
+			for (unsigned a = adjacencyStart[fan]; a < adjacencyStart[fan + 1]; ++a) {
+				unsigned t = adjacency[a];
+				if (emitted[t])
+					continue;
+				emitted[t] = 1;
+				for (unsigned c = 0; c < 3; ++c) {
+					unsigned v = indices[t * 3 + c];
+					output.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					--live[v];
+					if (time - timestamp[v] > cacheSize)
+						timestamp[v] = time++;
+				}
+			}
+			// best candidate: still has triangles and stays in the cache while they are emitted
+			long long next = -1;
+			long long bestPriority = -1;
+			for (unsigned v : candidates) {
+				if (live[v] == 0)
+					continue;
+				long long priority = 0;
+				if (time - timestamp[v] + 2 * live[v] <= cacheSize)
+					priority = static_cast<long long>(time - timestamp[v]);
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = v;
+				}
+			}
+			if (next < 0) {
+				while (deadEnds.empty() == false && next < 0) {
+					unsigned v = deadEnds.back();
+					deadEnds.pop_back();
+					if (live[v] > 0)
+						next = v;
+				}
+			}
+			if (next < 0) {
+				// nothing recent is left, the cache is cold from here on
+				while (cursor < vertexCount && live[cursor] == 0)
+					++cursor;
+				if (cursor < vertexCount) {
+					next = cursor;
+					if (clusterStarts != nullptr && output.size() / 3 < triangleCount)
+						clusterStarts->push_back(output.size() / 3);
+				}
+			}
+			fan = next;
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Orders the clusters from OptimizeVertexCache so the ones facing out from the middle of the
+	// range draw first, they tend to hide the rest from most directions. Triangles inside a
+	// cluster keep their order so the cache behaviour barely moves.
+	inline void OptimizeOverdraw(unsigned* indices, size_t indexCount, const H2B::VERTEX* vertices,
+		const std::vector<size_t>& clusterStarts) {
+		const size_t triangleCount = indexCount / 3;
+		if (clusterStarts.size() < 2 || triangleCount == 0)
+			return;
+		// area weighted centroid and normal of every cluster
+		struct CLUSTER { size_t first, last; float sort; };
+		std::vector<CLUSTER> clusters(clusterStarts.size());
+		std::vector<float> centroids(clusters.size() * 3, 0), normals(clusters.size() * 3, 0);
+		float middle[3] = { 0, 0, 0 }, totalArea = 0;
+		for (size_t c = 0; c < clusters.size(); ++c) {
+			clusters[c].first = clusterStarts[c];
+			clusters[c].last = c + 1 < clusters.size() ? clusterStarts[c + 1] : triangleCount;
+			float area = 0;
+			for (size_t t = clusters[c].first; t < clusters[c].last; ++t) {
+				const H2B::VECTOR& a = vertices[indices[t * 3]].pos;
+				const H2B::VECTOR& b = vertices[indices[t * 3 + 1]].pos;
+				const H2B::VECTOR& d = vertices[indices[t * 3 + 2]].pos;
+				float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z }, e2[3] = { d.x - a.x, d.y - a.y, d.z - a.z };
+				float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float twiceArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				float center[3] = { (a.x + b.x + d.x) / 3, (a.y + b.y + d.y) / 3, (a.z + b.z + d.z) / 3 };
+				for (unsigned k = 0; k < 3; ++k) {
+					centroids[c * 3 + k] += center[k] * twiceArea;
+					normals[c * 3 + k] += n[k];
+					middle[k] += center[k] * twiceArea;
+				}
+				area += twiceArea;
+			}
+			totalArea += area;
+			for (unsigned k = 0; k < 3; ++k)
+				centroids[c * 3 + k] = area > 0 ? centroids[c * 3 + k] / area : 0;
+		}
+		for (unsigned k = 0; k < 3; ++k)
+			middle[k] = totalArea > 0 ? middle[k] / totalArea : 0;
+		for (size_t c = 0; c < clusters.size(); ++c) {
+			const float* n = &normals[c * 3];
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			float sort = 0;
+			for (unsigned k = 0; k < 3; ++k)
+				sort += (centroids[c * 3 + k] - middle[k]) * (length > 0 ? n[k] / length : 0);
+			clusters[c].sort = sort;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(),
+			[](const CLUSTER& a, const CLUSTER& b) { return a.sort > b.sort; });
+		std::vector<unsigned> output;
+		output.reserve(triangleCount * 3);
+		for (const CLUSTER& cluster : clusters)
+			output.insert(output.end(), indices + cluster.first * 3, indices + cluster.last * 3);
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Renumbers vertices in the order the indices first reach them so fetches walk memory forward.
+	// Vertices no index uses are kept at the end.
+	inline void OptimizeVertexFetch(std::vector<H2B::VERTEX>& vertices, unsigned* indices, size_t indexCount) {
+		const unsigned unassigned = ~0u;
+		std::vector<unsigned> remap(vertices.size(), unassigned);
+		std::vector<H2B::VERTEX> reordered;
+		reordered.reserve(vertices.size());
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned& slot = remap[indices[i]];
+			if (slot == unassigned) {
+				slot = static_cast<unsigned>(reordered.size());
+				reordered.push_back(vertices[indices[i]]);
+			}
+			indices[i] = slot;
+		}
+		for (size_t v = 0; v < vertices.size(); ++v)
+			if (remap[v] == unassigned)
+				reordered.push_back(vertices[v]);
+		vertices.swap(reordered);
+	}
+
+	// unit normal from the cross of a triangle's edges, false when it has no area
+	inline bool TriangleNormal(const float* a, const float* b, const float* c, float* n) {
+		const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (!(length > 0)) {
+			n[0] = n[1] = n[2] = 0;
+			return false;
+		}
+		for (unsigned k = 0; k < 3; ++k)
+			n[k] /= length;
+		return true;
+	}
+
+	// one meshlet of BuildMeshlets, its triangles sit together in the range it was built from
+	struct MESHLET
+	{
+		unsigned indexOffset, indexCount; // relative to the range passed in
+		float center[3], radius; // sphere around every vertex it uses
+		// every triangle normal (cross of its edges) lies within acos(coneCutoff) of coneAxis,
+		// a cutoff of 0 or less means they spread too far to ever face away together
+		float coneAxis[3], coneCutoff;
+	};
+
+	// Groups the triangles of a range into meshlets of at most maxVertices vertices and maxTriangles
+	// triangles and rewrites the range one meshlet after the other. A meshlet starts at the earliest
+	// triangle left and grows through triangles touching its corners, taking the one that adds the fewest
+	// new vertices and then the one closest to its middle, that distance stretched the further the triangle
+	// turns away from the meshlet's normals, so meshlets stay compact and their normal cones narrow.
+	// When nothing connected fits any more it carries on from the next triangle left in range order.
+	// Triangles keep their relative order inside a meshlet so the vertex cache order survives.
+	inline void BuildMeshlets(unsigned* indices, size_t indexCount, const H2B::VERTEX* vertices, unsigned vertexCount,
+		unsigned maxVertices, unsigned maxTriangles, std::vector<MESHLET>& outMeshlets) {
+		outMeshlets.clear();
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+			return;
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			if (indices[i] >= vertexCount)
+				return; // malformed, leave it to the caller
+		const unsigned none = ~0u;
+		// triangles around every position, flat shaded meshes share positions rather than vertices
+		std::vector<unsigned> positionOf(vertexCount, none), used;
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			if (positionOf[indices[i]] == none)
+				used.push_back(positionOf[indices[i]] = indices[i]);
+		std::sort(used.begin(), used.end(), [&](unsigned a, unsigned b) {
+			return std::memcmp(&vertices[a].pos, &vertices[b].pos, sizeof(H2B::VECTOR)) < 0;
+		});
+		unsigned positionCount = 0;
+		for (size_t u = 0; u < used.size(); ++u) {
+			if (u > 0 && std::memcmp(&vertices[used[u - 1]].pos, &vertices[used[u]].pos, sizeof(H2B::VECTOR)) != 0)
+				++positionCount;
+			positionOf[used[u]] = positionCount;
+		}
+		positionCount += used.empty() ? 0 : 1;
+		std::vector<unsigned> adjacencyStart(positionCount + 1, 0), adjacency(triangleCount * 3);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++adjacencyStart[positionOf[indices[i]] + 1];
+		for (unsigned p = 0; p < positionCount; ++p)
+			adjacencyStart[p + 1] += adjacencyStart[p];
+		{
+			std::vector<unsigned> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+			for (size_t i = 0; i < triangleCount * 3; ++i)
+				adjacency[fill[positionOf[indices[i]]]++] = static_cast<unsigned>(i / 3);
+		}
+		std::vector<float> centroids(triangleCount * 3), normals(triangleCount * 3);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			const float* corner[3] = { &vertices[indices[t * 3]].pos.x, &vertices[indices[t * 3 + 1]].pos.x,
+				&vertices[indices[t * 3 + 2]].pos.x };
+			for (unsigned k = 0; k < 3; ++k)
+				centroids[t * 3 + k] = (corner[0][k] + corner[1][k] + corner[2][k]) / 3;
+			TriangleNormal(corner[0], corner[1], corner[2], &normals[t * 3]);
+		}
+
+		std::vector<char> emitted(triangleCount, 0);
+		// meshlet that last used a vertex or listed a triangle as a candidate, so nothing needs clearing
+		std::vector<unsigned> vertexMeshlet(vertexCount, none), candidateMeshlet(triangleCount, none);
+		std::vector<unsigned> members, candidates, output;
+		output.reserve(triangleCount * 3);
+		size_t cursor = 0;
+		for (unsigned meshlet = 0; cursor < triangleCount; ++meshlet) {
+			members.clear();
+			candidates.clear();
+			unsigned meshletVertices = 0;
+			float middle[3] = { 0, 0, 0 }, facing[3] = { 0, 0, 0 };
+			auto newVertices = [&](size_t t) {
+				const unsigned* tri = &indices[t * 3];
+				unsigned count = 0;
+				for (unsigned c = 0; c < 3; ++c) // a repeated vertex only counts once
+					count += vertexMeshlet[tri[c]] != meshlet && (c < 1 || tri[c] != tri[0]) && (c < 2 || tri[c] != tri[1]) ? 1 : 0;
+				return count;
+			};
+			auto add = [&](size_t t) {
+				emitted[t] = 1;
+				members.push_back(static_cast<unsigned>(t));
+				for (unsigned k = 0; k < 3; ++k) {
+					middle[k] += (centroids[t * 3 + k] - middle[k]) / members.size();
+					facing[k] += normals[t * 3 + k];
+				}
+				for (unsigned c = 0; c < 3; ++c) {
+					unsigned v = indices[t * 3 + c];
+					if (vertexMeshlet[v] != meshlet) {
+						vertexMeshlet[v] = meshlet;
+						++meshletVertices;
+					}
+					const unsigned p = positionOf[v];
+					for (unsigned a = adjacencyStart[p]; a < adjacencyStart[p + 1]; ++a) {
+						unsigned neighbour = adjacency[a];
+						if (emitted[neighbour] == 0 && candidateMeshlet[neighbour] != meshlet) {
+							candidateMeshlet[neighbour] = meshlet;
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+			};
+			while (cursor < triangleCount && emitted[cursor])
+				++cursor;
+			if (cursor == triangleCount)
+				break;
+			add(cursor);
+			while (members.size() < maxTriangles) {
+				unsigned best = none, bestNew = 4;
+				float bestDistance = FLT_MAX;
+				for (size_t c = 0; c < candidates.size();) {
+					const unsigned t = candidates[c];
+					const unsigned added = emitted[t] ? 4 : newVertices(t);
+					// taken, or it will never fit again since the meshlet only gains vertices
+					if (added == 4 || meshletVertices + added > maxVertices) {
+						candidates[c] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					// closer and facing the same way as the meshlet so far is better
+					float distance = 0, agreement = 0, facingLength = 0;
+					for (unsigned k = 0; k < 3; ++k) {
+						distance += (centroids[t * 3 + k] - middle[k]) * (centroids[t * 3 + k] - middle[k]);
+						agreement += normals[t * 3 + k] * facing[k];
+						facingLength += facing[k] * facing[k];
+					}
+					if (facingLength > 0) {
+						const float turn = 2 - agreement / std::sqrt(facingLength);
+						distance *= turn * turn;
+					}
+					if (added < bestNew || (added == bestNew && distance < bestDistance)) {
+						best = t;
+						bestNew = added;
+						bestDistance = distance;
+					}
+					++c;
+				}
+				if (best == none) {
+					// nothing connected fits, carry on from the next triangle in range order
+					while (cursor < triangleCount && emitted[cursor])
+						++cursor;
+					if (cursor == triangleCount || meshletVertices + newVertices(cursor) > maxVertices)
+						break;
+					best = static_cast<unsigned>(cursor);
+				}
+				add(best);
+			}
+
+			std::sort(members.begin(), members.end());
+			MESHLET out = {};
+			out.indexOffset = static_cast<unsigned>(output.size());
+			out.indexCount = static_cast<unsigned>(members.size() * 3);
+			float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (unsigned t : members)
+				for (unsigned c = 0; c < 3; ++c) {
+					output.push_back(indices[t * 3 + c]);
+					const float* p = &vertices[indices[t * 3 + c]].pos.x;
+					for (unsigned k = 0; k < 3; ++k) {
+						low[k] = std::min(low[k], p[k]);
+						high[k] = std::max(high[k], p[k]);
+					}
+				}
+			float radiusSquared = 0;
+			for (unsigned k = 0; k < 3; ++k)
+				out.center[k] = (low[k] + high[k]) * 0.5f;
+			for (unsigned t : members)
+				for (unsigned c = 0; c < 3; ++c) {
+					const float* p = &vertices[indices[t * 3 + c]].pos.x;
+					float d[3] = { p[0] - out.center[0], p[1] - out.center[1], p[2] - out.center[2] };
+					radiusSquared = std::max(radiusSquared, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+				}
+			out.radius = std::sqrt(radiusSquared);
+			float facingLength = std::sqrt(facing[0] * facing[0] + facing[1] * facing[1] + facing[2] * facing[2]);
+			out.coneCutoff = -1;
+			if (facingLength > 0) {
+				out.coneCutoff = 1;
+				for (unsigned k = 0; k < 3; ++k)
+					out.coneAxis[k] = facing[k] / facingLength;
+				for (unsigned t : members) {
+					const float* n = &normals[t * 3];
+					if (n[0] == 0 && n[1] == 0 && n[2] == 0)
+						continue; // no area, nothing to see from any side
+					out.coneCutoff = std::min(out.coneCutoff,
+						n[0] * out.coneAxis[0] + n[1] * out.coneAxis[1] + n[2] * out.coneAxis[2]);
+				}
+			}
+			outMeshlets.push_back(out);
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Tipsify inside every meshlet of a range BuildMeshlets rewrote, no triangle moves to another meshlet so their
+	// bounds and cones still hold. Each meshlet is renumbered to its own few vertices first so the work follows the
+	// meshlet's size rather than the whole mesh's, and it keeps whichever order misses the cache less.
+	inline void OptimizeMeshletVertexCache(unsigned* indices, const std::vector<MESHLET>& meshlets, unsigned vertexCount,
+		unsigned cacheSize = 16) {
+		const unsigned none = ~0u;
+		std::vector<unsigned> localOf(vertexCount, none), globalOf, local, reordered;
+		for (const MESHLET& meshlet : meshlets) {
+			unsigned* range = indices + meshlet.indexOffset;
+			globalOf.clear();
+			local.resize(meshlet.indexCount);
+			for (unsigned i = 0; i < meshlet.indexCount; ++i) {
+				if (range[i] >= vertexCount)
+					return; // malformed, leave it to the caller
+				if (localOf[range[i]] == none) {
+					localOf[range[i]] = static_cast<unsigned>(globalOf.size());
+					globalOf.push_back(range[i]);
+				}
+				local[i] = localOf[range[i]];
+			}
+			const unsigned localCount = static_cast<unsigned>(globalOf.size());
+			reordered = local;
+			OptimizeVertexCache(reordered.data(), reordered.size(), localCount, cacheSize);
+			if (AnalyzeVertexCache(reordered.data(), reordered.size(), localCount, cacheSize).acmr <
+				AnalyzeVertexCache(local.data(), local.size(), localCount, cacheSize).acmr)
+				for (unsigned i = 0; i < meshlet.indexCount; ++i)
+					range[i] = globalOf[reordered[i]];
+			for (unsigned v : globalOf)
+				localOf[v] = none;
+		}
+	}
+
+	// error quadric of a set of planes, every plane counts once whatever the size of its triangle
+	// so a small feature costs as much to flatten as a big one
+	struct QUADRIC
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+	};
+
+	inline void AddQuadric(QUADRIC& to, const QUADRIC& from) {
+		const double* source = &from.a2;
+		double* target = &to.a2;
+		for (unsigned k = 0; k < 10; ++k)
+			target[k] += source[k];
+	}
+
+	// sum of squared distances from the point to every plane, never less than the largest one
+	inline double EvaluateQuadric(const QUADRIC& q, const float* p) {
+		const double x = p[0], y = p[1], z = p[2];
+		double error = q.a2 * x * x + 2 * q.ab * x * y + 2 * q.ac * x * z + 2 * q.ad * x +
+			q.b2 * y * y + 2 * q.bc * y * z + 2 * q.bd * y + q.c2 * z * z + 2 * q.cd * z + q.d2;
+		return error > 0 ? error : 0;
+	}
+
+	// Quadric error metric simplification (Garland & Heckbert 1997) that only collapses an edge into
+	// one of its ends, so the result indexes the same vertices and none are created.
+	// Vertices sharing a position collapse together, a corner moved onto another position takes the
+	// vertex there that already belongs to its triangle or else the one with the closest normal.
+	// Positions on an open border of the range never move so neighbouring ranges stay stitched.
+	// One run produces levelCount results for descending targetIndexCounts, each continues from the one
+	// before with the original quadrics. A level that cannot reach its target without moving the surface
+	// further than maxError stops where it got to. outErrors receives how far the surface moved from the
+	// planes it started on in model units, MeasureDeviation gives the distance to the surface itself.
+	inline void SimplifyMesh(const unsigned* indices, size_t indexCount, const H2B::VERTEX* vertices, unsigned vertexCount,
+		const size_t* targetIndexCounts, unsigned levelCount, float maxError, std::vector<unsigned>* outIndices, float* outErrors) {
+		for (unsigned level = 0; level < levelCount; ++level) {
+			outIndices[level].clear();
+			outErrors[level] = 0;
+		}
+		const unsigned none = ~0u;
+		// one id per distinct position, vertices at the same position are chained through nextAtPosition
+		std::vector<unsigned> positionOf(vertexCount, none), nextAtPosition(vertexCount, none);
+		std::vector<unsigned> firstAtPosition, positionVertex, used;
+		for (size_t i = 0; i < indexCount; ++i) {
+			if (indices[i] >= vertexCount)
+				return; // malformed, leave it to the caller
+			if (positionOf[indices[i]] == none)
+				used.push_back(positionOf[indices[i]] = indices[i]);
+		}
+		auto samePosition = [&](unsigned a, unsigned b) {
+			return std::memcmp(&vertices[a].pos, &vertices[b].pos, sizeof(H2B::VECTOR)) == 0;
+		};
+		std::sort(used.begin(), used.end(), [&](unsigned a, unsigned b) {
+			return std::memcmp(&vertices[a].pos, &vertices[b].pos, sizeof(H2B::VECTOR)) < 0;
+		});
+		for (size_t u = 0; u < used.size(); ++u) {
+			unsigned v = used[u];
+			if (u == 0 || samePosition(used[u - 1], v) == false) {
+				firstAtPosition.push_back(none);
+				positionVertex.push_back(v);
+			}
+			positionOf[v] = static_cast<unsigned>(firstAtPosition.size() - 1);
+			nextAtPosition[v] = firstAtPosition.back();
+			firstAtPosition.back() = v;
+		}
+		const unsigned positionCount = static_cast<unsigned>(firstAtPosition.size());
+		auto position = [&](unsigned p) { return &vertices[positionVertex[p]].pos.x; };
+
+		// triangles by position, those already degenerate are dropped
+		const size_t triangleCount = indexCount / 3;
+		std::vector<unsigned> corners(triangleCount * 3);
+		std::vector<char> live(triangleCount, 1);
+		std::vector<QUADRIC> quadrics(positionCount, QUADRIC{});
+		size_t liveCount = 0;
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (unsigned c = 0; c < 3; ++c)
+				corners[t * 3 + c] = positionOf[indices[t * 3 + c]];
+			const unsigned* tri = &corners[t * 3];
+			if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+				live[t] = 0;
+				continue;
+			}
+			++liveCount;
+			const float* a = position(tri[0]), * b = position(tri[1]), * d = position(tri[2]);
+			double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			double twiceArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (twiceArea <= 0)
+				continue;
+			for (unsigned k = 0; k < 3; ++k)
+				n[k] /= twiceArea;
+			double d0 = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+			QUADRIC plane = { n[0] * n[0], n[0] * n[1], n[0] * n[2], n[0] * d0,
+				n[1] * n[1], n[1] * n[2], n[1] * d0, n[2] * n[2], n[2] * d0, d0 * d0 };
+			for (unsigned c = 0; c < 3; ++c)
+				AddQuadric(quadrics[tri[c]], plane);
+		}
+
+		// edges used by anything but exactly two triangles are borders, their ends stay put
+		std::vector<char> locked(positionCount, 0);
+		{
+			std::vector<uint64_t> edges;
+			edges.reserve(liveCount * 3);
+			for (size_t t = 0; t < triangleCount; ++t) {
+				if (live[t] == 0)
+					continue;
+				for (unsigned c = 0; c < 3; ++c) {
+					unsigned a = corners[t * 3 + c], b = corners[t * 3 + (c + 1) % 3];
+					edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			for (size_t first = 0, last = 0; first < edges.size(); first = last) {
+				while (last < edges.size() && edges[last] == edges[first])
+					++last;
+				if (last - first != 2)
+					locked[edges[first] >> 32] = locked[edges[first] & 0xFFFFFFFF] = 1;
+			}
+		}
+
+		// passes of independent collapses, cheapest first, until the target or the error limit
+		struct COLLAPSE { double cost; unsigned from, to; };
+		std::vector<COLLAPSE> collapses, best;
+		std::vector<unsigned> adjacencyStart(positionCount + 1), adjacency, moved(positionCount);
+		std::vector<char> touched(positionCount);
+		double worstError = 0;
+		const double maxErrorSquared = static_cast<double>(maxError) * maxError;
+		bool stuck = false;
+		for (unsigned level = 0; level < levelCount; ++level) {
+			while (stuck == false && liveCount * 3 > targetIndexCounts[level]) {
+				// live triangles around every position
+				std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+				for (size_t t = 0; t < triangleCount; ++t)
+					if (live[t])
+						for (unsigned c = 0; c < 3; ++c)
+							++adjacencyStart[corners[t * 3 + c] + 1];
+				for (unsigned p = 0; p < positionCount; ++p)
+					adjacencyStart[p + 1] += adjacencyStart[p];
+				adjacency.resize(adjacencyStart[positionCount]);
+				std::vector<unsigned> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+				for (size_t t = 0; t < triangleCount; ++t)
+					if (live[t])
+						for (unsigned c = 0; c < 3; ++c)
+							adjacency[fill[corners[t * 3 + c]]++] = static_cast<unsigned>(t);
+
+				// only the cheapest collapse out of every position is a candidate
+				best.assign(positionCount, COLLAPSE{ maxErrorSquared, none, none });
+				for (size_t t = 0; t < triangleCount; ++t) {
+					if (live[t] == 0)
+						continue;
+					for (unsigned c = 0; c < 3; ++c) {
+						unsigned a = corners[t * 3 + c], b = corners[t * 3 + (c + 1) % 3];
+						for (unsigned side = 0; side < 2; ++side, std::swap(a, b)) {
+							if (locked[a])
+								continue;
+							QUADRIC merged = quadrics[a];
+							AddQuadric(merged, quadrics[b]);
+							double cost = EvaluateQuadric(merged, position(b));
+							if (cost <= best[a].cost)
+								best[a] = { cost, a, b };
+						}
+					}
+				}
+				collapses.clear();
+				for (const COLLAPSE& collapse : best)
+					if (collapse.from != none)
+						collapses.push_back(collapse);
+				std::sort(collapses.begin(), collapses.end(),
+					[](const COLLAPSE& x, const COLLAPSE& y) { return x.cost < y.cost; });
+
+				std::fill(touched.begin(), touched.end(), 0);
+				for (unsigned p = 0; p < positionCount; ++p)
+					moved[p] = p;
+				size_t applied = 0;
+				for (const COLLAPSE& collapse : collapses) {
+					if (liveCount * 3 <= targetIndexCounts[level])
+						break;
+					if (touched[collapse.from] || touched[collapse.to])
+						continue;
+					// no triangle kept around the collapse may turn over
+					bool flips = false;
+					for (unsigned a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1] && flips == false; ++a) {
+						const unsigned* tri = &corners[adjacency[a] * 3];
+						if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+							continue;
+						const float* before[3], * after[3];
+						for (unsigned c = 0; c < 3; ++c) {
+							before[c] = position(tri[c]);
+							after[c] = position(tri[c] == collapse.from ? collapse.to : tri[c]);
+						}
+						double n0[3], n1[3];
+						for (unsigned k = 0; k < 3; ++k) {
+							unsigned k1 = (k + 1) % 3, k2 = (k + 2) % 3;
+							n0[k] = (double(before[1][k1]) - before[0][k1]) * (double(before[2][k2]) - before[0][k2]) -
+								(double(before[1][k2]) - before[0][k2]) * (double(before[2][k1]) - before[0][k1]);
+							n1[k] = (double(after[1][k1]) - after[0][k1]) * (double(after[2][k2]) - after[0][k2]) -
+								(double(after[1][k2]) - after[0][k2]) * (double(after[2][k1]) - after[0][k1]);
+						}
+						flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0;
+					}
+					if (flips)
+						continue;
+					// the whole neighbourhood is frozen for the rest of the pass so the checks above stay true
+					for (unsigned a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1]; ++a) {
+						const unsigned* tri = &corners[adjacency[a] * 3];
+						if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+							--liveCount;
+						for (unsigned c = 0; c < 3; ++c)
+							touched[tri[c]] = 1;
+					}
+					moved[collapse.from] = collapse.to;
+					AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+					worstError = std::max(worstError, collapse.cost);
+					++applied;
+				}
+				if (applied == 0) {
+					stuck = true;
+					break;
+				}
+				for (size_t t = 0; t < triangleCount; ++t) {
+					if (live[t] == 0)
+						continue;
+					unsigned* tri = &corners[t * 3];
+					for (unsigned c = 0; c < 3; ++c)
+						tri[c] = moved[tri[c]];
+					if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+						live[t] = 0;
+				}
+			}
+
+			// back to vertices, each corner keeps its own vertex unless its position moved
+			std::vector<unsigned>& out = outIndices[level];
+			out.reserve(liveCount * 3);
+			for (size_t t = 0; t < triangleCount; ++t) {
+				if (live[t] == 0)
+					continue;
+				for (unsigned c = 0; c < 3; ++c) {
+					unsigned original = indices[t * 3 + c], target = corners[t * 3 + c];
+					unsigned chosen = positionOf[original] == target ? original : none;
+					for (unsigned k = 0; k < 3 && chosen == none; ++k)
+						if (positionOf[indices[t * 3 + k]] == target)
+							chosen = indices[t * 3 + k];
+					if (chosen == none) {
+						const H2B::VECTOR& normal = vertices[original].nrm;
+						float bestDot = -2;
+						for (unsigned v = firstAtPosition[target]; v != none; v = nextAtPosition[v]) {
+							const H2B::VECTOR& candidate = vertices[v].nrm;
+							float dot = normal.x * candidate.x + normal.y * candidate.y + normal.z * candidate.z;
+							if (dot > bestDot) {
+								bestDot = dot;
+								chosen = v;
+							}
+						}
+					}
+					out.push_back(chosen);
+				}
+			}
+			outErrors[level] = static_cast<float>(std::sqrt(worstError));
+		}
+	}
+
+	// squared distance from a point to a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+	inline float PointTriangleDistanceSquared(const float* p, const float* a, const float* b, const float* c) {
+		const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		const float ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+		auto dot = [](const float* u, const float* v) { return u[0] * v[0] + u[1] * v[1] + u[2] * v[2]; };
+		auto distanceTo = [p](const float* q) {
+			const float d[3] = { p[0] - q[0], p[1] - q[1], p[2] - q[2] };
+			return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		};
+		const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0 && d2 <= 0)
+			return distanceTo(a);
+		const float bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+		const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0 && d4 <= d3)
+			return distanceTo(b);
+		const float cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+		const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0 && d5 <= d6)
+			return distanceTo(c);
+		float closest[3];
+		const float vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+			const float v = d1 / (d1 - d3);
+			for (unsigned k = 0; k < 3; ++k)
+				closest[k] = a[k] + v * ab[k];
+		}
+		else if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+			const float w = d2 / (d2 - d6);
+			for (unsigned k = 0; k < 3; ++k)
+				closest[k] = a[k] + w * ac[k];
+		}
+		else if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+			const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			for (unsigned k = 0; k < 3; ++k)
+				closest[k] = b[k] + w * (c[k] - b[k]);
+		}
+		else {
+			const float denominator = 1 / (va + vb + vc);
+			const float v = vb * denominator, w = vc * denominator;
+			for (unsigned k = 0; k < 3; ++k)
+				closest[k] = a[k] + ab[k] * v + ac[k] * w;
+		}
+		return distanceTo(closest);
+	}
+
+	// Largest distance from a vertex of the original range to the simplified surface, one sided so it is what
+	// the simplification took away rather than a true Hausdorff distance. The simplified triangles are bucketed
+	// into a grid of cubic cells and each vertex searches outwards one ring of cells at a time, it stops once no
+	// unvisited cell can be closer than the nearest triangle found or that triangle is closer than the worst so far.
+	// A range simplified to nothing reports the diagonal of its bounds.
+	inline float MeasureDeviation(const unsigned* original, size_t originalCount, const unsigned* simplified,
+		size_t simplifiedCount, const H2B::VERTEX* vertices) {
+		if (originalCount == 0)
+			return 0;
+		if (simplifiedCount == 0) {
+			float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (size_t i = 0; i < originalCount; ++i)
+				for (unsigned k = 0; k < 3; ++k) {
+					low[k] = std::min(low[k], (&vertices[original[i]].pos.x)[k]);
+					high[k] = std::max(high[k], (&vertices[original[i]].pos.x)[k]);
+				}
+			return std::sqrt((high[0] - low[0]) * (high[0] - low[0]) + (high[1] - low[1]) * (high[1] - low[1]) +
+				(high[2] - low[2]) * (high[2] - low[2]));
+		}
+		const size_t triangleCount = simplifiedCount / 3;
+		if (triangleCount == 0)
+			return 0;
+		auto corner = [&](size_t t, unsigned c) { return &vertices[simplified[t * 3 + c]].pos.x; };
+
+		// about as many cells along the longest side as the cube root of the triangle count
+		float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			for (unsigned k = 0; k < 3; ++k) {
+				low[k] = std::min(low[k], (&vertices[simplified[i]].pos.x)[k]);
+				high[k] = std::max(high[k], (&vertices[simplified[i]].pos.x)[k]);
+			}
+		const float longest = std::max(high[0] - low[0], std::max(high[1] - low[1], high[2] - low[2]));
+		const int cellsAlongLongest = std::min(64, std::max(1, static_cast<int>(std::cbrt(static_cast<double>(triangleCount)))));
+		const float cellSize = longest > 0 ? longest / cellsAlongLongest : 1;
+		int cells[3];
+		for (unsigned k = 0; k < 3; ++k)
+			cells[k] = std::min(cellsAlongLongest, static_cast<int>((high[k] - low[k]) / cellSize) + 1);
+		auto cellOf = [&](float value, unsigned k) {
+			return std::min(cells[k] - 1, std::max(0, static_cast<int>((value - low[k]) / cellSize)));
+		};
+
+		// every triangle goes in each cell its bounds overlap
+		std::vector<unsigned> cellStart(static_cast<size_t>(cells[0]) * cells[1] * cells[2] + 1, 0), cellTriangles;
+		for (unsigned pass = 0; pass < 2; ++pass) {
+			std::vector<unsigned> fill(cellStart.begin(), cellStart.end() - 1);
+			for (size_t t = 0; t < triangleCount; ++t) {
+				int from[3], to[3];
+				for (unsigned k = 0; k < 3; ++k) {
+					from[k] = cellOf(std::min(corner(t, 0)[k], std::min(corner(t, 1)[k], corner(t, 2)[k])), k);
+					to[k] = cellOf(std::max(corner(t, 0)[k], std::max(corner(t, 1)[k], corner(t, 2)[k])), k);
+				}
+				for (int z = from[2]; z <= to[2]; ++z)
+					for (int y = from[1]; y <= to[1]; ++y)
+						for (int x = from[0]; x <= to[0]; ++x) {
+							const size_t cell = (static_cast<size_t>(z) * cells[1] + y) * cells[0] + x;
+							if (pass == 0)
+								++cellStart[cell + 1];
+							else
+								cellTriangles[fill[cell]++] = static_cast<unsigned>(t);
+						}
+			}
+			if (pass == 0) {
+				for (size_t cell = 1; cell < cellStart.size(); ++cell)
+					cellStart[cell] += cellStart[cell - 1];
+				cellTriangles.resize(cellStart.back());
+			}
+		}
+
+		std::vector<unsigned> visited(triangleCount, ~0u);
+		float worst = 0;
+		for (size_t i = 0; i < originalCount; ++i) {
+			const float* p = &vertices[original[i]].pos.x;
+			const int home[3] = { cellOf(p[0], 0), cellOf(p[1], 1), cellOf(p[2], 2) };
+			float best = FLT_MAX;
+			for (int ring = 0; best > worst; ++ring) {
+				int from[3], to[3];
+				for (unsigned k = 0; k < 3; ++k) {
+					from[k] = std::max(0, home[k] - ring);
+					to[k] = std::min(cells[k] - 1, home[k] + ring);
+				}
+				for (int z = from[2]; z <= to[2]; ++z)
+					for (int y = from[1]; y <= to[1]; ++y)
+						for (int x = from[0]; x <= to[0]; ++x) {
+							// only the shell, the cells inside were searched by the rings before
+							if (std::abs(x - home[0]) < ring && std::abs(y - home[1]) < ring && std::abs(z - home[2]) < ring)
+								continue;
+							const size_t cell = (static_cast<size_t>(z) * cells[1] + y) * cells[0] + x;
+							for (unsigned c = cellStart[cell]; c < cellStart[cell + 1]; ++c) {
+								const unsigned t = cellTriangles[c];
+								if (visited[t] == static_cast<unsigned>(i))
+									continue;
+								visited[t] = static_cast<unsigned>(i);
+								best = std::min(best, PointTriangleDistanceSquared(p, corner(t, 0), corner(t, 1), corner(t, 2)));
+							}
+						}
+				// the unsearched cells are all past a face of the searched block that is not on the grid's border
+				float beyond = FLT_MAX;
+				for (unsigned k = 0; k < 3; ++k) {
+					if (from[k] > 0)
+						beyond = std::min(beyond, std::max(0.0f, p[k] - (low[k] + from[k] * cellSize)));
+					if (to[k] < cells[k] - 1)
+						beyond = std::min(beyond, std::max(0.0f, low[k] + (to[k] + 1) * cellSize - p[k]));
+				}
+				if (beyond == FLT_MAX || beyond * beyond >= best)
+					break;
+			}
+			worst = std::max(worst, best);
+		}
+		return std::sqrt(worst);
+	}
+}
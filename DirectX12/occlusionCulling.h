@@ -0,0 +1,394 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+
+//Rasterizes the biggest visible models into a small CPU depth buffer and drops the frustum's visible transforms
+//whose bounds lie behind it everywhere, tested against a max depth pyramid of the buffer
+class Occlusion_Culler
+{
+public:
+	//Size of the depth buffer, both powers of 2 so every pyramid level halves them
+	static const unsigned bufferWidth = 256, bufferHeight = 128;
+
+	//What the last Cull did, transforms are the ones the frustum culler let through
+	struct OCCLUSION_STATS
+	{
+		unsigned transformsTested, transformsOccluded;
+		//Occluders drawn into the buffer and their triangles that faced the camera
+		unsigned occluders, occluderTriangles;
+	};
+
+private:
+	//A visible transform big enough on screen to hide others
+	struct OCCLUDER
+	{
+		float size;
+		unsigned transform, modelIndex;
+	};
+
+	//Model space corners of every model's bounds
+	std::vector<std::array<GW::MATH::GVECTORF, 8>>			mModelCorners;
+	//Full detail triangles of every model
+	std::vector<unsigned>									mModelTriangles;
+	std::vector<Frustum_Culler::VISIBLE_RUN>				mVisibleRuns;
+	std::vector<OCCLUDER>									mOccluders;
+	//Clip space vertices of the occluder being drawn
+	std::vector<GW::MATH::GVECTORF>							mClipVertices;
+	//Level 0 is the depth buffer, every level after it keeps the farthest depth of 2x2 texels of the one before
+	//0 is the near plane and 1 the far plane like the GPU
+	std::vector<float>										mDepth;
+	std::vector<unsigned>									mLevelOffsets;
+	//Occluders are drawn biggest first until either limit is reached
+	unsigned												mMaxOccluders = 8;
+	unsigned												mMaxOccluderTriangles = 32768;
+	//Smallest fraction of the viewport height an occluder's bounding sphere has to cover
+	float													mMinOccluderSize = 0.15f;
+	bool													mEnabled = true;
+	OCCLUSION_STATS											mStats = {};
+
+public:
+
+	//Caches the bounds and triangle counts of every model, call again after a level load
+	void Build(const Level_Data& level)
+	{
+		mModelCorners.resize(level.levelModels.size());
+		mModelTriangles.assign(level.levelModels.size(), 0);
+		for (size_t model = 0; model < level.levelModels.size(); model++)
+		{
+			const GW::MATH::GAABBMMF& box = level.levelModelBounds[model].box;
+			for (unsigned corner = 0; corner < 8; corner++)
+				mModelCorners[model][corner] = { (corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+					(corner & 4) ? box.max.z : box.min.z, 1 };
+			const Level_Data::LEVEL_MODEL& levelModel = level.levelModels[model];
+			for (unsigned mesh = levelModel.meshStart; mesh < levelModel.meshStart + levelModel.meshCount; mesh++)
+				mModelTriangles[model] += level.levelMeshes[mesh].drawInfo.indexCount / 3;
+		}
+
+		mLevelOffsets.clear();
+		unsigned size = 0;
+		for (unsigned width = bufferWidth, height = bufferHeight; height > 0; width /= 2, height /= 2)
+		{
+			mLevelOffsets.push_back(size);
+			size += width * height;
+		}
+		mDepth.assign(size, 1.0f);
+		mVisibleRuns.clear();
+		mStats = {};
+	}
+
+	//Keeps the runs' transforms that are not hidden behind the frame's occluders
+	//worldTransforms is indexed like Level_Data::levelTransforms
+	void Cull(const Level_Data& level, const std::vector<Frustum_Culler::VISIBLE_RUN>& runs,
+		const std::vector<GW::MATH::GMATRIXF>& worldTransforms, const GW::MATH::GMATRIXF& viewProjection)
+	{
+		mStats = {};
+		mVisibleRuns.clear();
+		if (mEnabled == false)
+		{
+			mVisibleRuns = runs;
+			for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+				mStats.transformsTested += run.transformCount;
+			return;
+		}
+
+		SelectOccluders(level, runs, worldTransforms, viewProjection);
+		std::fill(mDepth.begin(), mDepth.begin() + bufferWidth * bufferHeight, 1.0f);
+		for (const OCCLUDER& occluder : mOccluders)
+			DrawOccluder(level, occluder, worldTransforms[occluder.transform], viewProjection);
+		BuildPyramid();
+
+		for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+		{
+			unsigned modelIndex = level.levelInstances[run.instanceIndex].modelIndex;
+			for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+			{
+				mStats.transformsTested++;
+				if (IsOccluded(modelIndex, worldTransforms[transform], viewProjection))
+				{
+					mStats.transformsOccluded++;
+					continue;
+				}
+				AppendVisible(run.instanceIndex, transform);
+			}
+		}
+	}
+
+	//Disabled the frustum culler's runs pass through as they are
+	void SetEnabled(bool enabled) { mEnabled = enabled; }
+	bool IsEnabled() const { return mEnabled; }
+	void SetOccluderBudget(unsigned maxOccluders, unsigned maxTriangles, float minSize)
+	{
+		mMaxOccluders = maxOccluders;
+		mMaxOccluderTriangles = maxTriangles;
+		mMinOccluderSize = minSize;
+	}
+
+	const std::vector<Frustum_Culler::VISIBLE_RUN>& GetVisibleRuns() const { return mVisibleRuns; }
+	const OCCLUSION_STATS& GetStats() const { return mStats; }
+	//bufferWidth * bufferHeight depths of the last Cull's occluders, row 0 is the top of the screen
+	const float* GetDepth() const { return mDepth.data(); }
+
+private:
+
+	//Biggest first by the projected size of the bounding sphere, the same estimate Lod_Selector uses
+	void SelectOccluders(const Level_Data& level, const std::vector<Frustum_Culler::VISIBLE_RUN>& runs,
+		const std::vector<GW::MATH::GMATRIXF>& worldTransforms, const GW::MATH::GMATRIXF& viewProjection)
+	{
+		mOccluders.clear();
+		float projectionScale = std::sqrt(viewProjection.row1.y * viewProjection.row1.y +
+			viewProjection.row2.y * viewProjection.row2.y + viewProjection.row3.y * viewProjection.row3.y);
+		for (const Frustum_Culler::VISIBLE_RUN& run : runs)
+		{
+			unsigned modelIndex = level.levelInstances[run.instanceIndex].modelIndex;
+			if (mModelTriangles[modelIndex] == 0 || mModelTriangles[modelIndex] > mMaxOccluderTriangles)
+				continue;
+			const GW::MATH::GSPHEREF& sphere = level.levelModelBounds[modelIndex].sphere;
+			for (unsigned transform = run.transformStart; transform < run.transformStart + run.transformCount; transform++)
+			{
+				const GW::MATH::GMATRIXF& world = worldTransforms[transform];
+				float center[4];
+				SIMD_MATH::TransformPoint(world, &sphere.x, center);
+				float scale = std::sqrt(std::fmax(RowLengthSquared(world.row1), std::fmax(RowLengthSquared(world.row2), RowLengthSquared(world.row3))));
+				float viewDepth = center[0] * viewProjection.row1.w + center[1] * viewProjection.row2.w +
+					center[2] * viewProjection.row3.w + viewProjection.row4.w;
+				float distance = viewDepth - sphere.radius * scale;
+				//The camera is inside the sphere, nothing can be bigger
+				float size = distance > 0 ? sphere.radius * scale * projectionScale / distance : FLT_MAX;
+				if (size >= mMinOccluderSize)
+					mOccluders.push_back({ size, transform, modelIndex });
+			}
+		}
+		std::sort(mOccluders.begin(), mOccluders.end(), [](const OCCLUDER& a, const OCCLUDER& b) { return a.size > b.size; });
+
+		//Smaller occluders still fill what the triangle budget has left
+		size_t kept = 0;
+		unsigned triangles = 0;
+		for (size_t o = 0; o < mOccluders.size() && kept < mMaxOccluders; o++)
+		{
+			unsigned modelTriangles = mModelTriangles[mOccluders[o].modelIndex];
+			if (triangles + modelTriangles > mMaxOccluderTriangles)
+				continue;
+			triangles += modelTriangles;
+			mOccluders[kept++] = mOccluders[o];
+		}
+		mOccluders.resize(kept);
+		mStats.occluders = static_cast<unsigned>(kept);
+	}
+
+	void DrawOccluder(const Level_Data& level, const OCCLUDER& occluder, const GW::MATH::GMATRIXF& world,
+		const GW::MATH::GMATRIXF& viewProjection)
+	{
+		const Level_Data::LEVEL_MODEL& model = level.levelModels[occluder.modelIndex];
+		GW::MATH::GMATRIXF worldViewProjection;
+		SIMD_MATH::MultiplyMatrix(world, viewProjection, worldViewProjection);
+		mClipVertices.resize(model.vertexCount);
+		for (unsigned v = 0; v < model.vertexCount; v++)
+			SIMD_MATH::TransformPoint(worldViewProjection, &level.levelVertexView[model.vertexStart + v].pos.x, &mClipVertices[v].x);
+
+		for (unsigned mesh = model.meshStart; mesh < model.meshStart + model.meshCount; mesh++)
+		{
+			const H2B::BATCH& draw = level.levelMeshes[mesh].drawInfo;
+			const unsigned* indices = level.levelIndexView.data + model.indexStart + draw.indexOffset;
+			for (unsigned i = 0; i + 2 < draw.indexCount; i += 3)
+				DrawClippedTriangle(mClipVertices[indices[i]], mClipVertices[indices[i + 1]], mClipVertices[indices[i + 2]]);
+		}
+	}
+
+	//Clips the triangle against the near plane, z >= 0 in D3D clip space, and draws what is left as a fan
+	void DrawClippedTriangle(const GW::MATH::GVECTORF& a, const GW::MATH::GVECTORF& b, const GW::MATH::GVECTORF& c)
+	{
+		//Fully outside one side of the frustum
+		if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+			(a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+			(a.z < 0 && b.z < 0 && c.z < 0) || (a.z > a.w && b.z > b.w && c.z > c.w))
+			return;
+
+		const GW::MATH::GVECTORF* corners[3] = { &a, &b, &c };
+		GW::MATH::GVECTORF polygon[4];
+		unsigned count = 0;
+		for (unsigned v = 0; v < 3; v++)
+		{
+			const GW::MATH::GVECTORF& from = *corners[v];
+			const GW::MATH::GVECTORF& to = *corners[(v + 1) % 3];
+			if (from.z >= 0)
+				polygon[count++] = from;
+			if ((from.z >= 0) != (to.z >= 0))
+			{
+				float t = from.z / (from.z - to.z);
+				polygon[count++] = { from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, 0, from.w + (to.w - from.w) * t };
+			}
+		}
+
+		float screen[4][3];
+		for (unsigned v = 0; v < count; v++)
+		{
+			float inverseW = 1.0f / polygon[v].w;
+			screen[v][0] = (polygon[v].x * inverseW * 0.5f + 0.5f) * bufferWidth;
+			screen[v][1] = (0.5f - polygon[v].y * inverseW * 0.5f) * bufferHeight;
+			screen[v][2] = polygon[v].z * inverseW;
+		}
+		for (unsigned v = 2; v < count; v++)
+			if (RasterizeTriangle(screen[0], screen[v - 1], screen[v]))
+				mStats.occluderTriangles++;
+	}
+
+	//Writes the nearest depth of every pixel whose center the triangle covers, back faces are skipped like the GPU does
+	//The depth written is the farthest the triangle's plane gets over the pixel so a pixel never looks nearer than it is
+	bool RasterizeTriangle(const float* a, const float* b, const float* c)
+	{
+		//Front faces wind clockwise on screen, which is a positive area with y pointing down
+		float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		if (!(area > 0))
+			return false;
+		int xStart = std::max(0, static_cast<int>(std::ceil(std::min(a[0], std::min(b[0], c[0])) - 0.5f)));
+		int xEnd = std::min(static_cast<int>(bufferWidth) - 1, static_cast<int>(std::floor(std::max(a[0], std::max(b[0], c[0])) - 0.5f)));
+		int yStart = std::max(0, static_cast<int>(std::ceil(std::min(a[1], std::min(b[1], c[1])) - 0.5f)));
+		int yEnd = std::min(static_cast<int>(bufferHeight) - 1, static_cast<int>(std::floor(std::max(a[1], std::max(b[1], c[1])) - 0.5f)));
+		if (xStart > xEnd || yStart > yEnd)
+			return true;
+
+		//Edge i is the one opposite vertex i, positive on the inside
+		const float* vertices[3] = { a, b, c };
+		float edgeX[3], edgeY[3], edgeStart[3];
+		float startX = xStart + 0.5f, startY = yStart + 0.5f;
+		for (unsigned e = 0; e < 3; e++)
+		{
+			const float* from = vertices[(e + 1) % 3];
+			const float* to = vertices[(e + 2) % 3];
+			edgeX[e] = from[1] - to[1];
+			edgeY[e] = to[0] - from[0];
+			edgeStart[e] = (to[0] - from[0]) * (startY - from[1]) - (to[1] - from[1]) * (startX - from[0]);
+		}
+		float inverseArea = 1.0f / area;
+		float depthX = (edgeX[0] * a[2] + edgeX[1] * b[2] + edgeX[2] * c[2]) * inverseArea;
+		float depthY = (edgeY[0] * a[2] + edgeY[1] * b[2] + edgeY[2] * c[2]) * inverseArea;
+		float depthStart = (edgeStart[0] * a[2] + edgeStart[1] * b[2] + edgeStart[2] * c[2]) * inverseArea +
+			0.5f * (std::fabs(depthX) + std::fabs(depthY));
+		float depthCap = std::max(a[2], std::max(b[2], c[2]));
+
+		//Rows are walked in blocks of 4 pixels starting on a multiple of 4, pixels left of xStart fail an edge test
+		int blockStart = xStart & ~3;
+		float blockOffset = static_cast<float>(blockStart - xStart);
+		for (int y = yStart; y <= yEnd; y++)
+		{
+			float rowY = static_cast<float>(y - yStart);
+			float e0 = edgeStart[0] + edgeY[0] * rowY + edgeX[0] * blockOffset;
+			float e1 = edgeStart[1] + edgeY[1] * rowY + edgeX[1] * blockOffset;
+			float e2 = edgeStart[2] + edgeY[2] * rowY + edgeX[2] * blockOffset;
+			float depth = depthStart + depthY * rowY + depthX * blockOffset;
+			float* row = mDepth.data() + y * bufferWidth;
+#if defined(SIMD_MATH_SSE)
+			const __m128 lanes = _mm_setr_ps(0, 1, 2, 3), zero = _mm_setzero_ps(), cap = _mm_set1_ps(depthCap);
+			__m128 edge0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(_mm_set1_ps(edgeX[0]), lanes));
+			__m128 edge1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(_mm_set1_ps(edgeX[1]), lanes));
+			__m128 edge2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(_mm_set1_ps(edgeX[2]), lanes));
+			__m128 depths = _mm_add_ps(_mm_set1_ps(depth), _mm_mul_ps(_mm_set1_ps(depthX), lanes));
+			const __m128 step0 = _mm_set1_ps(edgeX[0] * 4), step1 = _mm_set1_ps(edgeX[1] * 4), step2 = _mm_set1_ps(edgeX[2] * 4);
+			const __m128 depthStep = _mm_set1_ps(depthX * 4);
+			for (int x = blockStart; x <= xEnd; x += 4)
+			{
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+				if (_mm_movemask_ps(inside) != 0)
+				{
+					__m128 old = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(old, _mm_min_ps(depths, cap));
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+				}
+				edge0 = _mm_add_ps(edge0, step0);
+				edge1 = _mm_add_ps(edge1, step1);
+				edge2 = _mm_add_ps(edge2, step2);
+				depths = _mm_add_ps(depths, depthStep);
+			}
+#else
+			for (int x = blockStart; x < ((xEnd + 4) & ~3); x++)
+			{
+				float lane = static_cast<float>(x - blockStart);
+				if (e0 + edgeX[0] * lane >= 0 && e1 + edgeX[1] * lane >= 0 && e2 + edgeX[2] * lane >= 0)
+					row[x] = std::min(row[x], std::min(depth + depthX * lane, depthCap));
+			}
+#endif
+		}
+		return true;
+	}
+
+	void BuildPyramid()
+	{
+		for (unsigned level = 1; level < mLevelOffsets.size(); level++)
+		{
+			unsigned width = bufferWidth >> level, height = bufferHeight >> level;
+			const float* source = mDepth.data() + mLevelOffsets[level - 1];
+			float* target = mDepth.data() + mLevelOffsets[level];
+			for (unsigned y = 0; y < height; y++)
+				for (unsigned x = 0; x < width; x++)
+				{
+					const float* texels = source + (y * 2) * (width * 2) + x * 2;
+					target[y * width + x] = std::max(std::max(texels[0], texels[1]), std::max(texels[width * 2], texels[width * 2 + 1]));
+				}
+		}
+	}
+
+	//Hidden when the nearest corner of its box is farther than the farthest occluder depth over its screen rectangle
+	//The rectangle is grown by a pixel so an edge that only covers a pixel's center cannot hide what peeks past it
+	bool IsOccluded(unsigned modelIndex, const GW::MATH::GMATRIXF& world, const GW::MATH::GMATRIXF& viewProjection) const
+	{
+		GW::MATH::GMATRIXF worldViewProjection;
+		SIMD_MATH::MultiplyMatrix(world, viewProjection, worldViewProjection);
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+		for (const GW::MATH::GVECTORF& corner : mModelCorners[modelIndex])
+		{
+			float clip[4];
+			SIMD_MATH::TransformPoint(worldViewProjection, &corner.x, clip);
+			//Crossing the near plane, it covers the camera
+			if (!(clip[2] > 0))
+				return false;
+			float inverseW = 1.0f / clip[3];
+			float x = (clip[0] * inverseW * 0.5f + 0.5f) * bufferWidth;
+			float y = (0.5f - clip[1] * inverseW * 0.5f) * bufferHeight;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			nearest = std::min(nearest, clip[2] * inverseW);
+		}
+		int x0 = std::max(0, static_cast<int>(std::floor(minX)) - 1);
+		int x1 = std::min(static_cast<int>(bufferWidth) - 1, static_cast<int>(std::floor(maxX)) + 1);
+		int y0 = std::max(0, static_cast<int>(std::floor(minY)) - 1);
+		int y1 = std::min(static_cast<int>(bufferHeight) - 1, static_cast<int>(std::floor(maxY)) + 1);
+		if (x0 > x1 || y0 > y1)
+			return false;
+
+		//Coarsest level where the rectangle spans at most 2x2 texels
+		unsigned level = 0;
+		while (level + 1 < mLevelOffsets.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+			level++;
+		const float* depths = mDepth.data() + mLevelOffsets[level];
+		unsigned width = bufferWidth >> level;
+		float farthest = 0;
+		for (int y = y0 >> level; y <= (y1 >> level); y++)
+			for (int x = x0 >> level; x <= (x1 >> level); x++)
+				farthest = std::max(farthest, depths[y * width + x]);
+		return nearest > farthest;
+	}
+
+	//Extends the last run when the transform directly follows it, otherwise starts a new one
+	void AppendVisible(unsigned instance, unsigned transform)
+	{
+		if (mVisibleRuns.empty() == false)
+		{
+			Frustum_Culler::VISIBLE_RUN& last = mVisibleRuns.back();
+			if (last.instanceIndex == instance && last.transformStart + last.transformCount == transform)
+			{
+				last.transformCount++;
+				return;
+			}
+		}
+		mVisibleRuns.push_back({ instance, transform, 1 });
+	}
+
+	static float RowLengthSquared(const GW::MATH::GVECTORF& row)
+	{
+		return row.x * row.x + row.y * row.y + row.z * row.z;
+	}
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+//Blobs keyed by a 64 bit hash of whatever produced them, kept in one file between runs
+//The D3D12 device stores serialized pipeline states in it so warm starts skip building them
+class Pipeline_Cache
+{
+	struct CACHE_HEADER
+	{
+		char magic[4]; // "PSOC"
+		unsigned version; // bump when the layout changes
+		unsigned pointerSize; // blobs are not shared between 32/64 bit builds
+		unsigned entryCount;
+	};
+	//Followed by sizeInBytes bytes of blob
+	struct CACHE_ENTRY
+	{
+		uint64_t key;
+		uint64_t sizeInBytes;
+	};
+	static constexpr unsigned cacheVersion = 1;
+
+	std::unordered_map<uint64_t, std::vector<char>>			mEntries;
+	std::string												mPath;
+	bool													mDirty = false;
+	unsigned												mHits = 0;
+	unsigned												mMisses = 0;
+
+public:
+
+	//FNV-1a, chain calls by passing the previous result as seed
+	static uint64_t Hash(const void* data, size_t sizeInBytes, uint64_t seed = 14695981039346656037ull)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < sizeInBytes; i++)
+			seed = (seed ^ bytes[i]) * 1099511628211ull;
+		return seed;
+	}
+
+	//Reads the cache file at path, a missing or invalid file leaves the cache empty and returns false
+	//Save writes back to the same path either way
+	bool Load(const char* path)
+	{
+		mEntries.clear();
+		mPath = path;
+		mDirty = false;
+
+		GW::SYSTEM::GFile file;
+		file.Create();
+		unsigned fileSize = 0;
+		if (-file.GetFileSize(path, fileSize) || fileSize < sizeof(CACHE_HEADER) || -file.OpenBinaryRead(path))
+			return false;
+		std::vector<char> blob(fileSize);
+		GW::GReturn readResult = file.Read(blob.data(), fileSize);
+		file.CloseFile();
+		if (G_FAIL(readResult))
+			return false;
+
+		CACHE_HEADER header;
+		std::memcpy(&header, blob.data(), sizeof(CACHE_HEADER));
+		if (std::memcmp(header.magic, "PSOC", 4) != 0 || header.version != cacheVersion ||
+			header.pointerSize != sizeof(void*))
+			return false;
+		size_t offset = sizeof(CACHE_HEADER);
+		for (unsigned e = 0; e < header.entryCount; e++)
+		{
+			CACHE_ENTRY entry;
+			if (offset + sizeof(CACHE_ENTRY) > blob.size())
+				break;
+			std::memcpy(&entry, blob.data() + offset, sizeof(CACHE_ENTRY));
+			offset += sizeof(CACHE_ENTRY);
+			//A truncated file keeps the entries before the cut
+			if (entry.sizeInBytes > blob.size() - offset)
+				break;
+			mEntries[entry.key].assign(blob.data() + offset, blob.data() + offset + entry.sizeInBytes);
+			offset += static_cast<size_t>(entry.sizeInBytes);
+		}
+		return true;
+	}
+
+	//Writes the cache back if anything was stored or removed since Load
+	bool Save()
+	{
+		if (mDirty == false || mPath.empty())
+			return true;
+		CACHE_HEADER header = {};
+		std::memcpy(header.magic, "PSOC", 4);
+		header.version = cacheVersion;
+		header.pointerSize = sizeof(void*);
+		header.entryCount = static_cast<unsigned>(mEntries.size());
+		std::vector<char> blob(sizeof(CACHE_HEADER));
+		std::memcpy(blob.data(), &header, sizeof(CACHE_HEADER));
+		for (const auto& entry : mEntries)
+		{
+			CACHE_ENTRY fileEntry = { entry.first, entry.second.size() };
+			const char* fileEntryBytes = reinterpret_cast<const char*>(&fileEntry);
+			blob.insert(blob.end(), fileEntryBytes, fileEntryBytes + sizeof(CACHE_ENTRY));
+			blob.insert(blob.end(), entry.second.begin(), entry.second.end());
+		}
+
+		GW::SYSTEM::GFile file;
+		file.Create();
+		if (-file.OpenBinaryWrite(mPath.c_str()) || -file.Write(blob.data(), static_cast<unsigned>(blob.size())))
+			return false;
+		file.CloseFile();
+		mDirty = false;
+		return true;
+	}
+
+	//nullptr when nothing is stored under key
+	const std::vector<char>* Find(uint64_t key)
+	{
+		auto entry = mEntries.find(key);
+		if (entry == mEntries.end())
+		{
+			mMisses++;
+			return nullptr;
+		}
+		mHits++;
+		return &entry->second;
+	}
+
+	void Store(uint64_t key, const void* data, size_t sizeInBytes)
+	{
+		mEntries[key].assign(static_cast<const char*>(data), static_cast<const char*>(data) + sizeInBytes);
+		mDirty = true;
+	}
+
+	//Drops an entry the driver no longer accepts
+	void Remove(uint64_t key)
+	{
+		mDirty |= mEntries.erase(key) > 0;
+	}
+
+	unsigned GetEntryCount() const { return static_cast<unsigned>(mEntries.size()); }
+	unsigned GetHitCount() const { return mHits; }
+	unsigned GetMissCount() const { return mMisses; }
+};
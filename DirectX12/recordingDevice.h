@@ -0,0 +1,402 @@
+#pragma once
+#include <cstring>
+#include <initializer_list>
+
+enum class RECORDED_COMMAND_TYPE { SET_GEOMETRY, SET_CONSTANTS, SET_CONSTANT, SET_CONSTANT_BUFFER, SET_RESOURCE, DRAW_INDEXED_INSTANCED, EXECUTE_INDIRECT, WRITE_BUFFER };
+
+//One recorded call, args hold the call's integer arguments in declaration order
+//Constant and upload data is copied into the payload of the list that recorded it
+struct RECORDED_COMMAND
+{
+	RECORDED_COMMAND_TYPE type;
+	unsigned args[5];
+	unsigned payloadOffset, payloadSize;
+};
+
+//Command list that keeps every call in an inspectable stream instead of talking to a GPU
+class Recording_Command_List : public Render_Command_List
+{
+	std::vector<RECORDED_COMMAND>							mCommands;
+	std::vector<char>										mPayload;
+
+public:
+
+	void SetGeometry(RENDER_BUFFER vertices, RENDER_BUFFER indices) override
+	{
+		Record(RECORDED_COMMAND_TYPE::SET_GEOMETRY, { vertices, indices }, nullptr, 0);
+	}
+
+	void SetConstants(RENDER_CONSTANT_SLOT slot, unsigned count32, const void* data) override
+	{
+		Record(RECORDED_COMMAND_TYPE::SET_CONSTANTS, { static_cast<unsigned>(slot), count32 }, data, count32 * 4);
+	}
+
+	void SetConstant(RENDER_CONSTANT_SLOT slot, unsigned offset32, unsigned value) override
+	{
+		Record(RECORDED_COMMAND_TYPE::SET_CONSTANT, { static_cast<unsigned>(slot), offset32, value }, nullptr, 0);
+	}
+
+	void SetConstantBuffer(RENDER_CONSTANT_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) override
+	{
+		Record(RECORDED_COMMAND_TYPE::SET_CONSTANT_BUFFER, { static_cast<unsigned>(slot), buffer, offsetInBytes }, nullptr, 0);
+	}
+
+	void SetResource(RENDER_RESOURCE_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) override
+	{
+		Record(RECORDED_COMMAND_TYPE::SET_RESOURCE, { static_cast<unsigned>(slot), buffer, offsetInBytes }, nullptr, 0);
+	}
+
+	void DrawIndexedInstanced(unsigned indexCount, unsigned instanceCount,
+		unsigned startIndex, int baseVertex, unsigned startInstance) override
+	{
+		Record(RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED,
+			{ indexCount, instanceCount, startIndex, static_cast<unsigned>(baseVertex), startInstance }, nullptr, 0);
+	}
+
+	void ExecuteIndirect(RENDER_BUFFER arguments, unsigned offsetInBytes, unsigned drawCount) override
+	{
+		Record(RECORDED_COMMAND_TYPE::EXECUTE_INDIRECT, { arguments, offsetInBytes, drawCount }, nullptr, 0);
+	}
+
+	//Uploads are device calls, the recording device logs them here so they keep their place in the frame
+	void RecordWrite(RENDER_BUFFER buffer, unsigned offsetInBytes, const void* data, unsigned sizeInBytes)
+	{
+		Record(RECORDED_COMMAND_TYPE::WRITE_BUFFER, { buffer, offsetInBytes, sizeInBytes }, data, sizeInBytes);
+	}
+
+	//Plays every recorded call back onto another list, in order
+	void Replay(Render_Command_List& target) const
+	{
+		for (const RECORDED_COMMAND& command : mCommands)
+		{
+			const unsigned* a = command.args;
+			switch (command.type)
+			{
+			case RECORDED_COMMAND_TYPE::SET_GEOMETRY:
+				target.SetGeometry(a[0], a[1]);
+				break;
+			case RECORDED_COMMAND_TYPE::SET_CONSTANTS:
+				target.SetConstants(static_cast<RENDER_CONSTANT_SLOT>(a[0]), a[1], GetPayload(command));
+				break;
+			case RECORDED_COMMAND_TYPE::SET_CONSTANT:
+				target.SetConstant(static_cast<RENDER_CONSTANT_SLOT>(a[0]), a[1], a[2]);
+				break;
+			case RECORDED_COMMAND_TYPE::SET_CONSTANT_BUFFER:
+				target.SetConstantBuffer(static_cast<RENDER_CONSTANT_SLOT>(a[0]), a[1], a[2]);
+				break;
+			case RECORDED_COMMAND_TYPE::SET_RESOURCE:
+				target.SetResource(static_cast<RENDER_RESOURCE_SLOT>(a[0]), a[1], a[2]);
+				break;
+			case RECORDED_COMMAND_TYPE::DRAW_INDEXED_INSTANCED:
+				target.DrawIndexedInstanced(a[0], a[1], a[2], static_cast<int>(a[3]), a[4]);
+				break;
+			case RECORDED_COMMAND_TYPE::EXECUTE_INDIRECT:
+				target.ExecuteIndirect(a[0], a[1], a[2]);
+				break;
+			case RECORDED_COMMAND_TYPE::WRITE_BUFFER:
+				break;
+			}
+		}
+	}
+
+	//Keeps the allocations so steady state frames do not allocate
+	void Clear()
+	{
+		mCommands.clear();
+		mPayload.clear();
+	}
+
+	const std::vector<RECORDED_COMMAND>& GetCommands() const { return mCommands; }
+	const void* GetPayload(const RECORDED_COMMAND& command) const { return mPayload.data() + command.payloadOffset; }
+
+	unsigned CountCommands(RECORDED_COMMAND_TYPE type) const
+	{
+		unsigned count = 0;
+		for (const RECORDED_COMMAND& command : mCommands)
+			count += command.type == type ? 1 : 0;
+		return count;
+	}
+
+private:
+
+	void Record(RECORDED_COMMAND_TYPE type, std::initializer_list<unsigned> args, const void* data, unsigned sizeInBytes)
+	{
+		RECORDED_COMMAND command = {};
+		command.type = type;
+		unsigned i = 0;
+		for (unsigned arg : args)
+			command.args[i++] = arg;
+		command.payloadOffset = static_cast<unsigned>(mPayload.size());
+		command.payloadSize = sizeInBytes;
+		if (sizeInBytes != 0)
+			mPayload.insert(mPayload.end(), static_cast<const char*>(data), static_cast<const char*>(data) + sizeInBytes);
+		mCommands.push_back(command);
+	}
+};
+
+//Stand in for a GPU fence, the device completes frames itself and a wait completes the value at once
+class Recording_Fence : public Upload_Fence
+{
+	uint64_t												mCompleted = 0;
+	unsigned												mWaits = 0;
+
+public:
+
+	uint64_t GetCompletedValue() const override { return mCompleted; }
+
+	void WaitFor(uint64_t value) override
+	{
+		mWaits++;
+		Complete(value);
+	}
+
+	void Complete(uint64_t value)
+	{
+		if (value > mCompleted)
+			mCompleted = value;
+	}
+
+	unsigned GetWaitCount() const { return mWaits; }
+};
+
+class Recording_Render_Device;
+
+//Stand in for a copy queue, copies land in the device's buffers on Submit and the device completes them with the frame
+class Recording_Copy_Queue : public Copy_Queue
+{
+public:
+	//Totals since the queue was created
+	struct COPY_QUEUE_STATS
+	{
+		unsigned long long bytesCopied;
+		unsigned copies, buffersFinished, submits, stagingCreated, stagingReleased;
+	};
+
+private:
+	struct RECORDED_COPY
+	{
+		RENDER_BUFFER destination;
+		unsigned destinationOffset;
+		COPY_STAGING source;
+		unsigned sourceOffset, sizeInBytes;
+	};
+
+	Recording_Render_Device&								mDevice;
+	//Indexed by COPY_STAGING - 1, released staging is emptied
+	std::vector<std::vector<char>>							mStaging;
+	//Copies recorded since the last Submit
+	std::vector<RECORDED_COPY>								mCopies;
+	Recording_Fence											mFence;
+	uint64_t												mSubmitted = 0;
+	COPY_QUEUE_STATS										mStats = {};
+
+public:
+
+	Recording_Copy_Queue(Recording_Render_Device& device) : mDevice(device) {}
+
+	COPY_STAGING CreateStaging(unsigned sizeInBytes, void*& outCpuAddress) override
+	{
+		mStaging.emplace_back(sizeInBytes);
+		outCpuAddress = mStaging.back().data();
+		mStats.stagingCreated++;
+		return static_cast<COPY_STAGING>(mStaging.size());
+	}
+
+	void ReleaseStaging(COPY_STAGING staging) override
+	{
+		mStaging[staging - 1] = std::vector<char>();
+		mStats.stagingReleased++;
+	}
+
+	void CopyBuffer(RENDER_BUFFER destination, unsigned destinationOffset,
+		COPY_STAGING source, unsigned sourceOffset, unsigned sizeInBytes) override
+	{
+		mCopies.push_back({ destination, destinationOffset, source, sourceOffset, sizeInBytes });
+	}
+
+	void FinishBuffer(RENDER_BUFFER) override { mStats.buffersFinished++; }
+
+	uint64_t Submit() override;
+
+	Upload_Fence& GetFence() override { return mFence; }
+
+	//The fake GPU has run every copy submitted so far
+	void CompleteSubmitted() { mFence.Complete(mSubmitted); }
+
+	const COPY_QUEUE_STATS& GetStats() const { return mStats; }
+	const Recording_Fence& GetRecordingFence() const { return mFence; }
+	//Staging allocations not yet released
+	unsigned GetLiveStagingCount() const { return mStats.stagingCreated - mStats.stagingReleased; }
+};
+
+//Headless backend, buffers live in CPU memory and each frame is recorded for inspection
+//STATIC buffers are filled through an Upload_Batcher over a Recording_Copy_Queue, like the D3D12 device does
+class Recording_Render_Device : public Render_Device
+{
+	friend class Recording_Copy_Queue;
+
+	struct RECORDED_BUFFER
+	{
+		RENDER_BUFFER_DESC desc;
+		std::vector<char> data;
+		bool live;
+	};
+
+public:
+	//Totals since the device was created
+	struct RECORDING_STATS
+	{
+		unsigned long long bytesWritten, bytesAllocated, bytesUploaded;
+		unsigned buffersCreated, buffersReleased, framesRecorded;
+	};
+
+private:
+	std::vector<RECORDED_BUFFER>							mBuffers;
+	Recording_Command_List									mCommandList;
+	RECORDING_STATS											mStats = {};
+	unsigned												mFrameCount;
+	unsigned												mFrameIndex = 0;
+	float													mAspectRatio;
+	bool													mRecording = false;
+	//Frame uploads, the fake GPU finishes a frame frameCount - 1 frames after it was recorded
+	Upload_Ring												mUploadRing;
+	Recording_Fence											mFence;
+	RENDER_BUFFER											mUploadBuffer = 0;
+	uint64_t												mFrameFenceValue = 0;
+	//Writes to STATIC buffers, the batcher is declared last so it drains into the buffers before they go
+	Recording_Copy_Queue									mCopyQueue;
+	Upload_Batcher											mUploadBatcher;
+
+public:
+
+	Recording_Render_Device(unsigned frameCount = 2, float aspectRatio = 800.0f / 600.0f)
+		: mFrameCount(frameCount), mAspectRatio(aspectRatio), mCopyQueue(*this)
+	{
+		mUploadBatcher.Create(mCopyQueue);
+	}
+
+	RENDER_BUFFER CreateBuffer(const RENDER_BUFFER_DESC& desc, const void* initialData) override
+	{
+		RECORDED_BUFFER buffer = { desc, std::vector<char>(desc.sizeInBytes), true };
+		if (initialData != nullptr && desc.usage == RENDER_BUFFER_USAGE::DYNAMIC)
+			std::memcpy(buffer.data.data(), initialData, desc.sizeInBytes);
+		mBuffers.push_back(std::move(buffer));
+		mStats.buffersCreated++;
+		mStats.bytesAllocated += desc.sizeInBytes;
+		RENDER_BUFFER handle = static_cast<RENDER_BUFFER>(mBuffers.size());
+		if (initialData != nullptr && desc.usage == RENDER_BUFFER_USAGE::STATIC)
+			mUploadBatcher.Enqueue(handle, 0, initialData, desc.sizeInBytes);
+		return handle;
+	}
+
+	void ReleaseBuffer(RENDER_BUFFER buffer) override
+	{
+		if (IsLive(buffer) == false)
+			return;
+		//Frames not yet completed may still read it, like the D3D12 device wait for every recorded one
+		if (mFence.GetCompletedValue() < mFrameFenceValue)
+			mFence.WaitFor(mFrameFenceValue);
+		//Copies into the buffer may still be queued
+		if (mBuffers[buffer - 1].desc.usage == RENDER_BUFFER_USAGE::STATIC)
+			mUploadBatcher.WaitIdle();
+		mBuffers[buffer - 1].live = false;
+		mBuffers[buffer - 1].data = std::vector<char>();
+		mStats.buffersReleased++;
+	}
+
+	void WriteBuffer(RENDER_BUFFER buffer, unsigned offsetInBytes, const void* data, unsigned sizeInBytes) override
+	{
+		if (IsLive(buffer) == false || offsetInBytes + sizeInBytes > mBuffers[buffer - 1].data.size())
+			return;
+		if (mBuffers[buffer - 1].desc.usage == RENDER_BUFFER_USAGE::STATIC)
+		{
+			mUploadBatcher.Enqueue(buffer, offsetInBytes, data, sizeInBytes);
+			return;
+		}
+		std::memcpy(mBuffers[buffer - 1].data.data() + offsetInBytes, data, sizeInBytes);
+		mStats.bytesWritten += sizeInBytes;
+		if (mRecording)
+			mCommandList.RecordWrite(buffer, offsetInBytes, data, sizeInBytes);
+	}
+
+	bool AllocateUpload(unsigned sizeInBytes, unsigned alignment, RENDER_UPLOAD& outUpload) override
+	{
+		uint64_t offset;
+		if (mUploadBuffer == 0 || mUploadRing.Allocate(sizeInBytes, alignment, offset) == false)
+			return false;
+		outUpload = { mBuffers[mUploadBuffer - 1].data.data() + offset, mUploadBuffer, static_cast<unsigned>(offset) };
+		mStats.bytesUploaded += sizeInBytes;
+		return true;
+	}
+
+	void ReserveUploadSpace(unsigned bytesPerFrame) override
+	{
+		//One extra frame absorbs the space skipped when an allocation wraps
+		uint64_t capacity = static_cast<uint64_t>(bytesPerFrame) * (mFrameCount + 1);
+		if (mUploadBuffer != 0 && mUploadRing.GetCapacity() >= capacity)
+			return;
+		//ReleaseBuffer waits for every recorded frame, nothing reads the old ring afterwards
+		ReleaseBuffer(mUploadBuffer);
+		mUploadBuffer = CreateBuffer({ RENDER_BUFFER_TYPE::UPLOAD_RING, static_cast<unsigned>(capacity), 1, RENDER_BUFFER_USAGE::DYNAMIC }, nullptr);
+		mUploadRing.Create(capacity, mFence);
+	}
+
+	unsigned GetFrameCount() const override { return mFrameCount; }
+	unsigned GetFrameIndex() const override { return mFrameIndex; }
+	float GetAspectRatio() const override { return mAspectRatio; }
+
+	//Starts a fresh stream, the previous frame's commands are dropped
+	Render_Command_List& BeginFrame() override
+	{
+		//Copies staged since the last frame go out before anything in this one can read them
+		mUploadBatcher.Flush();
+		mCommandList.Clear();
+		mRecording = true;
+		return mCommandList;
+	}
+
+	void EndFrame() override
+	{
+		mRecording = false;
+		mStats.framesRecorded++;
+		mFrameIndex = (mFrameIndex + 1) % mFrameCount;
+		mUploadRing.FinishFrame(++mFrameFenceValue);
+		if (mFrameFenceValue >= mFrameCount - 1)
+			mFence.Complete(mFrameFenceValue - (mFrameCount - 1));
+		//The frame waited on the copies flushed before it, so they are done too
+		mCopyQueue.CompleteSubmitted();
+	}
+
+	//The last (or current) frame
+	const Recording_Command_List& GetRecordedFrame() const { return mCommandList; }
+	const RECORDING_STATS& GetStats() const { return mStats; }
+	const Upload_Ring& GetUploadRing() const { return mUploadRing; }
+	const Recording_Fence& GetFence() const { return mFence; }
+	const Upload_Batcher& GetUploadBatcher() const { return mUploadBatcher; }
+	const Recording_Copy_Queue& GetCopyQueue() const { return mCopyQueue; }
+
+	bool IsLive(RENDER_BUFFER buffer) const
+	{
+		return buffer != 0 && buffer <= mBuffers.size() && mBuffers[buffer - 1].live;
+	}
+
+	const RENDER_BUFFER_DESC& GetBufferDesc(RENDER_BUFFER buffer) const { return mBuffers[buffer - 1].desc; }
+	const std::vector<char>& GetBufferData(RENDER_BUFFER buffer) const { return mBuffers[buffer - 1].data; }
+};
+
+inline uint64_t Recording_Copy_Queue::Submit()
+{
+	for (const RECORDED_COPY& copy : mCopies)
+	{
+		//A released destination has nothing left to receive the copy
+		if (mDevice.IsLive(copy.destination) == false)
+			continue;
+		std::memcpy(mDevice.mBuffers[copy.destination - 1].data.data() + copy.destinationOffset,
+			mStaging[copy.source - 1].data() + copy.sourceOffset, copy.sizeInBytes);
+		mStats.bytesCopied += copy.sizeInBytes;
+		mStats.copies++;
+	}
+	mCopies.clear();
+	mStats.submits++;
+	return ++mSubmitted;
+}
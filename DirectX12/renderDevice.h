@@ -0,0 +1,83 @@
+#pragma once
+
+//Handle to a buffer owned by a Render_Device, 0 is never a valid buffer
+typedef unsigned RENDER_BUFFER;
+
+enum class RENDER_BUFFER_TYPE { VERTICES, INDICES, STRUCTURED, INDIRECT_ARGUMENTS, UPLOAD_RING };
+
+//DYNAMIC buffers live in CPU visible memory and can be rewritten every frame
+//STATIC buffers live in GPU memory, their writes are staged and copied over before the next frame reads them
+enum class RENDER_BUFFER_USAGE { DYNAMIC, STATIC };
+
+//Constant blocks, match the b0/b1 registers of the shaders
+//SCENE_CONSTANTS is bound as a constant buffer, DRAW_CONSTANTS is written as root constants
+enum RENDER_CONSTANT_SLOT { SCENE_CONSTANTS, DRAW_CONSTANTS, RENDER_CONSTANT_SLOT_COUNT };
+
+//Constant buffers have to start on this many bytes
+const unsigned RENDER_CONSTANT_ALIGNMENT = 256;
+
+//Structured buffers, transforms, vertex dequantization and instance records are read by the vertex shader and materials by the pixel shader
+enum RENDER_RESOURCE_SLOT { TRANSFORM_RESOURCE, MATERIAL_RESOURCE, QUANTIZATION_RESOURCE, INSTANCE_RESOURCE, RENDER_RESOURCE_SLOT_COUNT };
+
+struct RENDER_BUFFER_DESC
+{
+	RENDER_BUFFER_TYPE type;
+	unsigned sizeInBytes;
+	//Size of one vertex, index or structure
+	unsigned strideInBytes;
+	//Left out it is DYNAMIC
+	RENDER_BUFFER_USAGE usage;
+};
+
+//Frame memory handed out by Render_Device::AllocateUpload, write through cpuAddress and bind with buffer + offsetInBytes
+struct RENDER_UPLOAD
+{
+	void* cpuAddress;
+	RENDER_BUFFER buffer;
+	unsigned offsetInBytes;
+};
+
+//Commands of one frame in submission order, everything the per frame logic is allowed to ask of the API
+class Render_Command_List
+{
+public:
+	virtual ~Render_Command_List() {}
+
+	virtual void SetGeometry(RENDER_BUFFER vertices, RENDER_BUFFER indices) = 0;
+	virtual void SetConstants(RENDER_CONSTANT_SLOT slot, unsigned count32, const void* data) = 0;
+	//Writes one 32 bit value of a constant block, the rest of the block keeps its last value
+	virtual void SetConstant(RENDER_CONSTANT_SLOT slot, unsigned offset32, unsigned value) = 0;
+	virtual void SetConstantBuffer(RENDER_CONSTANT_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) = 0;
+	virtual void SetResource(RENDER_RESOURCE_SLOT slot, RENDER_BUFFER buffer, unsigned offsetInBytes) = 0;
+	virtual void DrawIndexedInstanced(unsigned indexCount, unsigned instanceCount,
+		unsigned startIndex, int baseVertex, unsigned startInstance) = 0;
+	//Draws drawCount INDIRECT_DRAW records starting offsetInBytes into arguments
+	virtual void ExecuteIndirect(RENDER_BUFFER arguments, unsigned offsetInBytes, unsigned drawCount) = 0;
+};
+
+//Owns GPU resources and the command list of the frame being recorded
+class Render_Device
+{
+public:
+	virtual ~Render_Device() {}
+
+	virtual RENDER_BUFFER CreateBuffer(const RENDER_BUFFER_DESC& desc, const void* initialData) = 0;
+	virtual void ReleaseBuffer(RENDER_BUFFER buffer) = 0;
+	//Copies CPU data into a buffer the GPU is not currently reading
+	virtual void WriteBuffer(RENDER_BUFFER buffer, unsigned offsetInBytes, const void* data, unsigned sizeInBytes) = 0;
+
+	//Memory that stays valid until the GPU finishes the frame being recorded, false if it does not fit
+	virtual bool AllocateUpload(unsigned sizeInBytes, unsigned alignment, RENDER_UPLOAD& outUpload) = 0;
+	//Makes room for bytesPerFrame of uploads in every frame in flight, only call between frames
+	virtual void ReserveUploadSpace(unsigned bytesPerFrame) = 0;
+
+	//Frames that can be in flight at once, per frame resources are created this many times
+	virtual unsigned GetFrameCount() const = 0;
+	//Which of the in flight frames is being recorded
+	virtual unsigned GetFrameIndex() const = 0;
+	virtual float GetAspectRatio() const = 0;
+
+	//Binds the level pipeline and render targets and returns the list to record the frame into
+	virtual Render_Command_List& BeginFrame() = 0;
+	virtual void EndFrame() = 0;
+};
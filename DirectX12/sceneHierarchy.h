@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+
+//Flattened transform hierarchy of a level, parents are always stored before their children
+class Scene_Hierarchy
+{
+	//Structure of arrays in depth first (parent before child) order
+	std::vector<GW::MATH::GMATRIXF>						mLocalTransforms;
+	std::vector<GW::MATH::GMATRIXF>						mWorldTransforms;
+	//Sorted index of each node's parent, -1 for roots
+	std::vector<int>									mParents;
+	//One past the last node of each node's subtree, subtrees are contiguous in this order
+	std::vector<unsigned>								mSubtreeEnds;
+
+	//Mapping between sorted order and Level_Data::levelTransforms indices
+	std::vector<unsigned>								mTransformIndices;
+	std::vector<unsigned>								mNodeOfTransform;
+
+	//Nodes whose local transform changed since the last update
+	std::vector<unsigned>								mDirtyNodes;
+	std::vector<char>									mDirtyFlags;
+	//Level transform indices whose world transform changed in the last update
+	std::vector<unsigned>								mChangedTransforms;
+
+public:
+
+	//Builds the hierarchy from the loaded level, every world transform is computed once
+	void Build(const Level_Data& level)
+	{
+		const unsigned count = static_cast<unsigned>(level.levelTransforms.size());
+		std::vector<int> parentTransforms(count, -1);
+		for (const auto& object : level.blenderObjects)
+		{
+			if (object.transformIndex < count && object.parentTransformIndex < static_cast<int>(count))
+				parentTransforms[object.transformIndex] = object.parentTransformIndex;
+		}
+
+		//Children of every transform, grouped with a counting sort
+		std::vector<unsigned> childStarts(count + 1, 0), children(count);
+		for (unsigned i = 0; i < count; i++)
+			if (parentTransforms[i] != -1)
+				childStarts[parentTransforms[i] + 1]++;
+		for (unsigned i = 0; i < count; i++)
+			childStarts[i + 1] += childStarts[i];
+		std::vector<unsigned> childFill(childStarts.begin(), childStarts.end() - 1);
+		for (unsigned i = 0; i < count; i++)
+			if (parentTransforms[i] != -1)
+				children[childFill[parentTransforms[i]]++] = i;
+
+		mTransformIndices.clear();
+		mTransformIndices.reserve(count);
+		mNodeOfTransform.assign(count, ~0u);
+		mParents.assign(count, -1);
+		mSubtreeEnds.assign(count, 0);
+
+		//Depth first walk from every root, pre-order keeps each subtree contiguous
+		std::vector<unsigned> stack;
+		for (unsigned root = 0; root < count; root++)
+		{
+			if (parentTransforms[root] != -1)
+				continue;
+			stack.push_back(root);
+			while (stack.empty() == false)
+			{
+				unsigned transform = stack.back();
+				stack.pop_back();
+				unsigned node = static_cast<unsigned>(mTransformIndices.size());
+				mNodeOfTransform[transform] = node;
+				mTransformIndices.push_back(transform);
+				if (parentTransforms[transform] != -1)
+					mParents[node] = static_cast<int>(mNodeOfTransform[parentTransforms[transform]]);
+				//push in reverse so children keep their level order
+				for (unsigned c = childStarts[transform + 1]; c > childStarts[transform]; c--)
+					stack.push_back(children[c - 1]);
+			}
+		}
+		//Anything unreachable from a root (a broken parent loop) is treated as a root
+		for (unsigned transform = 0; transform < count; transform++)
+		{
+			if (mNodeOfTransform[transform] == ~0u)
+			{
+				mNodeOfTransform[transform] = static_cast<unsigned>(mTransformIndices.size());
+				mTransformIndices.push_back(transform);
+			}
+		}
+
+		//Subtree ends, children always follow their parent so walk backwards
+		for (unsigned node = 0; node < count; node++)
+			mSubtreeEnds[node] = node + 1;
+		for (unsigned node = count; node-- > 0;)
+			if (mParents[node] != -1 && mSubtreeEnds[mParents[node]] < mSubtreeEnds[node])
+				mSubtreeEnds[mParents[node]] = mSubtreeEnds[node];
+
+		mLocalTransforms.resize(count);
+		mWorldTransforms.resize(count);
+		for (unsigned node = 0; node < count; node++)
+			mLocalTransforms[node] = level.levelTransforms[mTransformIndices[node]];
+
+		mDirtyFlags.assign(count, 0);
+		mDirtyNodes.clear();
+		mChangedTransforms.clear();
+		UpdateRange(0, count);
+	}
+
+	unsigned Size() const
+	{
+		return static_cast<unsigned>(mTransformIndices.size());
+	}
+
+	const GW::MATH::GMATRIXF& GetLocal(unsigned transformIndex) const
+	{
+		return mLocalTransforms[mNodeOfTransform[transformIndex]];
+	}
+
+	const GW::MATH::GMATRIXF& GetWorld(unsigned transformIndex) const
+	{
+		return mWorldTransforms[mNodeOfTransform[transformIndex]];
+	}
+
+	//Changes a local transform, the world transforms of its subtree update on the next UpdateWorldTransforms
+	void SetLocal(unsigned transformIndex, const GW::MATH::GMATRIXF& local)
+	{
+		unsigned node = mNodeOfTransform[transformIndex];
+		mLocalTransforms[node] = local;
+		if (mDirtyFlags[node] == 0)
+		{
+			mDirtyFlags[node] = 1;
+			mDirtyNodes.push_back(node);
+		}
+	}
+
+	//Recomputes only the subtrees below changed nodes, cost grows with what changed
+	void UpdateWorldTransforms()
+	{
+		mChangedTransforms.clear();
+		if (mDirtyNodes.empty())
+			return;
+		std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+		unsigned coveredEnd = 0;
+		for (unsigned node : mDirtyNodes)
+		{
+			mDirtyFlags[node] = 0;
+			//already recomputed as part of a dirty ancestor's subtree
+			if (node < coveredEnd)
+				continue;
+			UpdateRange(node, mSubtreeEnds[node]);
+			coveredEnd = mSubtreeEnds[node];
+		}
+		mDirtyNodes.clear();
+	}
+
+	//Level transform indices whose world transform changed during the last update
+	const std::vector<unsigned>& GetChangedTransforms() const
+	{
+		return mChangedTransforms;
+	}
+
+	//Scatters the world transforms changed by the last update into a level ordered array
+	void CopyChangedWorldTransforms(std::vector<GW::MATH::GMATRIXF>& levelOrderedOut) const
+	{
+		for (unsigned transform : mChangedTransforms)
+			levelOrderedOut[transform] = mWorldTransforms[mNodeOfTransform[transform]];
+	}
+
+	//Scatters every world transform into a level ordered array
+	void CopyWorldTransforms(std::vector<GW::MATH::GMATRIXF>& levelOrderedOut) const
+	{
+		levelOrderedOut.resize(mWorldTransforms.size());
+		for (unsigned node = 0; node < mWorldTransforms.size(); node++)
+			levelOrderedOut[mTransformIndices[node]] = mWorldTransforms[node];
+	}
+
+private:
+
+	//Parents precede children so one forward pass over a contiguous range settles any depth
+	void UpdateRange(unsigned begin, unsigned end)
+	{
+		for (unsigned node = begin; node < end; node++)
+		{
+			if (mParents[node] == -1)
+				mWorldTransforms[node] = mLocalTransforms[node];
+			else
+				SIMD_MATH::MultiplyMatrix(mLocalTransforms[node],
+					mWorldTransforms[mParents[node]], mWorldTransforms[node]);
+			mChangedTransforms.push_back(mTransformIndices[node]);
+		}
+	}
+};
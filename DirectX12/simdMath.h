@@ -0,0 +1,294 @@
+#pragma once
+// SSE/AVX versions of the GMatrix calls made every frame, with a scalar fallback.
+// Matrices are row major with row vectors (v * M) exactly like GW::MATH::GMatrix.
+// MultiplyMatrix matches GMatrix::MultiplyMatrixF bit for bit (same products, same summation order).
+// Define SIMD_MATH_SCALAR to force the scalar path.
+#if !defined(SIMD_MATH_SCALAR) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_MATH_SSE 1
+#include <immintrin.h>
+#endif
+#include <cmath>
+#include <cstddef>
+
+namespace SIMD_MATH
+{
+#if defined(SIMD_MATH_SSE)
+	// one output row: a.x * b0 + a.y * b1 + a.z * b2 + a.w * b3, summed left to right
+	inline __m128 CombineRow(__m128 a, __m128 b0, __m128 b1, __m128 b2, __m128 b3)
+	{
+		__m128 row = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		return row;
+	}
+#if defined(__AVX__)
+	// two output rows at once, each 128 bit half is one row
+	inline __m256 CombineRows(__m256 a, __m256 b0, __m256 b1, __m256 b2, __m256 b3)
+	{
+		__m256 rows = _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		return rows;
+	}
+#endif
+#endif
+
+	// out = a * b, out may alias a or b
+	inline void MultiplyMatrix(const GW::MATH::GMATRIXF& a, const GW::MATH::GMATRIXF& b, GW::MATH::GMATRIXF& out)
+	{
+#if defined(SIMD_MATH_SSE) && defined(__AVX__)
+		__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&b.data[0]));
+		__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&b.data[4]));
+		__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&b.data[8]));
+		__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&b.data[12]));
+		__m256 r01 = CombineRows(_mm256_loadu_ps(&a.data[0]), b0, b1, b2, b3);
+		__m256 r23 = CombineRows(_mm256_loadu_ps(&a.data[8]), b0, b1, b2, b3);
+		_mm256_storeu_ps(&out.data[0], r01);
+		_mm256_storeu_ps(&out.data[8], r23);
+#elif defined(SIMD_MATH_SSE)
+		__m128 b0 = _mm_loadu_ps(&b.data[0]);
+		__m128 b1 = _mm_loadu_ps(&b.data[4]);
+		__m128 b2 = _mm_loadu_ps(&b.data[8]);
+		__m128 b3 = _mm_loadu_ps(&b.data[12]);
+		__m128 r0 = CombineRow(_mm_loadu_ps(&a.data[0]), b0, b1, b2, b3);
+		__m128 r1 = CombineRow(_mm_loadu_ps(&a.data[4]), b0, b1, b2, b3);
+		__m128 r2 = CombineRow(_mm_loadu_ps(&a.data[8]), b0, b1, b2, b3);
+		__m128 r3 = CombineRow(_mm_loadu_ps(&a.data[12]), b0, b1, b2, b3);
+		_mm_storeu_ps(&out.data[0], r0);
+		_mm_storeu_ps(&out.data[4], r1);
+		_mm_storeu_ps(&out.data[8], r2);
+		_mm_storeu_ps(&out.data[12], r3);
+#else
+		GW::MATH::GMATRIXF result;
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				result.data[r * 4 + c] = a.data[r * 4] * b.data[c] + a.data[r * 4 + 1] * b.data[4 + c] +
+					a.data[r * 4 + 2] * b.data[8 + c] + a.data[r * 4 + 3] * b.data[12 + c];
+		out = result;
+#endif
+	}
+
+	// out[i] = a[i] * b[i] for count pairs
+	inline void MultiplyMatrices(const GW::MATH::GMATRIXF* a, const GW::MATH::GMATRIXF* b,
+		GW::MATH::GMATRIXF* out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			MultiplyMatrix(a[i], b[i], out[i]);
+	}
+
+	// out[i] = matrices[i] * transform for count matrices, transform is loaded once
+	inline void TransformMatrices(const GW::MATH::GMATRIXF* matrices, const GW::MATH::GMATRIXF& transform,
+		GW::MATH::GMATRIXF* out, size_t count)
+	{
+#if defined(SIMD_MATH_SSE)
+		__m128 b0 = _mm_loadu_ps(&transform.data[0]);
+		__m128 b1 = _mm_loadu_ps(&transform.data[4]);
+		__m128 b2 = _mm_loadu_ps(&transform.data[8]);
+		__m128 b3 = _mm_loadu_ps(&transform.data[12]);
+		for (size_t i = 0; i < count; ++i)
+		{
+			__m128 r0 = CombineRow(_mm_loadu_ps(&matrices[i].data[0]), b0, b1, b2, b3);
+			__m128 r1 = CombineRow(_mm_loadu_ps(&matrices[i].data[4]), b0, b1, b2, b3);
+			__m128 r2 = CombineRow(_mm_loadu_ps(&matrices[i].data[8]), b0, b1, b2, b3);
+			__m128 r3 = CombineRow(_mm_loadu_ps(&matrices[i].data[12]), b0, b1, b2, b3);
+			_mm_storeu_ps(&out[i].data[0], r0);
+			_mm_storeu_ps(&out[i].data[4], r1);
+			_mm_storeu_ps(&out[i].data[8], r2);
+			_mm_storeu_ps(&out[i].data[12], r3);
+		}
+#else
+		GW::MATH::GMATRIXF copy = transform; // transform may be one of the outputs
+		for (size_t i = 0; i < count; ++i)
+			MultiplyMatrix(matrices[i], copy, out[i]);
+#endif
+	}
+
+	// out = (v.x, v.y, v.z, 1) * m
+	inline void TransformPoint(const GW::MATH::GMATRIXF& m, const float* v, float* out)
+	{
+		float x = v[0], y = v[1], z = v[2];
+		for (int c = 0; c < 4; ++c)
+			out[c] = x * m.data[c] + y * m.data[4 + c] + z * m.data[8 + c] + m.data[12 + c];
+	}
+
+	// Inverse of an affine matrix (rotation/scale/shear + translation, last column 0,0,0,1).
+	// Cheaper than a general inverse, returns false if the matrix is singular.
+	inline bool AffineInverse(const GW::MATH::GMATRIXF& m, GW::MATH::GMATRIXF& out)
+	{
+#if defined(SIMD_MATH_SSE)
+		const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+		__m128 r0 = _mm_and_ps(_mm_loadu_ps(&m.data[0]), mask);
+		__m128 r1 = _mm_and_ps(_mm_loadu_ps(&m.data[4]), mask);
+		__m128 r2 = _mm_and_ps(_mm_loadu_ps(&m.data[8]), mask);
+		__m128 t = _mm_loadu_ps(&m.data[12]);
+		// columns of the adjugate are the cross products of the rows
+		auto cross = [](__m128 a, __m128 b) {
+			__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+			return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+		};
+		__m128 c0 = cross(r1, r2);
+		__m128 c1 = cross(r2, r0);
+		__m128 c2 = cross(r0, r1);
+		__m128 detV = _mm_mul_ps(r0, c0);
+		float det = _mm_cvtss_f32(detV) + _mm_cvtss_f32(_mm_shuffle_ps(detV, detV, 1)) +
+			_mm_cvtss_f32(_mm_shuffle_ps(detV, detV, 2));
+		if (std::fabs(det) < 1e-12f)
+			return false;
+		__m128 invDet = _mm_set1_ps(1.0f / det);
+		c0 = _mm_mul_ps(c0, invDet);
+		c1 = _mm_mul_ps(c1, invDet);
+		c2 = _mm_mul_ps(c2, invDet);
+		// inverse 3x3 has c0, c1, c2 as its columns, transpose them into rows
+		__m128 zero = _mm_setzero_ps();
+		__m128 lo01 = _mm_unpacklo_ps(c0, c1); // c0x c1x c0y c1y
+		__m128 hi01 = _mm_unpackhi_ps(c0, c1); // c0z c1z 0 0
+		__m128 lo2 = _mm_unpacklo_ps(c2, zero); // c2x 0 c2y 0
+		__m128 hi2 = _mm_unpackhi_ps(c2, zero); // c2z 0 0 0
+		__m128 i0 = _mm_movelh_ps(lo01, lo2);
+		__m128 i1 = _mm_movehl_ps(lo2, lo01);
+		__m128 i2 = _mm_movelh_ps(hi01, hi2);
+		// translation = -t * inverse3x3
+		__m128 it = _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)), i0);
+		it = _mm_add_ps(it, _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)), i1));
+		it = _mm_add_ps(it, _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2)), i2));
+		it = _mm_sub_ps(_mm_set_ps(1, 0, 0, 0), _mm_and_ps(it, mask));
+		_mm_storeu_ps(&out.data[0], i0);
+		_mm_storeu_ps(&out.data[4], i1);
+		_mm_storeu_ps(&out.data[8], i2);
+		_mm_storeu_ps(&out.data[12], it);
+		return true;
+#else
+		const float* a = m.data;
+		float c[9] = {
+			a[5] * a[10] - a[6] * a[9], a[2] * a[9] - a[1] * a[10], a[1] * a[6] - a[2] * a[5],
+			a[6] * a[8] - a[4] * a[10], a[0] * a[10] - a[2] * a[8], a[2] * a[4] - a[0] * a[6],
+			a[4] * a[9] - a[5] * a[8], a[1] * a[8] - a[0] * a[9], a[0] * a[5] - a[1] * a[4] };
+		float det = a[0] * c[0] + a[1] * c[3] + a[2] * c[6];
+		if (std::fabs(det) < 1e-12f)
+			return false;
+		float invDet = 1.0f / det;
+		GW::MATH::GMATRIXF result = GW::MATH::GIdentityMatrixF;
+		for (int r = 0; r < 3; ++r)
+			for (int col = 0; col < 3; ++col)
+				result.data[r * 4 + col] = c[r * 3 + col] * invDet;
+		for (int col = 0; col < 3; ++col)
+			result.data[12 + col] = -(a[12] * result.data[col] + a[13] * result.data[4 + col] + a[14] * result.data[8 + col]);
+		out = result;
+		return true;
+#endif
+	}
+
+	// Frustum planes (left, right, bottom, top, near, far) of a D3D style (0 <= z <= w) view projection.
+	// Each plane is (nx, ny, nz, d) normalized, a point p is inside when dot(n, p) + d >= 0.
+	inline void ExtractFrustumPlanes(const GW::MATH::GMATRIXF& viewProjection, GW::MATH::GVECTORF outPlanes[6])
+	{
+		const float* m = viewProjection.data;
+		// column k of a row vector matrix produces clip component k, plane = w + sign * k
+		auto combine = [m](int k, float sign, GW::MATH::GVECTORF& plane) {
+			plane.x = m[3] + sign * m[k];
+			plane.y = m[7] + sign * m[4 + k];
+			plane.z = m[11] + sign * m[8 + k];
+			plane.w = m[15] + sign * m[12 + k];
+		};
+		combine(0, 1.0f, outPlanes[0]);
+		combine(0, -1.0f, outPlanes[1]);
+		combine(1, 1.0f, outPlanes[2]);
+		combine(1, -1.0f, outPlanes[3]);
+		outPlanes[4].x = m[2]; outPlanes[4].y = m[6]; outPlanes[4].z = m[10]; outPlanes[4].w = m[14]; // z >= 0
+		combine(2, -1.0f, outPlanes[5]);
+		for (int p = 0; p < 6; ++p)
+		{
+			float length = std::sqrt(outPlanes[p].x * outPlanes[p].x +
+				outPlanes[p].y * outPlanes[p].y + outPlanes[p].z * outPlanes[p].z);
+			if (length > 0)
+			{
+				float inv = 1.0f / length;
+				outPlanes[p].x *= inv; outPlanes[p].y *= inv; outPlanes[p].z *= inv; outPlanes[p].w *= inv;
+			}
+		}
+	}
+
+	// Point (x, y, z) number i of an array whose points are stride bytes apart, indices picks which ones when not null.
+	inline const float* PointAt(const float* points, size_t stride, const unsigned* indices, size_t i)
+	{
+		size_t point = indices != nullptr ? indices[i] : i;
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(points) + stride * point);
+	}
+
+	// Min/max reduction over count points (see PointAt), outputs zero when count is 0.
+	// The SSE path loads 4 floats per point, so a readable float must follow every z (true for H2B vertices).
+	inline void PointBounds(const float* points, size_t stride, const unsigned* indices, size_t count,
+		float outMin[3], float outMax[3])
+	{
+		if (count == 0)
+		{
+			outMin[0] = outMin[1] = outMin[2] = outMax[0] = outMax[1] = outMax[2] = 0;
+			return;
+		}
+#if defined(SIMD_MATH_SSE)
+		__m128 lo = _mm_loadu_ps(PointAt(points, stride, indices, 0)), hi = lo;
+		for (size_t i = 1; i < count; ++i)
+		{
+			__m128 p = _mm_loadu_ps(PointAt(points, stride, indices, i));
+			lo = _mm_min_ps(lo, p);
+			hi = _mm_max_ps(hi, p);
+		}
+		alignas(16) float l[4], h[4];
+		_mm_store_ps(l, lo);
+		_mm_store_ps(h, hi);
+		for (int c = 0; c < 3; ++c)
+		{
+			outMin[c] = l[c];
+			outMax[c] = h[c];
+		}
+#else
+		const float* first = PointAt(points, stride, indices, 0);
+		for (int c = 0; c < 3; ++c)
+			outMin[c] = outMax[c] = first[c];
+		for (size_t i = 1; i < count; ++i)
+		{
+			const float* p = PointAt(points, stride, indices, i);
+			for (int c = 0; c < 3; ++c)
+			{
+				outMin[c] = p[c] < outMin[c] ? p[c] : outMin[c];
+				outMax[c] = p[c] > outMax[c] ? p[c] : outMax[c];
+			}
+		}
+#endif
+	}
+
+	// Largest squared distance from center to any of count points (see PointBounds for the SSE load rule).
+	inline float MaxDistanceSquared(const float* points, size_t stride, const unsigned* indices, size_t count,
+		const float center[3])
+	{
+		float result = 0;
+#if defined(SIMD_MATH_SSE)
+		const __m128 c = _mm_setr_ps(center[0], center[1], center[2], 0);
+		const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128 best = _mm_setzero_ps();
+		for (size_t i = 0; i < count; ++i)
+		{
+			__m128 d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(PointAt(points, stride, indices, i)), c), xyz);
+			d = _mm_mul_ps(d, d);
+			// horizontal x + y + z, w is masked to zero
+			d = _mm_add_ps(d, _mm_movehl_ps(d, d));
+			d = _mm_add_ss(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1)));
+			best = _mm_max_ss(best, d);
+		}
+		result = _mm_cvtss_f32(best);
+#else
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float* p = PointAt(points, stride, indices, i);
+			float x = p[0] - center[0], y = p[1] - center[1], z = p[2] - center[2];
+			float d = x * x + y * y + z * z;
+			result = d > result ? d : result;
+		}
+#endif
+		return result;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+
+//Per frame in flight copies of the level transforms, only indices marked dirty are copied into them
+//Every copy keeps its own dirty set so a change reaches each frame's buffer the next time that frame is recorded
+class Transform_Uploader
+{
+	Render_Device*											mDevice = nullptr;
+	//One buffer per frame in flight
+	std::vector<RENDER_BUFFER>								mBuffers;
+	//One bit per transform, per frame in flight
+	std::vector<std::vector<uint64_t>>						mDirtyBits;
+	unsigned												mTransformCount = 0;
+	//Clean transforms between two dirty ranges that are uploaded anyway to make one write of them
+	unsigned												mMergeGap = 4;
+	unsigned												mBytesUploaded = 0;
+	unsigned												mRangesUploaded = 0;
+
+public:
+
+	~Transform_Uploader()
+	{
+		Release();
+	}
+
+	//Creates the per frame buffers already holding transforms, nothing starts dirty
+	void Create(Render_Device& device, const std::vector<GW::MATH::GMATRIXF>& transforms)
+	{
+		Release();
+		mDevice = &device;
+		mTransformCount = static_cast<unsigned>(transforms.size());
+		mBuffers.resize(device.GetFrameCount());
+		mDirtyBits.assign(device.GetFrameCount(), std::vector<uint64_t>((mTransformCount + 63) / 64, 0));
+		for (RENDER_BUFFER& buffer : mBuffers)
+			buffer = device.CreateBuffer({ RENDER_BUFFER_TYPE::STRUCTURED,
+				static_cast<unsigned>(sizeof(GW::MATH::GMATRIXF) * transforms.size()), sizeof(GW::MATH::GMATRIXF), RENDER_BUFFER_USAGE::DYNAMIC },
+				transforms.data());
+	}
+
+	void Release()
+	{
+		for (RENDER_BUFFER buffer : mBuffers)
+			mDevice->ReleaseBuffer(buffer);
+		mBuffers.clear();
+		mDirtyBits.clear();
+		mTransformCount = 0;
+	}
+
+	void MarkDirty(unsigned transformIndex)
+	{
+		for (std::vector<uint64_t>& bits : mDirtyBits)
+			bits[transformIndex >> 6] |= uint64_t(1) << (transformIndex & 63);
+	}
+
+	void MarkDirty(const std::vector<unsigned>& transformIndices)
+	{
+		for (unsigned transform : transformIndices)
+			MarkDirty(transform);
+	}
+
+	void MarkAllDirty()
+	{
+		for (std::vector<uint64_t>& bits : mDirtyBits)
+			for (uint64_t& word : bits)
+				word = ~uint64_t(0);
+		//Bits past the last transform are never uploaded, keep them clear
+		if (mTransformCount & 63)
+			for (std::vector<uint64_t>& bits : mDirtyBits)
+				bits.back() = (uint64_t(1) << (mTransformCount & 63)) - 1;
+	}
+
+	//Brings frameIndex's buffer up to date with transforms, dirty indices are coalesced into ranges first
+	void Upload(unsigned frameIndex, const std::vector<GW::MATH::GMATRIXF>& transforms)
+	{
+		mBytesUploaded = mRangesUploaded = 0;
+		std::vector<uint64_t>& bits = mDirtyBits[frameIndex];
+		unsigned rangeStart = 0, rangeEnd = 0;
+		bool open = false;
+		for (unsigned word = 0; word < bits.size(); word++)
+		{
+			uint64_t dirty = bits[word];
+			bits[word] = 0;
+			while (dirty != 0)
+			{
+				unsigned transform = word * 64 + LowestBit(dirty);
+				dirty &= dirty - 1;
+				if (open && transform <= rangeEnd + mMergeGap)
+				{
+					rangeEnd = transform + 1;
+					continue;
+				}
+				if (open)
+					WriteRange(frameIndex, transforms, rangeStart, rangeEnd);
+				rangeStart = transform;
+				rangeEnd = transform + 1;
+				open = true;
+			}
+		}
+		if (open)
+			WriteRange(frameIndex, transforms, rangeStart, rangeEnd);
+	}
+
+	void SetMergeGap(unsigned gap) { mMergeGap = gap; }
+	RENDER_BUFFER GetBuffer(unsigned frameIndex) const { return mBuffers[frameIndex]; }
+	//What the last Upload wrote
+	unsigned GetBytesUploaded() const { return mBytesUploaded; }
+	unsigned GetRangesUploaded() const { return mRangesUploaded; }
+
+private:
+
+	void WriteRange(unsigned frameIndex, const std::vector<GW::MATH::GMATRIXF>& transforms, unsigned begin, unsigned end)
+	{
+		unsigned sizeInBytes = static_cast<unsigned>(sizeof(GW::MATH::GMATRIXF)) * (end - begin);
+		mDevice->WriteBuffer(mBuffers[frameIndex], static_cast<unsigned>(sizeof(GW::MATH::GMATRIXF)) * begin,
+			&transforms[begin], sizeInBytes);
+		mBytesUploaded += sizeInBytes;
+		mRangesUploaded++;
+	}
+
+	//bits is never 0
+	static unsigned LowestBit(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+	}
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+//Handle to staging memory owned by a Copy_Queue, 0 is never valid
+typedef unsigned COPY_STAGING;
+
+//What the batcher needs from a copy queue, implemented over a D3D12 COPY queue or faked headless
+class Copy_Queue
+{
+public:
+	virtual ~Copy_Queue() {}
+
+	//CPU writable memory copies can read from, stays mapped until released
+	virtual COPY_STAGING CreateStaging(unsigned sizeInBytes, void*& outCpuAddress) = 0;
+	virtual void ReleaseStaging(COPY_STAGING staging) = 0;
+	virtual void CopyBuffer(RENDER_BUFFER destination, unsigned destinationOffset,
+		COPY_STAGING source, unsigned sourceOffset, unsigned sizeInBytes) = 0;
+	//Called once per destination after its last copy of the batch, hands it back in a state the direct queue can read
+	virtual void FinishBuffer(RENDER_BUFFER destination) = 0;
+	//Executes everything recorded since the last submit and returns the fence value signalled once it is done
+	virtual uint64_t Submit() = 0;
+	virtual Upload_Fence& GetFence() = 0;
+};
+
+//Stages writes to GPU only buffers and copies them over on a copy queue in batches
+//Staging memory of a batch is released once the copy fence passes the value its submit returned
+class Upload_Batcher
+{
+	//One staging allocation, filled front to back
+	struct STAGING
+	{
+		COPY_STAGING handle;
+		char* memory;
+		unsigned capacity, used;
+		uint64_t fenceValue;
+	};
+
+public:
+	//Totals since Create
+	struct UPLOAD_BATCH_STATS
+	{
+		unsigned long long bytesStaged;
+		unsigned copies, batches, stagingCreated, stagingReleased;
+	};
+
+private:
+	Copy_Queue*												mQueue = nullptr;
+	//Writes are packed into staging blocks of this size, bigger writes are split across blocks
+	unsigned												mBlockSize = 0;
+	//Blocks of the batch being built, only the last one has room left
+	std::vector<STAGING>									mOpen;
+	//Submitted blocks in submit order, waiting for their fence value
+	std::deque<STAGING>										mRetired;
+	//Every buffer the open batch copies into, once each
+	std::vector<RENDER_BUFFER>								mDestinations;
+	uint64_t												mLastSubmitted = 0;
+	UPLOAD_BATCH_STATS										mStats = {};
+
+public:
+
+	~Upload_Batcher()
+	{
+		WaitIdle();
+	}
+
+	void Create(Copy_Queue& queue, unsigned blockSize = 4 * 1024 * 1024)
+	{
+		WaitIdle();
+		mQueue = &queue;
+		mBlockSize = blockSize;
+		mStats = {};
+	}
+
+	//Copies data into staging now, the GPU buffer receives it with the next Flush
+	void Enqueue(RENDER_BUFFER destination, unsigned destinationOffset, const void* data, unsigned sizeInBytes)
+	{
+		const char* source = static_cast<const char*>(data);
+		while (sizeInBytes > 0)
+		{
+			if (mOpen.empty() || mOpen.back().used == mOpen.back().capacity)
+				OpenBlock();
+			STAGING& block = mOpen.back();
+			unsigned chunk = block.capacity - block.used;
+			if (chunk > sizeInBytes)
+				chunk = sizeInBytes;
+			std::memcpy(block.memory + block.used, source, chunk);
+			mQueue->CopyBuffer(destination, destinationOffset, block.handle, block.used, chunk);
+			block.used += chunk;
+			source += chunk;
+			destinationOffset += chunk;
+			sizeInBytes -= chunk;
+			mStats.bytesStaged += chunk;
+			mStats.copies++;
+		}
+		if (std::find(mDestinations.begin(), mDestinations.end(), destination) == mDestinations.end())
+			mDestinations.push_back(destination);
+	}
+
+	//Submits the open batch, returns the fence value the direct queue has to wait for before reading any copied buffer
+	uint64_t Flush()
+	{
+		Reclaim();
+		if (mOpen.empty())
+			return mLastSubmitted;
+		for (RENDER_BUFFER destination : mDestinations)
+			mQueue->FinishBuffer(destination);
+		mDestinations.clear();
+		mLastSubmitted = mQueue->Submit();
+		for (STAGING& block : mOpen)
+		{
+			block.fenceValue = mLastSubmitted;
+			mRetired.push_back(block);
+		}
+		mOpen.clear();
+		mStats.batches++;
+		return mLastSubmitted;
+	}
+
+	//Releases the staging of every batch the copy queue has finished
+	void Reclaim()
+	{
+		if (mQueue == nullptr)
+			return;
+		uint64_t completed = mQueue->GetFence().GetCompletedValue();
+		while (mRetired.empty() == false && mRetired.front().fenceValue <= completed)
+		{
+			mQueue->ReleaseStaging(mRetired.front().handle);
+			mRetired.pop_front();
+			mStats.stagingReleased++;
+		}
+	}
+
+	//Submits and blocks until every copy so far has landed
+	void WaitIdle()
+	{
+		if (mQueue == nullptr)
+			return;
+		Flush();
+		mQueue->GetFence().WaitFor(mLastSubmitted);
+		Reclaim();
+	}
+
+	uint64_t GetLastSubmitted() const { return mLastSubmitted; }
+	//Copies recorded but not yet submitted
+	bool HasPendingCopies() const { return mOpen.empty() == false; }
+	//Staging blocks alive, open or waiting on the fence
+	unsigned GetStagingCount() const { return static_cast<unsigned>(mOpen.size() + mRetired.size()); }
+	const UPLOAD_BATCH_STATS& GetStats() const { return mStats; }
+
+private:
+
+	void OpenBlock()
+	{
+		STAGING block = {};
+		void* memory = nullptr;
+		block.capacity = mBlockSize;
+		block.handle = mQueue->CreateStaging(mBlockSize, memory);
+		block.memory = static_cast<char*>(memory);
+		mOpen.push_back(block);
+		mStats.stagingCreated++;
+	}
+};
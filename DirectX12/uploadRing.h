@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+//Tells the CPU how far the GPU has got, implemented over an ID3D12Fence or faked headless
+class Upload_Fence
+{
+public:
+	virtual ~Upload_Fence() {}
+
+	//Highest value the GPU has signalled, every frame tagged at or below it is finished
+	virtual uint64_t GetCompletedValue() const = 0;
+	//Blocks until the GPU signals value
+	virtual void WaitFor(uint64_t value) = 0;
+};
+
+//Linear allocator over one persistently mapped upload buffer, wraps around like a ring
+//Space is handed back a whole frame at a time once the fence passes the value the frame was tagged with
+class Upload_Ring
+{
+	//The end of the space a finished frame used and the fence value that frees it
+	struct RING_FRAME
+	{
+		uint64_t fenceValue;
+		uint64_t end;
+	};
+
+	Upload_Fence*											mFence = nullptr;
+	uint64_t												mCapacity = 0;
+	//Monotonic positions, the offset into the buffer is position % capacity
+	uint64_t												mHead = 0;
+	uint64_t												mTail = 0;
+	std::deque<RING_FRAME>									mFrames;
+	unsigned												mStalls = 0;
+
+public:
+
+	void Create(uint64_t capacity, Upload_Fence& fence)
+	{
+		mFence = &fence;
+		mCapacity = capacity;
+		mHead = mTail = 0;
+		mFrames.clear();
+		mStalls = 0;
+	}
+
+	//Offset of sizeInBytes free bytes aligned to alignment (a power of two)
+	//Waits on the fence when the ring is full of frames the GPU is still reading, false if it still does not fit
+	bool Allocate(uint64_t sizeInBytes, uint64_t alignment, uint64_t& outOffset)
+	{
+		if (sizeInBytes > mCapacity)
+			return false;
+		Reclaim();
+		while (true)
+		{
+			//Alignment applies to the offset in the buffer, allocations never straddle its end and restart at 0 instead
+			uint64_t offset = mHead % mCapacity;
+			uint64_t alignedOffset = AlignUp(offset, alignment);
+			uint64_t start = alignedOffset + sizeInBytes <= mCapacity ?
+				mHead + (alignedOffset - offset) : mHead + (mCapacity - offset);
+			if (start + sizeInBytes - mTail <= mCapacity)
+			{
+				mHead = start + sizeInBytes;
+				outOffset = start % mCapacity;
+				return true;
+			}
+			if (mFrames.empty())
+				return false; // the frame being recorded alone fills the ring
+			mStalls++;
+			mFence->WaitFor(mFrames.front().fenceValue);
+			Reclaim();
+		}
+	}
+
+	//Everything allocated since the last call is freed once the fence reaches fenceValue
+	void FinishFrame(uint64_t fenceValue)
+	{
+		uint64_t frameStart = mFrames.empty() ? mTail : mFrames.back().end;
+		if (mHead != frameStart)
+			mFrames.push_back({ fenceValue, mHead });
+	}
+
+	//Frees the space of every frame the GPU has finished
+	void Reclaim()
+	{
+		uint64_t completed = mFence->GetCompletedValue();
+		while (mFrames.empty() == false && mFrames.front().fenceValue <= completed)
+		{
+			mTail = mFrames.front().end;
+			mFrames.pop_front();
+		}
+	}
+
+	uint64_t GetCapacity() const { return mCapacity; }
+	//Bytes allocated that the GPU may still read
+	uint64_t GetUsed() const { return mHead - mTail; }
+	//Times Allocate had to wait for the GPU
+	unsigned GetStallCount() const { return mStalls; }
+
+private:
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//16 byte vertex decoded by VertexShader.hlsl when COMPRESSED_VERTICES is defined
+struct COMPRESSED_VERTEX
+{
+	//R16G16B16A16_UNORM, position inside the model's bounds, w is unused
+	uint16_t position[4];
+	//R16G16_SNORM, octahedral unit normal
+	int16_t normal[2];
+	//R16G16_FLOAT, the w of the H2B uvw is dropped
+	uint16_t uv[2];
+};
+static_assert(sizeof(COMPRESSED_VERTEX) == 16, "COMPRESSED_VERTEX must match the compressed input layout");
+
+//Per model dequantization, position = boundsMin + unorm * boundsExtent, float4s to match the HLSL struct
+struct VERTEX_QUANTIZATION
+{
+	GW::MATH::GVECTORF boundsMin;
+	GW::MATH::GVECTORF boundsExtent;
+};
+
+//Builds the compressed copy of a model's vertices, same order and count so indices and base vertices still apply
+//Level_Data compresses every model while importing and cooks the stream, a mapped level hands it to the GPU in place
+class Vertex_Compressor
+{
+public:
+	//Worst decode error over every vertex of one model
+	struct MODEL_VERTEX_ERROR
+	{
+		//Model space units and the same relative to the model's bounds diagonal
+		float maxPositionError, relativePositionError;
+		float maxNormalDegrees;
+		float maxUVError;
+	};
+
+	//Appends one model's compressed vertices, returns how the shader dequantizes them
+	static VERTEX_QUANTIZATION AddModel(const H2B::VERTEX* vertices, unsigned vertexCount, std::vector<COMPRESSED_VERTEX>& compressed)
+	{
+		VERTEX_QUANTIZATION quantization;
+		//The model's own range, not just the vertices its indices reach
+		float low[3] = { 0, 0, 0 }, high[3] = { 0, 0, 0 };
+		if (vertexCount > 0)
+			SIMD_MATH::PointBounds(&vertices[0].pos.x, sizeof(H2B::VERTEX), nullptr, vertexCount, low, high);
+		quantization.boundsMin = { low[0], low[1], low[2], 0 };
+		quantization.boundsExtent = { high[0] - low[0], high[1] - low[1], high[2] - low[2], 0 };
+
+		for (unsigned v = 0; v < vertexCount; v++)
+		{
+			const H2B::VERTEX& vertex = vertices[v];
+			COMPRESSED_VERTEX packed;
+			packed.position[0] = QuantizeUnorm(vertex.pos.x, low[0], quantization.boundsExtent.x);
+			packed.position[1] = QuantizeUnorm(vertex.pos.y, low[1], quantization.boundsExtent.y);
+			packed.position[2] = QuantizeUnorm(vertex.pos.z, low[2], quantization.boundsExtent.z);
+			packed.position[3] = 0;
+			EncodeOctahedral(vertex.nrm, packed.normal);
+			packed.uv[0] = FloatToHalf(vertex.uvw.x);
+			packed.uv[1] = FloatToHalf(vertex.uvw.y);
+			compressed.push_back(packed);
+		}
+		return quantization;
+	}
+
+	//Decodes every vertex of one model the way the shader does and compares it with the source
+	static MODEL_VERTEX_ERROR MeasureModelError(const H2B::VERTEX* vertices, const COMPRESSED_VERTEX* compressed, unsigned vertexCount,
+		const VERTEX_QUANTIZATION& quantization)
+	{
+		MODEL_VERTEX_ERROR error = {};
+		for (unsigned v = 0; v < vertexCount; v++)
+		{
+			const H2B::VERTEX& vertex = vertices[v];
+			const COMPRESSED_VERTEX& packed = compressed[v];
+
+			float position[3];
+			for (unsigned c = 0; c < 3; c++)
+				position[c] = (&quantization.boundsMin.x)[c] + packed.position[c] / 65535.0f * (&quantization.boundsExtent.x)[c];
+			float dx = position[0] - vertex.pos.x, dy = position[1] - vertex.pos.y, dz = position[2] - vertex.pos.z;
+			error.maxPositionError = std::fmax(error.maxPositionError, std::sqrt(dx * dx + dy * dy + dz * dz));
+
+			float sourceLength = std::sqrt(vertex.nrm.x * vertex.nrm.x + vertex.nrm.y * vertex.nrm.y + vertex.nrm.z * vertex.nrm.z);
+			if (sourceLength > 0)
+			{
+				H2B::VECTOR normal = DecodeOctahedral(packed.normal);
+				float cosine = (normal.x * vertex.nrm.x + normal.y * vertex.nrm.y + normal.z * vertex.nrm.z) / sourceLength;
+				cosine = std::fmin(std::fmax(cosine, -1.0f), 1.0f);
+				error.maxNormalDegrees = std::fmax(error.maxNormalDegrees, std::acos(cosine) * 57.29578f);
+			}
+
+			error.maxUVError = std::fmax(error.maxUVError, std::fabs(HalfToFloat(packed.uv[0]) - vertex.uvw.x));
+			error.maxUVError = std::fmax(error.maxUVError, std::fabs(HalfToFloat(packed.uv[1]) - vertex.uvw.y));
+		}
+		const GW::MATH::GVECTORF& extent = quantization.boundsExtent;
+		float diagonal = std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+		error.relativePositionError = diagonal > 0 ? error.maxPositionError / diagonal : 0;
+		return error;
+	}
+
+	static uint16_t QuantizeUnorm(float value, float low, float extent)
+	{
+		if (!(extent > 0))
+			return 0;
+		float unorm = (value - low) / extent;
+		unorm = std::fmin(std::fmax(unorm, 0.0f), 1.0f);
+		return static_cast<uint16_t>(unorm * 65535.0f + 0.5f);
+	}
+
+	//Projects the normal onto an octahedron and unfolds the lower half over the corners
+	static void EncodeOctahedral(const H2B::VECTOR& normal, int16_t out[2])
+	{
+		float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+		if (!(length > 0))
+		{
+			out[0] = out[1] = 0;
+			return;
+		}
+		float x = normal.x / length, y = normal.y / length;
+		if (normal.z < 0)
+		{
+			float foldedX = (1 - std::fabs(y)) * (x >= 0 ? 1.0f : -1.0f);
+			float foldedY = (1 - std::fabs(x)) * (y >= 0 ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+		out[0] = static_cast<int16_t>(std::lround(std::fmin(std::fmax(x, -1.0f), 1.0f) * 32767.0f));
+		out[1] = static_cast<int16_t>(std::lround(std::fmin(std::fmax(y, -1.0f), 1.0f) * 32767.0f));
+	}
+
+	//Same math as DecodeOctahedral in VertexShader.hlsl
+	static H2B::VECTOR DecodeOctahedral(const int16_t encoded[2])
+	{
+		float x = std::fmax(encoded[0] / 32767.0f, -1.0f), y = std::fmax(encoded[1] / 32767.0f, -1.0f);
+		float z = 1 - std::fabs(x) - std::fabs(y);
+		float fold = std::fmax(-z, 0.0f);
+		x += x >= 0 ? -fold : fold;
+		y += y >= 0 ? -fold : fold;
+		float length = std::sqrt(x * x + y * y + z * z);
+		return { x / length, y / length, z / length };
+	}
+
+	//Round to nearest even, out of range values become infinity
+	static uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+		if (magnitude >= 0x7F800000) // inf or nan
+			return static_cast<uint16_t>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+		if (magnitude >= 0x477FF000) // rounds past the largest half
+			return static_cast<uint16_t>(sign | 0x7C00);
+		if (magnitude < 0x38800000) // half subnormal or zero
+		{
+			if (magnitude < 0x33000000)
+				return static_cast<uint16_t>(sign);
+			uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+			unsigned shift = 126 - (magnitude >> 23);
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				half++;
+			return static_cast<uint16_t>(sign | half);
+		}
+		uint32_t half = ((magnitude - 0x38000000) >> 13);
+		uint32_t rest = magnitude & 0x1FFF;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	static float HalfToFloat(uint16_t half)
+	{
+		uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FF;
+		uint32_t bits;
+		if (exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else if (exponent != 0)
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			bits = sign;
+		else
+		{
+			//Subnormal half, normalize it for the float
+			exponent = 113;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};